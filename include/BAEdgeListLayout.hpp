@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @brief Arithmetic description of the Barabasi-Albert edge list
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+/**
+ * @brief Arithmetic description of the Barabasi-Albert edge list
+ *
+ * The edge list starts with a seed circle of seed_vertices vertices and edges
+ * (as produced by InitialCircle). Then, the random vertex v (counting from 0)
+ * occupies the positions [firstRandomIdx() + 2*epv*v, firstRandomIdx() + 2*epv*(v+1)):
+ * each even position holds the new vertex itself, each odd position a neighbor
+ * sampled by preferential attachment.
+ *
+ * All positions of the seed circle and all even positions after it are hence
+ * determined by their index alone; we call them implicit.
+ */
+class BAEdgeListLayout {
+protected:
+   uint64_t _seed_vertices;
+   uint64_t _edges_per_vertex;
+
+public:
+   BAEdgeListLayout(uint64_t seed_vertices, uint64_t edges_per_vertex)
+      : _seed_vertices(seed_vertices)
+      , _edges_per_vertex(edges_per_vertex)
+   {}
+
+   uint64_t seedVertices() const {return _seed_vertices;}
+   uint64_t edgesPerVertex() const {return _edges_per_vertex;}
+
+   //! Position of the first token following the seed circle
+   uint64_t firstRandomIdx() const {
+      return 2 * _seed_vertices;
+   }
+
+   //! Position of the first token of random vertex @p v (counting from 0)
+   uint64_t firstIdxOfRandomVertex(uint64_t v) const {
+      return firstRandomIdx() + 2 * _edges_per_vertex * v;
+   }
+
+   //! True if the vertex at position @p idx is determined by the index
+   bool implicit(uint64_t idx) const {
+      return idx < firstRandomIdx() || !(idx & 1);
+   }
+
+   //! Vertex id at an implicit position @p idx
+   uint64_t vertex(uint64_t idx) const {
+      assert(implicit(idx));
+
+      if (idx < firstRandomIdx()) {
+         // the last edge of the circle points back to the first vertex
+         return (idx + 1 == firstRandomIdx()) ? 0 : (idx + 1) / 2;
+      }
+
+      return _seed_vertices + (idx - firstRandomIdx()) / (2 * _edges_per_vertex);
+   }
+};
@@ -0,0 +1,287 @@
+/**
+ * @file
+ * @brief Token sorter partitioned into id ranges that are sorted in the background
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <stxxl/bits/common/utils.h>
+
+#include <MemoryPool.hpp>
+
+/**
+ * @brief Drop-in replacement of a token sorter that overlaps sorting with consumption
+ *
+ * The id range [first_id, end_id) is split into buckets, each with its own
+ * sorter (stxxl::sorter or CompressedTokenSorter) and an equal share of the
+ * memory. As all tokens of one id fall into the same bucket, the concatenation
+ * of the sorted buckets is the globally sorted sequence. The buckets are either
+ * equally wide or bounded by the ids given, e.g. by queryBoundaries() such that
+ * they receive the same expected number of BA queries; as these concentrate on
+ * small ids, equally wide buckets would make the first bucket the largest one.
+ *
+ * sort() returns as soon as the first bucket is sorted; the remaining ones
+ * are sorted one after another by a background thread while the consumer
+ * reads the earlier ones. Hence, TFP only waits for the sort of the first
+ * bucket instead of all tokens. A bucket is released once it was read.
+ *
+ * With a single bucket, sorting happens synchronously as with the plain sorter.
+ * As the buckets sorted in the background keep their run buffers until then,
+ * memoryAfterSort() bounds the memory held while the buckets are read.
+ */
+template <class Sorter>
+class BucketedTokenSorter {
+public:
+   using value_type = typename Sorter::value_type;
+
+protected:
+   const std::vector<uint64_t> _boundaries; //!< bucket i covers [_boundaries[i], _boundaries[i+1])
+   std::vector<std::unique_ptr<Sorter>> _buckets;
+   std::vector<uint64_t> _bucket_sizes;
+   uint64_t _run_memory;         //!< per bucket
+   uint64_t _merge_memory;       //!< per bucket
+
+   std::thread _sorting_thread;
+   std::mutex _mutex;
+   std::condition_variable _sorted_cv;
+   size_t _sorted;               //!< number of buckets sorted; guarded by _mutex
+   std::exception_ptr _error;    //!< guarded by _mutex
+
+   size_t _current;              //!< bucket read by the consumer
+   Sorter * _stream;             //!< == _buckets[_current].get() while not empty
+   uint64_t _size;
+   bool _empty;
+
+   size_t _bucketOf(uint64_t id) const {
+      assert(id >= _boundaries.front());
+      return std::upper_bound(_boundaries.begin() + 1, _boundaries.end() - 1, id) - _boundaries.begin() - 1;
+   }
+
+   static std::vector<uint64_t> _equalBoundaries(uint64_t first_id, uint64_t end_id, unsigned int buckets) {
+      assert(buckets > 0);
+      assert(end_id >= first_id);
+
+      const uint64_t width = std::max<uint64_t>(1, (end_id - first_id + buckets - 1) / buckets);
+      std::vector<uint64_t> boundaries;
+      for(unsigned int i = 0; i < buckets; i++)
+         boundaries.push_back(std::min(end_id, first_id + i * width));
+      boundaries.push_back(end_id);
+      return boundaries;
+   }
+
+   void _sortAll() {
+      for(size_t i = 1; i < _buckets.size(); i++) {
+         try {
+            _buckets[i]->sort();
+         } catch (...) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _error = std::current_exception();
+            _sorted_cv.notify_all();
+            return;
+         }
+
+         std::lock_guard<std::mutex> lock(_mutex);
+         _sorted = i + 1;
+         _sorted_cv.notify_all();
+      }
+   }
+
+   void _waitSorted(size_t bucket) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _sorted_cv.wait(lock, [&] {return _sorted > bucket || _error;});
+      if (_sorted <= bucket)
+         std::rethrow_exception(_error);
+   }
+
+   //! Release exhausted buckets and move to the next non-empty one
+   void _advance() {
+      for(; _current < _buckets.size(); _current++) {
+         _waitSorted(_current);
+         if (!_buckets[_current]->empty()) {
+            _stream = _buckets[_current].get();
+            return;
+         }
+         _buckets[_current].reset();
+      }
+
+      _stream = nullptr;
+      _empty = true;
+      if (_sorting_thread.joinable())
+         _sorting_thread.join();
+   }
+
+public:
+   /**
+    * Boundaries splitting [first_id, end_id) into @p buckets ranges of the same expected
+    * number of BA queries, if these are issued by positions q uniformly spread over
+    * [source_begin, source_end) and each targets an id uniformly drawn from [0, q).
+    * The density of queries at id x then is ln(source_end / max(x, source_begin)).
+    */
+   static std::vector<uint64_t> queryBoundaries(uint64_t first_id, uint64_t end_id, unsigned int buckets,
+                                                uint64_t source_begin, uint64_t source_end)
+   {
+      const long double a = std::max<uint64_t>(1, source_begin);
+      const long double S = source_end;
+      if (buckets < 2 || S <= a || end_id <= first_id)
+         return _equalBoundaries(first_id, end_id, buckets);
+
+      // expected number of queries in [0, x) up to a constant factor
+      auto mass = [&] (long double x) -> long double {
+         return (x <= a) ? x * std::log(S / a) : x * (1 + std::log(S / std::min(x, S))) - a;
+      };
+
+      const long double first_mass = mass(first_id);
+      const long double total_mass = mass(end_id) - first_mass;
+
+      std::vector<uint64_t> boundaries(1, first_id);
+      for(unsigned int i = 1; i < buckets; i++) {
+         // smallest id whose prefix holds the share of the first i buckets
+         const long double target = first_mass + total_mass * i / buckets;
+         uint64_t lo = boundaries.back(), hi = end_id;
+         while(lo < hi) {
+            const uint64_t mid = lo + (hi - lo) / 2;
+            if (mass(mid) < target)
+               lo = mid + 1;
+            else
+               hi = mid;
+         }
+         boundaries.push_back(lo);
+      }
+      boundaries.push_back(end_id);
+      return boundaries;
+   }
+
+   /**
+    * @param comparator    Passed to each bucket's sorter
+    * @param run_memory    Bytes for run formation shared equally by the buckets' sorters
+    * @param merge_memory  Bytes for merging shared equally by the buckets' sorters
+    * @param boundaries    Non-decreasing ids; bucket i receives the ids in [boundaries[i], boundaries[i+1]).
+    *                      All token ids pushed have to be within [boundaries.front(), boundaries.back())
+    */
+   template <class Comparator>
+   BucketedTokenSorter(const Comparator & comparator, uint64_t run_memory, uint64_t merge_memory,
+                       const std::vector<uint64_t> & boundaries)
+      : _boundaries(boundaries)
+      , _bucket_sizes(boundaries.size() - 1, 0)
+      , _run_memory(run_memory / (boundaries.size() - 1))
+      , _merge_memory(merge_memory / (boundaries.size() - 1))
+      , _sorted(0)
+      , _current(0)
+      , _stream(nullptr)
+      , _size(0)
+      , _empty(true)
+   {
+      assert(_boundaries.size() >= 2);
+      assert(std::is_sorted(_boundaries.begin(), _boundaries.end()));
+
+      for(size_t i = 0; i + 1 < _boundaries.size(); i++)
+         _buckets.emplace_back(new Sorter(comparator, _run_memory, _merge_memory));
+   }
+
+   /**
+    * Split [first_id, end_id) into @p buckets equally wide ranges.
+    * @param first_id      Smallest token id pushed
+    * @param end_id        All token ids pushed are smaller
+    * @param buckets       Number of id ranges; positive
+    */
+   template <class Comparator>
+   BucketedTokenSorter(const Comparator & comparator, uint64_t run_memory, uint64_t merge_memory,
+                       uint64_t first_id, uint64_t end_id, unsigned int buckets)
+      : BucketedTokenSorter(comparator, run_memory, merge_memory, _equalBoundaries(first_id, end_id, buckets))
+   {}
+
+   //! @param memory  Bytes for run formation and merging shared equally by the buckets' sorters
+   template <class Comparator>
+   BucketedTokenSorter(const Comparator & comparator, uint64_t memory, uint64_t first_id, uint64_t end_id, unsigned int buckets)
+      : BucketedTokenSorter(comparator, memory, memory, first_id, end_id, buckets)
+   {}
+
+   BucketedTokenSorter(const BucketedTokenSorter &) = delete;
+
+   //! Waits for the background sort if the stream was not consumed completely
+   ~BucketedTokenSorter() {
+      if (_sorting_thread.joinable())
+         _sorting_thread.join();
+   }
+
+   void push(const value_type & token) {
+      const size_t bucket = _bucketOf(token.id());
+      _buckets[bucket]->push(token);
+      _bucket_sizes[bucket]++;
+      _size++;
+   }
+
+   //! Sort the first bucket and start sorting the others in the background
+   void sort() {
+      _buckets.front()->sort();
+      _sorted = 1;
+      _empty = false;
+
+      if (_buckets.size() > 1)
+         _sorting_thread = std::thread([this] {_sortAll();});
+
+      _advance();
+   }
+
+   //! Number of tokens pushed
+   uint64_t size() const {
+      return _size;
+   }
+
+   size_t numberOfBuckets() const {
+      return _buckets.size();
+   }
+
+   /**
+    * Upper bound of the memory held by the buckets from sort() until they are read:
+    * a bucket fitting into a single run stays in RAM, the others hold their merge
+    * buffers; buckets sorted in the background keep their run buffers until then.
+    */
+   uint64_t memoryAfterSort() const {
+      uint64_t bytes = 0;
+      for(size_t i = 0; i < _buckets.size(); i++) {
+         const uint64_t sorted = MemoryPool::sorterMemoryAfterSort(_bucket_sizes[i] * sizeof(value_type), _run_memory, _merge_memory);
+         bytes += i ? std::max(sorted, _run_memory) : sorted;
+      }
+      return bytes;
+   }
+
+//! @name STXXL Streaming Interface
+//! @{
+   bool empty() const {return _empty;}
+   const value_type & operator*() const {return **_stream;}
+
+   BucketedTokenSorter & operator++() {
+      ++(*_stream);
+      if (UNLIKELY(_stream->empty())) {
+         _buckets[_current].reset();
+         _current++;
+         _advance();
+      }
+      return *this;
+   }
+//! @}
+};
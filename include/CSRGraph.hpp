@@ -0,0 +1,394 @@
+/**
+ * @file
+ * @brief Compressed sparse row graph and parallel direction-optimising BFS
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <omp.h>
+
+/**
+ * @brief First pass of the CSR construction: number of arcs per vertex
+ *
+ * Edges are passed in blocks which are processed in parallel.
+ */
+class CSRDegreeCounter {
+public:
+   using edge_type = std::pair<uint64_t, uint64_t>;
+
+protected:
+   const bool _directed;
+   std::vector<uint64_t> _degrees;
+   uint64_t _number_of_vertices;
+
+public:
+   //! @param number_of_vertices  Guess used for preallocation; grows as required
+   explicit CSRDegreeCounter(bool directed, uint64_t number_of_vertices = 0)
+      : _directed(directed)
+      , _degrees(number_of_vertices, 0)
+      , _number_of_vertices(1)
+   {}
+
+   bool directed() const {return _directed;}
+
+   //! Largest id seen plus one (at least one)
+   uint64_t numberOfVertices() const {
+      return _number_of_vertices;
+   }
+
+   //! Number of arcs leaving @p v
+   uint64_t degree(uint64_t v) const {
+      return v < _degrees.size() ? _degrees[v] : 0;
+   }
+
+   void operator()(const edge_type* begin, const edge_type* end) {
+      const int64_t n = end - begin;
+
+      uint64_t max_vertex = 0;
+      #pragma omp parallel for reduction(max:max_vertex)
+      for(int64_t i = 0; i < n; i++)
+         max_vertex = std::max(max_vertex, std::max(begin[i].first, begin[i].second));
+
+      if (!n) return;
+
+      _number_of_vertices = std::max(_number_of_vertices, max_vertex + 1);
+      if (max_vertex >= _degrees.size())
+         _degrees.resize(std::max(max_vertex + 1, 2 * _degrees.size()), 0);
+
+      uint64_t* degrees = _degrees.data();
+      const bool directed = _directed;
+      #pragma omp parallel for
+      for(int64_t i = 0; i < n; i++) {
+         #pragma omp atomic
+         degrees[begin[i].first]++;
+
+         if (!directed) {
+            #pragma omp atomic
+            degrees[begin[i].second]++;
+         }
+      }
+   }
+};
+
+//! @brief Compressed sparse row representation; built in two passes by a parallel counting sort
+template <typename NodeT = uint64_t>
+class CSRGraph {
+public:
+   using node_type = NodeT;
+   using edge_type = CSRDegreeCounter::edge_type;
+
+protected:
+   const bool _directed;
+   std::vector<uint64_t> _offsets;   //!< n + 1 entries
+   std::vector<NodeT> _neighbors;
+   std::vector<uint64_t> _fill;      //!< next free slot per vertex during construction
+
+public:
+   /**
+    * Allocate the arrays according to the degrees of the first pass;
+    * the arcs have to be passed by fill() in a second pass.
+    */
+   explicit CSRGraph(const CSRDegreeCounter & counter)
+      : _directed(counter.directed())
+   {
+      const uint64_t n = counter.numberOfVertices();
+      _offsets.resize(n + 1);
+      _offsets[0] = 0;
+      for(uint64_t v = 0; v < n; v++)
+         _offsets[v + 1] = _offsets[v] + counter.degree(v);
+
+      _neighbors.resize(_offsets[n]);
+      _fill.assign(_offsets.begin(), _offsets.end() - 1);
+   }
+
+   //! Second pass: scatter a block of edges into the adjacency arrays
+   void fill(const edge_type* begin, const edge_type* end) {
+      const int64_t n = end - begin;
+      uint64_t* fill = _fill.data();
+      NodeT* neighbors = _neighbors.data();
+      const bool directed = _directed;
+
+      #pragma omp parallel for
+      for(int64_t i = 0; i < n; i++) {
+         const uint64_t u = begin[i].first;
+         const uint64_t v = begin[i].second;
+
+         uint64_t pos;
+         #pragma omp atomic capture
+         pos = fill[u]++;
+         neighbors[pos] = NodeT(v);
+
+         if (!directed) {
+            #pragma omp atomic capture
+            pos = fill[v]++;
+            neighbors[pos] = NodeT(u);
+         }
+      }
+   }
+
+   /**
+    * Sort each adjacency array and remove duplicates.
+    * @return Number of arcs removed
+    */
+   uint64_t finish() {
+      const uint64_t n = numberOfVertices();
+      assert(std::equal(_fill.begin(), _fill.end(), _offsets.begin() + 1));
+      std::vector<uint64_t>().swap(_fill);
+
+      // sort and unique in parallel
+      std::vector<uint64_t> degrees(n);
+      #pragma omp parallel for schedule(dynamic, 1024)
+      for(int64_t v = 0; v < int64_t(n); v++) {
+         NodeT* begin = _neighbors.data() + _offsets[v];
+         NodeT* end = _neighbors.data() + _offsets[v + 1];
+         std::sort(begin, end);
+         degrees[v] = std::unique(begin, end) - begin;
+      }
+
+      // compact; data only moves to the front
+      uint64_t pos = 0;
+      for(uint64_t v = 0; v < n; v++) {
+         const uint64_t begin = _offsets[v];
+         _offsets[v] = pos;
+         std::copy(_neighbors.begin() + begin, _neighbors.begin() + begin + degrees[v], _neighbors.begin() + pos);
+         pos += degrees[v];
+      }
+
+      const uint64_t removed = _offsets[n] - pos;
+      _offsets[n] = pos;
+      _neighbors.resize(pos);
+      _neighbors.shrink_to_fit();
+
+      return removed;
+   }
+
+   bool directed() const {return _directed;}
+
+   uint64_t numberOfVertices() const {
+      return _offsets.size() - 1;
+   }
+
+   //! Number of arcs, i.e. twice the number of edges if undirected
+   uint64_t numberOfArcs() const {
+      return _neighbors.size();
+   }
+
+   uint64_t degree(uint64_t v) const {
+      return _offsets[v + 1] - _offsets[v];
+   }
+
+   const NodeT* beginNeighbors(uint64_t v) const {return _neighbors.data() + _offsets[v];}
+   const NodeT* endNeighbors(uint64_t v) const {return _neighbors.data() + _offsets[v + 1];}
+};
+
+/**
+ * @brief Parallel direction-optimising BFS (Beamer et al.)
+ *
+ * Small frontiers are expanded top-down from a vertex queue; once the frontier
+ * has more arcs than the unexplored part of the graph / alpha, the BFS switches
+ * to bottom-up steps in which every unvisited vertex searches a parent in the
+ * frontier bitmap. It switches back once the frontier has less than n / beta
+ * vertices. Bottom-up steps require a symmetric graph, so directed graphs are
+ * traversed top-down only.
+ *
+ * Visited vertices are kept across runs, so calling run() for every unvisited
+ * vertex enumerates the components.
+ */
+template <typename NodeT>
+class DirectionOptimizingBFS {
+public:
+   static constexpr uint64_t alpha = 15;
+   static constexpr uint64_t beta = 18;
+
+   //! Frontiers smaller than this are expanded sequentially
+   static constexpr size_t parallel_threshold = 1024;
+
+protected:
+   using word_type = uint64_t;
+   const CSRGraph<NodeT> & _graph;
+   const uint64_t _n;
+
+   std::vector<word_type> _visited;
+   std::vector<word_type> _frontier_bitmap;
+   std::vector<word_type> _next_bitmap;
+   std::vector<NodeT> _queue;
+
+   uint64_t _unexplored_arcs;
+   uint64_t _top_down_steps;
+   uint64_t _bottom_up_steps;
+
+   static bool _test(const std::vector<word_type> & bitmap, uint64_t v) {
+      return (bitmap[v / 64] >> (v % 64)) & 1;
+   }
+
+   static void _set(std::vector<word_type> & bitmap, uint64_t v) {
+      bitmap[v / 64] |= word_type(1) << (v % 64);
+   }
+
+   //! Expand _queue into the next queue; returns vertices and arcs newly visited
+   std::pair<uint64_t, uint64_t> _topDownStep() {
+      std::vector<NodeT> next;
+      uint64_t arcs = 0;
+      word_type* visited = _visited.data();
+
+      #pragma omp parallel if(_queue.size() > parallel_threshold) reduction(+:arcs)
+      {
+         std::vector<NodeT> local;
+
+         #pragma omp for schedule(dynamic, 64) nowait
+         for(int64_t i = 0; i < int64_t(_queue.size()); i++) {
+            const NodeT u = _queue[i];
+            for(const NodeT* w = _graph.beginNeighbors(u); w != _graph.endNeighbors(u); ++w) {
+               const word_type mask = word_type(1) << (*w % 64);
+               if (visited[*w / 64] & mask)
+                  continue;
+
+               // only the thread setting the bit visits the vertex
+               if (!(__atomic_fetch_or(visited + *w / 64, mask, __ATOMIC_RELAXED) & mask)) {
+                  local.push_back(*w);
+                  arcs += _graph.degree(*w);
+               }
+            }
+         }
+
+         #pragma omp critical
+         next.insert(next.end(), local.begin(), local.end());
+      }
+
+      _queue.swap(next);
+      _top_down_steps++;
+      return std::make_pair(uint64_t(_queue.size()), arcs);
+   }
+
+   //! Unvisited vertices with a neighbour in _frontier_bitmap form _next_bitmap
+   std::pair<uint64_t, uint64_t> _bottomUpStep() {
+      const int64_t words = int64_t(_visited.size());
+      uint64_t vertices = 0;
+      uint64_t arcs = 0;
+
+      // every thread owns whole words, so no atomics are required
+      #pragma omp parallel for schedule(dynamic, 256) reduction(+:vertices,arcs)
+      for(int64_t i = 0; i < words; i++) {
+         word_type next = 0;
+         word_type unvisited = ~_visited[i];
+
+         while(unvisited) {
+            const unsigned int bit = __builtin_ctzll(unvisited);
+            unvisited &= unvisited - 1;
+
+            const uint64_t v = uint64_t(i) * 64 + bit;
+            if (v >= _n) break;
+
+            for(const NodeT* u = _graph.beginNeighbors(v); u != _graph.endNeighbors(v); ++u) {
+               if (_test(_frontier_bitmap, *u)) {
+                  next |= word_type(1) << bit;
+                  vertices++;
+                  arcs += _graph.degree(v);
+                  break;
+               }
+            }
+         }
+
+         _next_bitmap[i] = next;
+         _visited[i] |= next;
+      }
+
+      _frontier_bitmap.swap(_next_bitmap);
+      _bottom_up_steps++;
+      return std::make_pair(vertices, arcs);
+   }
+
+   void _queueToBitmap() {
+      std::fill(_frontier_bitmap.begin(), _frontier_bitmap.end(), 0);
+      for(const NodeT v : _queue)
+         _set(_frontier_bitmap, v);
+      _queue.clear();
+   }
+
+   void _bitmapToQueue() {
+      _queue.clear();
+      for(uint64_t i = 0; i < _frontier_bitmap.size(); i++) {
+         for(word_type word = _frontier_bitmap[i]; word; word &= word - 1)
+            _queue.push_back(NodeT(i * 64 + __builtin_ctzll(word)));
+      }
+   }
+
+public:
+   explicit DirectionOptimizingBFS(const CSRGraph<NodeT> & graph)
+      : _graph(graph)
+      , _n(graph.numberOfVertices())
+      , _visited((_n + 63) / 64, 0)
+      , _unexplored_arcs(graph.numberOfArcs())
+      , _top_down_steps(0)
+      , _bottom_up_steps(0)
+   {
+      if (!graph.directed()) {
+         _frontier_bitmap.resize(_visited.size());
+         _next_bitmap.resize(_visited.size());
+      }
+   }
+
+   bool visited(uint64_t v) const {
+      return _test(_visited, v);
+   }
+
+   /**
+    * Visit all vertices reachable from @p source that were not visited before.
+    * @return Number of vertices visited
+    */
+   uint64_t run(NodeT source) {
+      if (visited(source))
+         return 0;
+
+      _set(_visited, source);
+      _queue.assign(1, source);
+
+      uint64_t reached = 1;
+      uint64_t frontier_vertices = 1;
+      uint64_t frontier_arcs = _graph.degree(source);
+      _unexplored_arcs -= frontier_arcs;
+      bool bottom_up = false;
+
+      while(frontier_vertices) {
+         if (!_graph.directed()) {
+            if (!bottom_up && frontier_arcs > _unexplored_arcs / alpha) {
+               _queueToBitmap();
+               bottom_up = true;
+            } else if (bottom_up && frontier_vertices < _n / beta) {
+               _bitmapToQueue();
+               bottom_up = false;
+            }
+         }
+
+         const std::pair<uint64_t, uint64_t> step = bottom_up ? _bottomUpStep() : _topDownStep();
+         frontier_vertices = step.first;
+         frontier_arcs = step.second;
+         reached += frontier_vertices;
+         _unexplored_arcs -= frontier_arcs;
+      }
+
+      return reached;
+   }
+
+   uint64_t topDownSteps() const {return _top_down_steps;}
+   uint64_t bottomUpSteps() const {return _bottom_up_steps;}
+};
@@ -0,0 +1,264 @@
+/**
+ * @file
+ * @brief Delta and varint compressed sequences of tokens in external memory
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <stxxl/vector>
+#include <stxxl/bits/common/utils.h>
+#include <Token.hpp>
+
+/**
+ * @brief Delta and varint compressed sequence of tokens in external memory
+ *
+ * A run consists of chunks, each of which is a sorted sequence of tokens.
+ * A chunk is encoded as the varint number of tokens followed by pairs
+ * (varint delta of the typed id to its predecessor, varint value) and is padded
+ * to a multiple of 8 bytes. Since ids in a chunk are non-decreasing, the deltas are
+ * small and a 16 byte token typically shrinks to 5 to 8 bytes.
+ *
+ * Chunks are encoded in RAM and appended word-wise to an STXXL vector,
+ * which caches only a single block; hence many runs may be written concurrently.
+ */
+template <typename T = Token64, unsigned BlockSize = (1u << 20)>
+class CompressedTokenRun {
+public:
+   using value_type = T;
+   using word_vector_type = typename stxxl::VECTOR_GENERATOR<uint64_t, 1, 1, BlockSize>::result;
+
+protected:
+   word_vector_type _words;
+   uint64_t _size;
+   std::vector<uint8_t> _scratch;
+
+   //! Typed id (including query bit) which defines the order of tokens
+   static uint64_t _key(const T & token) {
+      return (uint64_t(token.id()) << 1) | token.query();
+   }
+
+   static void _encode(std::vector<uint8_t> & out, uint64_t x) {
+      while(x >= 0x80) {
+         out.push_back(uint8_t(x) | 0x80);
+         x >>= 7;
+      }
+      out.push_back(uint8_t(x));
+   }
+
+public:
+   CompressedTokenRun() : _size(0) {}
+   CompressedTokenRun(const CompressedTokenRun &) = delete;
+
+   //! Append sorted range [begin, end) as a new chunk
+   template <typename Iterator>
+   void append(Iterator begin, Iterator end) {
+      if (begin == end) return;
+
+      _scratch.clear();
+      _encode(_scratch, end - begin);
+
+      uint64_t last_key = 0;
+      for(Iterator it = begin; it != end; ++it) {
+         const uint64_t key = _key(*it);
+         assert(key >= last_key);
+         _encode(_scratch, key - last_key);
+         _encode(_scratch, it->value());
+         last_key = key;
+      }
+
+      // pad and append as 64 bit words
+      _scratch.resize((_scratch.size() + 7) & ~size_t(7), 0);
+      for(size_t i = 0; i < _scratch.size(); i += 8) {
+         uint64_t word;
+         std::copy(_scratch.begin() + i, _scratch.begin() + i + 8, reinterpret_cast<uint8_t*>(&word));
+         _words.push_back(word);
+      }
+
+      _size += end - begin;
+   }
+
+   //! Number of tokens stored
+   uint64_t size() const {
+      return _size;
+   }
+
+   //! Number of bytes occupied in external memory
+   uint64_t bytes() const {
+      return 8 * _words.size();
+   }
+
+   bool empty() const {
+      return !_size;
+   }
+
+   //! Remove all tokens and release external memory
+   void clear() {
+      _words.clear();
+      _size = 0;
+   }
+
+   /**
+    * @brief Decodes a run in the order the chunks were appended
+    * @warning The run must not be modified while a reader is alive
+    */
+   class Reader {
+      using bufreader_type = typename word_vector_type::bufreader_type;
+
+      bufreader_type _reader;
+      uint64_t _word;
+      unsigned int _bytes_left;
+
+      uint64_t _chunk_left;
+      uint64_t _last_key;
+
+      T _current;
+      bool _empty;
+
+      uint8_t _nextByte() {
+         if (!_bytes_left) {
+            assert(!_reader.empty());
+            _word = *_reader;
+            ++_reader;
+            _bytes_left = 8;
+         }
+
+         const uint8_t byte = uint8_t(_word);
+         _word >>= 8;
+         _bytes_left--;
+         return byte;
+      }
+
+      uint64_t _decode() {
+         uint64_t x = 0;
+         for(unsigned int shift = 0; ; shift += 7) {
+            const uint8_t byte = _nextByte();
+            x |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return x;
+         }
+      }
+
+   public:
+      explicit Reader(CompressedTokenRun & run)
+         : _reader(run._words)
+         , _bytes_left(0)
+         , _chunk_left(0)
+         , _empty(false)
+      {++(*this);}
+
+   //! @name STXXL Streaming Interface
+   //! @{
+      bool empty() const {return _empty;}
+      const T & operator*() const {return _current;}
+
+      Reader & operator++() {
+         if (!_chunk_left) {
+            // skip padding of previous chunk and start next one
+            _bytes_left = 0;
+            if (_reader.empty()) {
+               _empty = true;
+               return *this;
+            }
+
+            _chunk_left = _decode();
+            _last_key = 0;
+         }
+
+         _last_key += _decode();
+         const uint64_t value = _decode();
+         _current = T(_last_key & 1, _last_key >> 1, value);
+         _chunk_left--;
+
+         return *this;
+      }
+   //! @}
+   };
+};
+
+/**
+ * @brief External bucket of TieredPriorityQueue storing compressed chunks
+ *
+ * Tokens are collected in a RAM buffer; a full buffer is sorted and appended as a
+ * chunk to a CompressedTokenRun. Drop-in replacement for ExternalTokenBucket.
+ * Besides the block cached by the run, the buffer takes the rest of the budget
+ * given to the constructor; smaller buffers yield shorter chunks, which compress
+ * slightly worse.
+ */
+template <typename T = Token64, unsigned BlockSize = (1u << 20)>
+class CompressedTokenBucket {
+   using run_type = CompressedTokenRun<T, BlockSize>;
+
+   run_type _run;
+   std::vector<T> _buffer;
+   const size_t _buffer_capacity;
+
+   void _flush() {
+      std::sort(_buffer.begin(), _buffer.end());
+      _run.append(_buffer.begin(), _buffer.end());
+      _buffer.clear();
+   }
+
+public:
+   //! RAM required at least: the block cached by the run and a buffer of 1024 tokens
+   static constexpr uint64_t minimumBytes = BlockSize + 1024 * sizeof(T);
+
+   //! RAM used if not constrained: the block cached by the run and a buffer of one block
+   static constexpr uint64_t defaultBytes = 2 * uint64_t(BlockSize);
+
+   //! @param bytes  RAM budget of the bucket; at least minimumBytes
+   explicit CompressedTokenBucket(uint64_t bytes = defaultBytes)
+      : _buffer_capacity((std::max(bytes, minimumBytes) - BlockSize) / sizeof(T))
+   {}
+
+   void push(const T & token) {
+      if (UNLIKELY(_buffer.capacity() == 0))
+         _buffer.reserve(_buffer_capacity);
+
+      _buffer.push_back(token);
+      if (UNLIKELY(_buffer.size() == _buffer_capacity))
+         _flush();
+   }
+
+   uint64_t size() const {
+      return _run.size() + _buffer.size();
+   }
+
+   //! Call @p f for each token (in arbitrary order) and clear bucket
+   template <typename F>
+   void consume(F f) {
+      {
+         typename run_type::Reader reader(_run);
+         for(; !reader.empty(); ++reader)
+            f(*reader);
+      }
+      for(const T & token : _buffer)
+         f(token);
+
+      _run.clear();
+
+      // release buffer, as most buckets are consumed only once
+      std::vector<T>().swap(_buffer);
+   }
+};
+
+template <typename T, unsigned BlockSize>
+constexpr uint64_t CompressedTokenBucket<T, BlockSize>::minimumBytes;
+
+template <typename T, unsigned BlockSize>
+constexpr uint64_t CompressedTokenBucket<T, BlockSize>::defaultBytes;
@@ -0,0 +1,236 @@
+/**
+ * @file
+ * @brief External sorter for tokens writing delta and varint compressed runs
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <stxxl/bits/common/utils.h>
+#include <CompressedTokenRun.hpp>
+
+/**
+ * @brief External sorter for tokens writing delta and varint compressed runs
+ *
+ * Drop-in replacement for stxxl::sorter<T, T::ComparatorAsc>. Tokens are
+ * collected in RAM; a full buffer is sorted and spilled as a CompressedTokenRun.
+ * Sorted token streams compress very well, so scratch disk I/O and footprint
+ * shrink by a factor of 2 to 3 at the cost of cheap varint coding.
+ * If the number of runs exceeds the fan-in allowed by the memory budget,
+ * groups of runs are merged into longer runs first.
+ *
+ * If no run was spilled, the output is served directly from RAM.
+ */
+template <typename T = Token64, unsigned BlockSize = (1u << 20)>
+class CompressedTokenSorter {
+public:
+   using value_type = T;
+   using size_type = uint64_t;
+
+protected:
+   using run_type = CompressedTokenRun<T, BlockSize>;
+   using reader_type = typename run_type::Reader;
+   using heap_item = std::pair<T, unsigned int>;
+
+   struct HeapCompare {
+      bool operator()(const heap_item & a, const heap_item & b) const {return b.first < a.first;}
+   };
+
+   const stxxl::unsigned_type _merge_memory;
+   std::vector<T> _buffer;
+   std::vector<std::unique_ptr<run_type>> _runs;
+   uint64_t _size;
+
+   // output state
+   bool _output;
+   size_t _buffer_pos;
+   std::vector<std::unique_ptr<reader_type>> _readers;
+   std::vector<heap_item> _heap;
+   T _current;
+   bool _empty;
+
+   //! Each reader prefetches two blocks
+   unsigned int _maxFanIn() const {
+      return std::max<stxxl::unsigned_type>(2, _merge_memory / (2 * BlockSize));
+   }
+
+   void _spill() {
+      if (_buffer.empty()) return;
+
+      std::sort(_buffer.begin(), _buffer.end());
+
+      std::unique_ptr<run_type> run(new run_type);
+      run->append(_buffer.begin(), _buffer.end());
+      _runs.push_back(std::move(run));
+
+      _buffer.clear();
+   }
+
+   //! Open readers of runs [first, last) and setup merge heap
+   void _startMerge(size_t first, size_t last) {
+      _readers.clear();
+      _heap.clear();
+
+      for(size_t i = first; i < last; i++) {
+         _readers.emplace_back(new reader_type(*_runs[i]));
+         if (!_readers.back()->empty())
+            _heap.emplace_back(**_readers.back(), _readers.size() - 1);
+      }
+
+      std::make_heap(_heap.begin(), _heap.end(), HeapCompare());
+   }
+
+   //! Pop smallest token of merge heap; returns false if exhausted
+   bool _nextMerged(T & token) {
+      if (_heap.empty())
+         return false;
+
+      std::pop_heap(_heap.begin(), _heap.end(), HeapCompare());
+      token = _heap.back().first;
+
+      auto & reader = *_readers[_heap.back().second];
+      ++reader;
+      if (reader.empty()) {
+         _heap.pop_back();
+      } else {
+         _heap.back().first = *reader;
+         std::push_heap(_heap.begin(), _heap.end(), HeapCompare());
+      }
+
+      return true;
+   }
+
+   //! Merge groups of runs until all of them can be merged in a single pass
+   void _reduceRuns() {
+      const size_t fan_in = _maxFanIn();
+      const size_t chunk_size = std::max<size_t>(1, BlockSize / sizeof(T));
+
+      while(_runs.size() > fan_in) {
+         std::vector<std::unique_ptr<run_type>> merged_runs;
+
+         for(size_t first = 0; first < _runs.size(); first += fan_in) {
+            const size_t last = std::min(_runs.size(), first + fan_in);
+
+            std::unique_ptr<run_type> merged(new run_type);
+            _startMerge(first, last);
+            for(T token; _nextMerged(token); ) {
+               _buffer.push_back(token);
+               if (_buffer.size() == chunk_size) {
+                  merged->append(_buffer.begin(), _buffer.end());
+                  _buffer.clear();
+               }
+            }
+            merged->append(_buffer.begin(), _buffer.end());
+            _buffer.clear();
+
+            _readers.clear();
+            for(size_t i = first; i < last; i++)
+               _runs[i].reset();
+
+            merged_runs.push_back(std::move(merged));
+         }
+
+         _runs.swap(merged_runs);
+      }
+   }
+
+   void _fetch() {
+      if (_runs.empty()) {
+         _empty = (_buffer_pos >= _buffer.size());
+         if (!_empty)
+            _current = _buffer[_buffer_pos++];
+      } else {
+         _empty = !_nextMerged(_current);
+      }
+   }
+
+public:
+   /**
+    * @param run_memory    Number of bytes used for run formation
+    * @param merge_memory  Number of bytes used for merging; determines the fan-in
+    */
+   CompressedTokenSorter(const typename T::ComparatorAsc &, stxxl::unsigned_type run_memory, stxxl::unsigned_type merge_memory)
+      : _merge_memory(merge_memory)
+      , _size(0)
+      , _output(false)
+      , _buffer_pos(0)
+      , _empty(true)
+   {
+      _buffer.reserve(std::max<size_t>(1, run_memory / sizeof(T)));
+   }
+
+   //! @param memory  Number of bytes used for run formation and merging
+   CompressedTokenSorter(const typename T::ComparatorAsc & comparator, stxxl::unsigned_type memory)
+      : CompressedTokenSorter(comparator, memory, memory)
+   {}
+
+   CompressedTokenSorter(const CompressedTokenSorter &) = delete;
+
+   void push(const T & token) {
+      assert(!_output);
+      _buffer.push_back(token);
+      _size++;
+
+      if (UNLIKELY(_buffer.size() == _buffer.capacity()))
+         _spill();
+   }
+
+   //! Finish input and switch to output
+   void sort() {
+      assert(!_output);
+      _output = true;
+
+      if (_runs.empty()) {
+         std::sort(_buffer.begin(), _buffer.end());
+         _buffer_pos = 0;
+      } else {
+         _spill();
+
+         // release run formation buffer; it is only used in chunk-sized portions from now on
+         std::vector<T>().swap(_buffer);
+
+         _reduceRuns();
+         _startMerge(0, _runs.size());
+      }
+
+      _fetch();
+   }
+
+   //! Number of tokens pushed
+   size_type size() const {
+      return _size;
+   }
+
+   //! Number of bytes written in compressed runs that are still alive
+   uint64_t bytesSpilled() const {
+      uint64_t bytes = 0;
+      for(auto & run : _runs)
+         if (run) bytes += run->bytes();
+      return bytes;
+   }
+
+//! @name STXXL Streaming Interface
+//! @{
+   bool empty() const {return _empty;}
+   const T & operator*() const {return _current;}
+   CompressedTokenSorter & operator++() {_fetch(); return *this;}
+//! @}
+};
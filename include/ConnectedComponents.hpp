@@ -0,0 +1,287 @@
+/**
+ * @file
+ * @brief Connected components of edge lists in internal and external memory
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <stxxl/sorter>
+#include <stxxl/vector>
+
+#include <DistributionCount.hpp>
+#include <GenericComparator.hpp>
+
+/**
+ * @brief Union-find over a dense parent array
+ *
+ * Roots are linked by index (the larger root points to the smaller one) and
+ * paths are halved on each find. Hence every vertex points to a vertex with
+ * smaller id and the representative of a component is its smallest vertex,
+ * i.e. the same label as computed by ExternalConnectedComponents.
+ *
+ * @tparam IndexT  Unsigned type of the parent array; uint32_t halves the memory if ids fit
+ */
+template <typename IndexT = uint64_t>
+class UnionFind {
+protected:
+   std::vector<IndexT> _parent;
+
+public:
+   explicit UnionFind(uint64_t number_of_vertices = 0) {
+      grow(number_of_vertices);
+   }
+
+   //! Largest number of vertices representable by IndexT
+   static constexpr uint64_t maxVertices() {
+      return uint64_t(std::numeric_limits<IndexT>::max());
+   }
+
+   //! Add isolated vertices up to id @p number_of_vertices - 1
+   void grow(uint64_t number_of_vertices) {
+      assert(number_of_vertices <= maxVertices());
+      for(uint64_t v = _parent.size(); v < number_of_vertices; v++)
+         _parent.push_back(IndexT(v));
+   }
+
+   uint64_t size() const {
+      return _parent.size();
+   }
+
+   IndexT find(IndexT v) {
+      while(_parent[v] != v) {
+         _parent[v] = _parent[_parent[v]];
+         v = _parent[v];
+      }
+      return v;
+   }
+
+   //! Merge the components of @p u and @p v; returns false if they were identical
+   bool unite(IndexT u, IndexT v) {
+      u = find(u);
+      v = find(v);
+      if (u == v)
+         return false;
+
+      if (u < v)
+         _parent[v] = u;
+      else
+         _parent[u] = v;
+
+      return true;
+   }
+
+   /**
+    * Point every vertex directly to its representative in one ascending pass;
+    * afterwards label(v) is the smallest vertex of the component of v.
+    */
+   void flatten() {
+      for(uint64_t v = 0; v < _parent.size(); v++)
+         _parent[v] = _parent[_parent[v]];
+   }
+
+   //! Representative of @p v; requires flatten()
+   uint64_t label(uint64_t v) const {
+      return _parent[v];
+   }
+};
+
+/**
+ * @brief Connected components by min-label propagation in external memory
+ *
+ * Edges are symmetrised and sorted by source once. In each round, every
+ * vertex whose label decreased in the previous round sends its label along
+ * its edges; the messages are sorted by target and merged with the label
+ * vector in a scan. The number of rounds is bounded by the diameter plus one,
+ * which is small for the scale-free graphs produced here; each round sorts
+ * only the messages of active vertices.
+ */
+class ExternalConnectedComponents {
+public:
+   using edge_type = std::pair<uint64_t, uint64_t>;
+   using vector_type = stxxl::VECTOR_GENERATOR<uint64_t>::result;
+
+protected:
+   struct EdgeCompare {
+      bool operator()(const edge_type & a, const edge_type & b) const {return a < b;}
+      edge_type min_value() const {return edge_type(std::numeric_limits<uint64_t>::min(), std::numeric_limits<uint64_t>::min());}
+      edge_type max_value() const {return edge_type(std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max());}
+   };
+
+   using sorter_type = stxxl::sorter<edge_type, EdgeCompare>;
+
+   //! Marks labels that decreased in the last round; labels are vertex ids, so the bit is free
+   static constexpr uint64_t active_flag = 1llu << 63;
+
+   const uint64_t _memory;
+   sorter_type _edges;
+   uint64_t _number_of_vertices;
+
+   vector_type _labels[2];
+   unsigned int _current;
+
+public:
+   //! @param memory  Bytes of internal memory of each sorter
+   explicit ExternalConnectedComponents(uint64_t memory = 1llu << 30)
+      : _memory(memory)
+      , _edges(EdgeCompare(), memory)
+      , _number_of_vertices(0)
+      , _current(0)
+   {}
+
+   //! Account undirected edge {u, v}
+   void operator()(uint64_t u, uint64_t v) {
+      _number_of_vertices = std::max(_number_of_vertices, std::max(u, v) + 1);
+      if (u == v) return;
+
+      _edges.push(edge_type(u, v));
+      _edges.push(edge_type(v, u));
+   }
+
+   //! Include isolated vertices up to id @p n - 1
+   void setMinNumberOfVertices(uint64_t n) {
+      _number_of_vertices = std::max(_number_of_vertices, n);
+   }
+
+   uint64_t numberOfVertices() const {
+      return _number_of_vertices;
+   }
+
+   //! Compute the labels; returns the number of rounds
+   unsigned int compute() {
+      const uint64_t n = _number_of_vertices;
+      _edges.sort();
+
+      // initially every vertex is its own component and active
+      {
+         _labels[_current].resize(n);
+         typename vector_type::bufwriter_type writer(_labels[_current].begin());
+         for(uint64_t v = 0; v < n; v++)
+            writer << (v | active_flag);
+         writer.finish();
+      }
+
+      unsigned int rounds = 0;
+      for(;;) {
+         rounds++;
+
+         // send labels of active vertices to their neighbours
+         sorter_type messages(EdgeCompare(), _memory);
+         {
+            typename vector_type::bufreader_type labels(_labels[_current]);
+            uint64_t vertex = 0;
+            for(; !_edges.empty(); ++_edges) {
+               const edge_type & edge = *_edges;
+               for(; vertex < edge.first; ++vertex)
+                  ++labels;
+
+               if (*labels & active_flag)
+                  messages.push(edge_type(edge.second, *labels & ~active_flag));
+            }
+            _edges.rewind();
+         }
+         messages.sort();
+
+         // adopt smaller labels
+         uint64_t changed = 0;
+         vector_type & next = _labels[!_current];
+         next.resize(n);
+         {
+            typename vector_type::bufreader_type labels(_labels[_current]);
+            typename vector_type::bufwriter_type writer(next.begin());
+            for(uint64_t v = 0; v < n; ++v, ++labels) {
+               const uint64_t label = *labels & ~active_flag;
+               uint64_t min_label = label;
+               for(; !messages.empty() && messages->first == v; ++messages)
+                  min_label = std::min(min_label, messages->second);
+
+               if (min_label < label) {
+                  writer << (min_label | active_flag);
+                  changed++;
+               } else {
+                  writer << label;
+               }
+            }
+            writer.finish();
+         }
+
+         _current = !_current;
+         _labels[!_current].clear();
+
+         if (!changed)
+            return rounds;
+      }
+   }
+
+   //! Label (smallest vertex id of its component) of each vertex; requires compute()
+   const vector_type & labels() const {
+      return _labels[_current];
+   }
+};
+
+/**
+ * @brief Component sizes from the component label of each vertex
+ *
+ * Labels are pushed in any order; the labels are counted with a sorter, so
+ * the number of components may exceed the internal memory.
+ */
+class ComponentStatistics {
+protected:
+   using sorter_type = stxxl::sorter<uint64_t, GenericComparator<uint64_t>::Ascending>;
+   sorter_type _labels;
+
+public:
+   uint64_t number_of_vertices = 0;
+   uint64_t number_of_components = 0;
+   uint64_t largest_component = 0;
+
+   explicit ComponentStatistics(uint64_t memory = 1llu << 30)
+      : _labels(GenericComparator<uint64_t>::Ascending(), memory)
+   {}
+
+   void push(uint64_t label) {
+      _labels.push(label);
+      number_of_vertices++;
+   }
+
+   /**
+    * Compute the statistics; if @p histogram is given, lines "size count"
+    * with the number of components of each size are written to it.
+    */
+   void finish(std::ostream * histogram = nullptr) {
+      _labels.sort();
+
+      sorter_type sizes(GenericComparator<uint64_t>::Ascending(), 1llu << 28);
+      DistributionCount<sorter_type> components(_labels);
+      for(; !components.empty(); ++components) {
+         sizes.push(components->count);
+         number_of_components++;
+         largest_component = std::max<uint64_t>(largest_component, components->count);
+      }
+      sizes.sort();
+
+      if (histogram) {
+         DistributionCount<sorter_type> size_counts(sizes);
+         for(; !size_counts.empty(); ++size_counts)
+            (*histogram) << size_counts->value << " " << size_counts->count << std::endl;
+      }
+   }
+};
@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @brief Stateless counter-based pseudo random numbers
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+/**
+ * @brief Stateless counter-based pseudo random numbers
+ *
+ * The i-th random number is a hash of (seed, i), so any element of the
+ * sequence can be computed in constant time and without shared state.
+ * The hash consists of two rounds of the SplitMix64 finalizer, which passes
+ * common statistical test suites when applied to a counter.
+ */
+class CounterHashRandom {
+protected:
+   uint64_t _seed;
+
+   static uint64_t _mix(uint64_t x) {
+      x ^= x >> 30;
+      x *= 0xbf58476d1ce4e5b9llu;
+      x ^= x >> 27;
+      x *= 0x94d049bb133111ebllu;
+      x ^= x >> 31;
+      return x;
+   }
+
+public:
+   explicit CounterHashRandom(uint64_t seed = 0)
+      : _seed(_mix(seed + 0x9e3779b97f4a7c15llu))
+   {}
+
+   uint64_t seed() const {return _seed;}
+
+   //! Uniform 64 bit integer associated with @p counter
+   uint64_t operator()(uint64_t counter) const {
+      return _mix(_seed ^ _mix(counter * 0x9e3779b97f4a7c15llu + 1));
+   }
+
+   /**
+    * Uniformly draw a number from [0; supremum[ associated with @p counter.
+    * Uses the multiply-shift reduction; the rare biased results are rejected
+    * and redrawn from hashes of (counter, round).
+    */
+   uint64_t operator()(uint64_t counter, uint64_t supremum) const {
+      assert(supremum > 0);
+      const uint64_t threshold = -supremum % supremum;
+
+      uint64_t x = (*this)(counter);
+      for(uint64_t round = 1; ; round++) {
+         const unsigned __int128 m = (unsigned __int128)x * supremum;
+         if (uint64_t(m) >= threshold)
+            return uint64_t(m >> 64);
+
+         x = _mix(x ^ (round * 0xd6e8feb86659fd93llu));
+      }
+   }
+};
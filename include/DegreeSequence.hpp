@@ -0,0 +1,233 @@
+/**
+ * @file
+ * @brief Dense per-vertex degree sequence output
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <stxxl/sorter>
+
+#include <DistributionCount.hpp>
+#include <FdSink.hpp>
+#include <FileDataType.hpp>
+#include <GenericComparator.hpp>
+
+/**
+ * @brief Dense per-vertex degree sequence output
+ *
+ * The endpoints of all edges are sorted and run-length encoded; the resulting
+ * degrees are written as a dense array indexed by vertex id. Each vertex
+ * occupies one integer (undirected) or two integers (out-degree followed by
+ * in-degree) of Summary::bytes_per_degree bytes in little endian; vertices without
+ * edges are included with degree 0. Compared to the edge list this is
+ * several orders of magnitude smaller and is written in one sequential pass.
+ */
+class DegreeSequence {
+public:
+   using sorter_type = stxxl::sorter<uint64_t, GenericComparator<uint64_t>::Ascending>;
+
+   //! Result of write() and writeSorted()
+   struct Summary {
+      uint64_t number_of_vertices;
+      uint64_t max_degree;
+      unsigned int bytes_per_degree;
+   };
+
+protected:
+   const bool _directed;
+   sorter_type _out_sorter; //!< sources, or all endpoints if undirected
+   std::unique_ptr<sorter_type> _in_sorter; //!< targets if directed
+
+   //! Vertex ids stored in a sorter, converted to uint64_t
+   template <class Sorter>
+   class _VertexStream {
+      Sorter & _sorter;
+   public:
+      using value_type = uint64_t;
+      explicit _VertexStream(Sorter & sorter) : _sorter(sorter) {}
+      bool empty() const {return _sorter.empty();}
+      uint64_t operator*() const {return FileDataType<typename Sorter::value_type>::toInternal(*_sorter);}
+      _VertexStream & operator++() {++_sorter; return *this;}
+   };
+
+   //! Call f(vertex, out_degree, in_degree) for all vertices with edges in ascending order
+   template <class Sorter, typename F>
+   static void _forEachVertex(Sorter & out_sorter, Sorter * in_sorter, F f) {
+      using count_type = DistributionCount<_VertexStream<Sorter>>;
+
+      _VertexStream<Sorter> out_vertices(out_sorter);
+      count_type out_counts(out_vertices);
+
+      if (!in_sorter) {
+         for(; !out_counts.empty(); ++out_counts)
+            f(out_counts->value, out_counts->count, 0);
+         return;
+      }
+
+      _VertexStream<Sorter> in_vertices(*in_sorter);
+      count_type in_counts(in_vertices);
+
+      constexpr uint64_t none = std::numeric_limits<uint64_t>::max();
+      while(!out_counts.empty() || !in_counts.empty()) {
+         const uint64_t vertex = std::min(out_counts.empty() ? none : out_counts->value,
+                                          in_counts.empty()  ? none : in_counts->value);
+
+         uint64_t out_degree = 0;
+         if (!out_counts.empty() && out_counts->value == vertex) {
+            out_degree = out_counts->count;
+            ++out_counts;
+         }
+
+         uint64_t in_degree = 0;
+         if (!in_counts.empty() && in_counts->value == vertex) {
+            in_degree = in_counts->count;
+            ++in_counts;
+         }
+
+         f(vertex, out_degree, in_degree);
+      }
+   }
+
+   //! Smallest of 1, 2, 4 and 8 bytes that represents @p max_degree
+   static unsigned int _bytesFor(uint64_t max_degree) {
+      unsigned int bytes = 1;
+      while(bytes < 8 && (max_degree >> (8 * bytes)))
+         bytes *= 2;
+      return bytes;
+   }
+
+public:
+   /**
+    * @param directed  Write out- and in-degree per vertex
+    * @param memory    Bytes of internal memory of the sorter(s); split equally if directed
+    */
+   explicit DegreeSequence(bool directed, uint64_t memory = 1llu << 30)
+      : _directed(directed)
+      , _out_sorter(GenericComparator<uint64_t>::Ascending(), directed ? memory / 2 : memory)
+   {
+      if (directed)
+         _in_sorter.reset(new sorter_type(GenericComparator<uint64_t>::Ascending(), memory / 2));
+   }
+
+   bool directed() const {return _directed;}
+
+   //! Account edge (u, v)
+   void operator()(uint64_t u, uint64_t v) {
+      _out_sorter.push(u);
+      (_directed ? *_in_sorter : _out_sorter).push(v);
+   }
+
+   /**
+    * Sort the accounted edges and write the degree sequence to @p path.
+    * @see writeSorted
+    */
+   Summary write(const std::string & path, unsigned int bytes_per_degree = 0, uint64_t number_of_vertices = 0) {
+      _out_sorter.sort();
+      if (_directed)
+         _in_sorter->sort();
+
+      return writeSorted(path, _out_sorter, _in_sorter.get(),
+                         bytes_per_degree, number_of_vertices);
+   }
+
+   /**
+    * Write the degree sequence of the vertex ids in the sorted sorters to @p path ("-" is stdout).
+    *
+    * @param out_sorter  Sorted sources, or all endpoints if undirected
+    * @param in_sorter   Sorted targets if directed, nullptr otherwise
+    * @param bytes_per_degree  Width of each degree; if 0 the smallest of 1, 2, 4 and 8 bytes
+    *                    fitting the maximum degree is used, which takes an additional pass
+    * @param number_of_vertices  Lower bound on the array length (to include isolated vertices
+    *                    with large ids); by default the largest id with an edge determines it
+    *
+    * The sorters are rewound afterwards.
+    */
+   template <class Sorter>
+   static Summary writeSorted(const std::string & path, Sorter & out_sorter, Sorter * in_sorter,
+                              unsigned int bytes_per_degree = 0, uint64_t number_of_vertices = 0)
+   {
+      Summary summary{0, 0, bytes_per_degree};
+
+      if (!bytes_per_degree) {
+         _forEachVertex(out_sorter, in_sorter, [&summary] (uint64_t, uint64_t out_degree, uint64_t in_degree) {
+            summary.max_degree = std::max(summary.max_degree, std::max(out_degree, in_degree));
+         });
+
+         summary.bytes_per_degree = _bytesFor(summary.max_degree);
+         out_sorter.rewind();
+         if (in_sorter)
+            in_sorter->rewind();
+      }
+
+      const unsigned int bytes = summary.bytes_per_degree;
+      if (bytes < 1 || bytes > 8)
+         STXXL_THROW(std::invalid_argument, "Bytes per degree have to be in [1, 8]; got " << bytes);
+
+      const uint64_t limit = (bytes == 8) ? std::numeric_limits<uint64_t>::max() : ((1llu << (8 * bytes)) - 1);
+      const unsigned int degrees_per_vertex = in_sorter ? 2 : 1;
+
+      FdSink sink(path);
+      const char zeros[64] = {};
+
+      auto write_zeros = [&] (uint64_t vertices) {
+         for(uint64_t remaining = vertices * degrees_per_vertex * bytes; remaining; ) {
+            const size_t n = std::min<uint64_t>(remaining, sizeof(zeros));
+            sink.write(zeros, n);
+            remaining -= n;
+         }
+      };
+
+      auto write_degree = [&] (uint64_t degree) {
+         if (UNLIKELY(degree > limit))
+            STXXL_THROW(std::overflow_error, "Degree " << degree << " exceeds " << bytes << " bytes per degree");
+         char data[8];
+         for(unsigned int i = 0; i < bytes; i++)
+            data[i] = char(degree >> (8 * i));
+         sink.write(data, bytes);
+      };
+
+      uint64_t next_vertex = 0;
+      _forEachVertex(out_sorter, in_sorter, [&] (uint64_t vertex, uint64_t out_degree, uint64_t in_degree) {
+         write_zeros(vertex - next_vertex);
+         write_degree(out_degree);
+         if (in_sorter)
+            write_degree(in_degree);
+
+         summary.max_degree = std::max(summary.max_degree, std::max(out_degree, in_degree));
+         next_vertex = vertex + 1;
+      });
+
+      if (next_vertex < number_of_vertices) {
+         write_zeros(number_of_vertices - next_vertex);
+         next_vertex = number_of_vertices;
+      }
+
+      sink.close();
+
+      out_sorter.rewind();
+      if (in_sorter)
+         in_sorter->rewind();
+
+      summary.number_of_vertices = next_vertex;
+      return summary;
+   }
+};
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief Scan of binary edge list files using the selected IOBackend
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <string>
+
+#include <stxxl/io>
+#include <stxxl/vector>
+
+#include <FileDataType.hpp>
+#include <UringFile.hpp>
+
+/**
+ * Pass every vertex (as stored, i.e. of DefaultFileDataType::data_type) of the
+ * binary edge list @p filename to @p f in file order.
+ * The file is read through io_uring if selected, otherwise as STXXL vector
+ * backed by a linuxaio_file.
+ *
+ * @return Number of vertices read, i.e. twice the number of edges
+ */
+template <typename F>
+uint64_t readEdgeListFile(const std::string & filename, F f) {
+   using data_type = DefaultFileDataType::data_type;
+
+#ifdef TFP_HAVE_IO_URING
+   if (IOBackend::uring()) {
+      UringValueStream<data_type> stream(filename);
+      const uint64_t size = stream.size();
+      for(; !stream.empty(); ++stream)
+         f(*stream);
+      return size;
+   }
+#endif
+
+   stxxl::linuxaio_file input_file(filename, stxxl::file::RDONLY | stxxl::file::DIRECT);
+   DefaultFileDataType::vector_type input_vector(&input_file);
+
+   for(auto node : typename DefaultFileDataType::vector_type::bufreader_type(input_vector))
+      f(node);
+
+   return input_vector.size();
+}
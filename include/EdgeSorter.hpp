@@ -39,10 +39,7 @@ protected:
 
    stxxl::sorter<edge_type, Compare> _sorter;
 
-public:
-   EdgeSorter(InputStream & stream, stxxl::unsigned_type mem_for_sorter = 1u << 31)
-      : _sorter(Compare(), mem_for_sorter)
-   {
+   void _consume(InputStream & stream) {
       for(; !stream.empty(); ++stream) {
          edge_type edge;
 
@@ -57,10 +54,29 @@ public:
          // Push it into the sorter
          _sorter.push(edge);
       }
+   }
 
+public:
+   EdgeSorter(InputStream & stream, stxxl::unsigned_type mem_for_sorter = 1u << 31)
+      : _sorter(Compare(), mem_for_sorter)
+   {
+      _consume(stream);
       _sorter.sort();
    }
 
+   /**
+    * The memory of the merge phase is only determined once the input is
+    * exhausted, e.g. after the producer of the input released its memory.
+    * @param merge_memory  Functor called without arguments; returns the bytes used for merging
+    */
+   template <class MergeMemory>
+   EdgeSorter(InputStream & stream, stxxl::unsigned_type mem_for_runs, MergeMemory merge_memory)
+      : _sorter(Compare(), mem_for_runs)
+   {
+      _consume(stream);
+      _sorter.sort(merge_memory());
+   }
+
 //! @name STXXL Streaming Interface
 //! @{
 // straight-forward copy of the sorter interface !
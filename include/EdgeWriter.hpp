@@ -17,33 +17,104 @@
  */
 #pragma once
 
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <stxxl/io>
 #include <stxxl/vector>
 #include <stxxl/bits/common/uint_types.h>
 #include <stxxl/bits/unused.h>
 
 #include <FileDataType.hpp>
+#include <DegreeSequence.hpp>
+#include <FdSink.hpp>
+#include <MemoryPool.hpp>
+#include <TextEdgeWriter.hpp>
+#include <UringFile.hpp>
 
 /**
  * @brief Edge Output for Decision Tree producing a binary edge list file
  *
+ * Regular files are written with direct asynchronous I/O through STXXL.
+ * If the output is stdout ("-"), a FIFO or a device, the edges are written
+ * sequentially through an FdSink instead, so that a consumer can read them
+ * concurrently. Text formats are delegated to a TextEdgeWriter.
+ * If io_uring was selected as IOBackend, binary edges to regular files are
+ * written through an UringWriter.
+ * In the Degrees format no edges are written at all, but only the degree
+ * of each vertex (see DegreeSequence).
+ * The Degrees and Metis formats sort the edges in external memory; their sorters
+ * use the memory leased to the writer (see minimumMemory()), which returns to the
+ * pool on close().
+ *
  * @tparam out_type Type for vertex indices in the output file.
  *               A cast from std::uint64 to out_type has to be possible.
  */
 class EdgeWriter {
+public:
+   enum Format {
+      Binary,       //!< pairs of out_type in host byte order
+      Text,         //!< one edge "u v" per line
+      MatrixMarket, //!< coordinate pattern matrix
+      Metis,        //!< undirected adjacency lists
+      Degrees       //!< dense degree sequence (out- and in-degree if directed)
+   };
+
+protected:
    using out_type = DefaultFileDataType::data_type;
    using vector_type = DefaultFileDataType::vector_type;
    using bufwriter_type = typename vector_type::bufwriter_type;
 
-   stxxl::linuxaio_file _file;
-   vector_type _vector;
-   bufwriter_type _writer;
+   // direct I/O to regular files
+   std::unique_ptr<stxxl::linuxaio_file> _file;
+   std::unique_ptr<vector_type> _vector;
+   std::unique_ptr<bufwriter_type> _writer;
+
+   const Format _format;
+
+   // sequential output
+   std::unique_ptr<FdSink> _sink;
+   std::unique_ptr<TextEdgeWriter> _text;
+   std::unique_ptr<DegreeSequence> _degrees;
+   MemoryPool::Lease _memory;
+   std::string _filename;
+#ifdef TFP_HAVE_IO_URING
+   std::unique_ptr<UringWriter> _uring;
+#endif
 
    uint64_t _edges_written;
    int _nodes_written;
 
    bool _disable_output;
+   bool _closed;
+
+   //! True if edges are not written through the STXXL vector
+   bool _sequential() const {
+#ifdef TFP_HAVE_IO_URING
+      if (_uring) return true;
+#endif
+      return _sink || _text || _degrees;
+   }
+
+   void _streamEdge(uint64_t u, uint64_t v) {
+      if (_degrees) {
+         (*_degrees)(u, v);
+         return;
+      }
+
+      if (_text) {
+         (*_text)(u, v);
+         return;
+      }
+
+      const out_type data[2] = {DefaultFileDataType::fromInternal(u), DefaultFileDataType::fromInternal(v)};
+#ifdef TFP_HAVE_IO_URING
+      if (_uring)
+         return _uring->write(data, sizeof(data));
+#endif
+      _sink->write(data, sizeof(data));
+   }
 
 public:
    EdgeWriter() = delete;
@@ -51,23 +122,70 @@ public:
 
    /**
     * Constructor.
-    * @param[in] filename      Path to edge list. In case DISABLE_OUTPUT==true, an arbitrary value can be provided
+    * @param[in] filename      Path to edge list; "-" denotes stdout. In case DISABLE_OUTPUT==true, an arbitrary value can be provided
     * @param[in] expected_num_elems An (over-estimation) of the number of edges produced.
+    * @param[in] format        Output format; text formats are always written sequentially
+    * @param[in] directed      Only relevant for Degrees; write out- and in-degrees
+    * @param[in] memory        Memory of the sorters of the Degrees and Metis formats; at least minimumMemory()
     *
     * @note The initial output filesize is computed based on expected_num_elems.
     * If the value is to small, the file size has to be increased which may result in reduced performance.
     * However, there are no implications to the correctness.
     */
-   EdgeWriter(const std::string & filename, uint64_t expected_num_elems = 0)
-         : _file(filename, stxxl::file::DIRECT | stxxl::file::RDWR | stxxl::file::CREAT | stxxl::file::TRUNC)
-         , _vector(&_file)
-         , _writer(_vector.begin())
+   EdgeWriter(const std::string & filename, uint64_t expected_num_elems = 0, Format format = Binary, bool directed = false,
+              MemoryPool::Lease memory = MemoryPool::Lease())
+         : _format(format)
+         , _memory(std::move(memory))
+         , _filename(filename)
          , _edges_written(0)
          , _nodes_written(0)
          , _disable_output(false)
+         , _closed(false)
    {
+      if (_memory.bytes() < minimumMemory(format, directed))
+         STXXL_THROW(std::invalid_argument, "EdgeWriter needs " << (minimumMemory(format, directed) >> 20)
+                     << " MiB to sort the output; got " << (_memory.bytes() >> 20) << " MiB");
+
+      if (format == Degrees) {
+         _degrees.reset(new DegreeSequence(directed, _memory.bytes()));
+
+         STXXL_VERBOSE0("EdgeWriter writes " << (directed ? "out- and in-" : "") << "degrees to " << filename);
+         return;
+      }
+
+      if (format != Binary) {
+         const TextEdgeWriter::Format text_format =
+              (format == MatrixMarket) ? TextEdgeWriter::MatrixMarket
+            : (format == Metis)        ? TextEdgeWriter::Metis
+                                       : TextEdgeWriter::EdgeList;
+         _text.reset(new TextEdgeWriter(filename, text_format, 1 << 16, _memory.bytes()));
+
+         STXXL_VERBOSE0("EdgeWriter writes text edges to " << filename);
+         return;
+      }
+
+      if (FdSink::isStream(filename)) {
+         _sink.reset(new FdSink(filename));
+
+         STXXL_VERBOSE0("EdgeWriter streams binary edges to " << filename);
+         return;
+      }
+
+#ifdef TFP_HAVE_IO_URING
+      if (IOBackend::uring()) {
+         _uring.reset(new UringWriter(filename));
+
+         STXXL_VERBOSE0("EdgeWriter writes binary edges to " << filename << " using io_uring");
+         return;
+      }
+#endif
+
+      _file.reset(new stxxl::linuxaio_file(filename, stxxl::file::DIRECT | stxxl::file::RDWR | stxxl::file::CREAT | stxxl::file::TRUNC));
+      _vector.reset(new vector_type(_file.get()));
+      _writer.reset(new bufwriter_type(_vector->begin()));
+
       if (expected_num_elems) {
-         _vector.resize(expected_num_elems);
+         _vector->resize(expected_num_elems);
       }
 
       STXXL_VERBOSE0(
@@ -76,12 +194,76 @@ public:
       );
    }
 
-   //! Only after the destructor was called the output file is complete and has the correct size
+   /**
+    * Complete the output; only afterwards the file is complete and has the correct size.
+    * In the Degrees format, the endpoints are sorted and the degrees written only now.
+    * Idempotent; has to be called before destruction.
+    */
+   void close() {
+      if (_closed) return;
+      _closed = true;
+
+      if (UNLIKELY(_disable_output)) {
+         _memory.release();
+         return;
+      }
+
+      if (_degrees) {
+         const DegreeSequence::Summary summary = _degrees->write(_filename);
+         STXXL_VERBOSE0("EdgeWriter wrote degrees of " << summary.number_of_vertices << " vertices with "
+                        << summary.bytes_per_degree << " bytes per degree; max degree " << summary.max_degree);
+         _degrees.reset();
+      } else if (_text) {
+         _text->close();
+      } else if (_sink) {
+         _sink->close();
+#ifdef TFP_HAVE_IO_URING
+      } else if (_uring) {
+         _uring->close();
+#endif
+      } else {
+         _writer->finish();
+         _vector->resize( 2*_edges_written );
+      }
+
+      _memory.release();
+   }
+
+   //! Only releases the resources; output not completed by close() may be incomplete
    ~EdgeWriter() {
-      if (LIKELY(!_disable_output)) {
-         _writer.finish();
-         _vector.resize( 2*_edges_written );
+      if (!_closed && !_disable_output)
+         STXXL_ERRMSG("EdgeWriter destroyed without close(); " << _filename << " may be incomplete");
+   }
+
+   //! Memory the sorters of @p format need at least; 0 if the edges are not sorted
+   static uint64_t minimumMemory(Format format, bool directed = false) {
+      if (format == Degrees)
+         return (directed ? 2 : 1) * MemoryPool::sorterMinimumMemory();
+      if (format == Metis)
+         return MemoryPool::sorterMinimumMemory();
+      return 0;
+   }
+
+   //! Parse format name ("binary", "text", "mtx", "metis" or "degrees"); returns false if unknown
+   static bool parseFormat(const std::string & name, Format & format) {
+      if (name == "binary") {
+         format = Binary;
+         return true;
+      }
+
+      if (name == "degrees") {
+         format = Degrees;
+         return true;
       }
+
+      TextEdgeWriter::Format text_format;
+      if (!TextEdgeWriter::parseFormat(name, text_format))
+         return false;
+
+      format = (text_format == TextEdgeWriter::MatrixMarket) ? MatrixMarket
+             : (text_format == TextEdgeWriter::Metis)        ? Metis
+                                                             : Text;
+      return true;
    }
 
    //! Disable the writing to file
@@ -97,9 +279,21 @@ public:
          return;
       }
 
+      if (_sequential()) {
+         for(; !stream.empty(); ++stream) {
+            const uint64_t u = *stream;
+            ++stream;
+            assert(!stream.empty());
+            _streamEdge(u, *stream);
+            _edges_written++;
+         }
+         return;
+      }
+
       uint64_t vertices = 0;
+      bufwriter_type & writer = *_writer;
       for(; !stream.empty(); ++stream) {
-         _writer << DefaultFileDataType::fromInternal(*stream);
+         writer << DefaultFileDataType::fromInternal(*stream);
          vertices++;
       }
       _edges_written += vertices / 2;
@@ -115,16 +309,18 @@ public:
 
       for(; !stream.empty(); ++stream) {
          auto pair = *stream;
-         _writer << DefaultFileDataType::fromInternal(pair.first)
-                 << DefaultFileDataType::fromInternal(pair.second);
-         _edges_written++;
+         (*this)(pair.first, pair.second);
       }
    }
 
    //! Write single edge
    void operator()(const uint64_t & n1, const uint64_t & n2) {
-      _writer << DefaultFileDataType::fromInternal(n1);
-      _writer << DefaultFileDataType::fromInternal(n2);
+      if (_sequential()) {
+         _streamEdge(n1, n2);
+      } else {
+         *_writer << DefaultFileDataType::fromInternal(n1);
+         *_writer << DefaultFileDataType::fromInternal(n2);
+      }
       _edges_written++;
    }
 
@@ -134,9 +330,19 @@ public:
       return (!_disable_output) * sizeof(out_type);
    }
 
-   //! Returns the corrected file size (i.e. the file's size if the destructor were called at the moment in time).
-   //! If I/O is disabled 0 is returned.
+   //! Returns the corrected file size (i.e. the file's size if close() were called at the moment in time).
+   //! If I/O is disabled or degrees are written (only known on close) 0 is returned.
    size_t bytesFilesize() const {
+      if (_format == Degrees)
+         return 0;
+      if (_text)
+         return (!_disable_output) * _text->bytesWritten();
+      if (_sink)
+         return (!_disable_output) * _sink->bytesWritten();
+#ifdef TFP_HAVE_IO_URING
+      if (_uring)
+         return (!_disable_output) * _uring->bytesWritten();
+#endif
       return 2 * edgesWritten() * bytesPerVertex();
    }
 
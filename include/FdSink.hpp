@@ -0,0 +1,175 @@
+/**
+ * @file
+ * @brief Buffered sequential output to a file descriptor, e.g. stdout or a FIFO
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stxxl/io>
+#include <stxxl/bits/common/utils.h>
+
+/**
+ * @brief Buffered sequential output to a file descriptor, e.g. stdout or a FIFO
+ *
+ * In contrast to the STXXL files used by EdgeWriter, no seeks, direct I/O or
+ * preallocation are required; hence the output may be consumed concurrently
+ * by another process through a pipe. Data is passed to the kernel in large
+ * write calls of the buffer size.
+ */
+class FdSink {
+protected:
+   std::string _path;
+   int _fd;
+   bool _owns_fd;
+
+   std::vector<char> _buffer;
+   size_t _fill;
+   uint64_t _bytes_written;
+
+   void _write(const char* data, size_t size) {
+      while(size) {
+         const ssize_t n = ::write(_fd, data, size);
+         if (n < 0) {
+            if (errno == EINTR) continue;
+            STXXL_THROW_ERRNO(stxxl::io_error, "Cannot write to " << _path);
+         }
+
+         data += n;
+         size -= n;
+         _bytes_written += n;
+      }
+   }
+
+public:
+   /**
+    * @param path         Output path; "-" denotes stdout
+    * @param buffer_size  Number of bytes passed to the kernel per write call
+    */
+   explicit FdSink(const std::string & path, size_t buffer_size = 1 << 24)
+      : _path(path)
+      , _fd(-1)
+      , _owns_fd(path != "-")
+      , _buffer(buffer_size)
+      , _fill(0)
+      , _bytes_written(0)
+   {
+      if (_owns_fd) {
+         _fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+         if (_fd < 0)
+            STXXL_THROW_ERRNO(stxxl::io_error, "Cannot open " << path);
+      } else {
+         _fd = STDOUT_FILENO;
+      }
+   }
+
+   FdSink(const FdSink &) = delete;
+
+   //! Callers should close() explicitly; failures at destruction are only reported
+   ~FdSink() {
+      try {
+         close();
+      } catch (const std::exception & e) {
+         STXXL_ERRMSG("Closing " << _path << " failed: " << e.what());
+      }
+   }
+
+   //! True if @p path has to be written sequentially, i.e. is stdout or exists but is no regular file
+   static bool isStream(const std::string & path) {
+      if (path == "-")
+         return true;
+
+      struct stat st;
+      return !::stat(path.c_str(), &st) && !S_ISREG(st.st_mode);
+   }
+
+   //! If edges are written to stdout, redirect all messages (incl. STXXL's) to stderr
+   static void redirectMessages(const std::string & path) {
+      if (path == "-")
+         std::cout.rdbuf(std::cerr.rdbuf());
+   }
+
+   //! True if the output is a regular file, i.e. writeAt() may be used
+   bool seekable() const {
+      struct stat st;
+      return _fd >= 0 && !::fstat(_fd, &st) && S_ISREG(st.st_mode);
+   }
+
+   //! Overwrite already flushed bytes at @p offset; requires seekable()
+   void writeAt(uint64_t offset, const void* data, size_t size) {
+      assert(seekable() && offset + size <= _bytes_written);
+      if (::pwrite(_fd, data, size, offset) != ssize_t(size))
+         STXXL_THROW_ERRNO(stxxl::io_error, "Cannot write to " << _path);
+   }
+
+   /**
+    * Return a pointer to at least @p size free bytes in the buffer;
+    * the bytes actually used have to be committed via commit().
+    */
+   char* reserve(size_t size) {
+      assert(size <= _buffer.size());
+      if (UNLIKELY(_fill + size > _buffer.size()))
+         flush();
+      return _buffer.data() + _fill;
+   }
+
+   //! Mark the bytes until @p end (returned by reserve and advanced) as used
+   void commit(char* end) {
+      _fill = end - _buffer.data();
+      assert(_fill <= _buffer.size());
+   }
+
+   void write(const void* data, size_t size) {
+      if (UNLIKELY(_fill + size > _buffer.size())) {
+         flush();
+         if (size > _buffer.size())
+            return _write(static_cast<const char*>(data), size);
+      }
+
+      std::memcpy(_buffer.data() + _fill, data, size);
+      _fill += size;
+   }
+
+   //! Pass buffered data to the kernel
+   void flush() {
+      _write(_buffer.data(), _fill);
+      _fill = 0;
+   }
+
+   //! Flush and release the file descriptor; idempotent
+   void close() {
+      if (_fd < 0) return;
+
+      flush();
+      if (_owns_fd)
+         ::close(_fd);
+      _fd = -1;
+   }
+
+   uint64_t bytesWritten() const {
+      return _bytes_written + _fill;
+   }
+};
@@ -17,6 +17,7 @@
  */
 #pragma once
 
+#include <stxxl/vector>
 #include <stxxl/bits/common/uint_types.h>
 
 template <typename T>
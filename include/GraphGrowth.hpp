@@ -0,0 +1,274 @@
+/**
+ * @file
+ * @brief Metadata of generated edge lists and answering queries into them to grow a graph
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <FileDataType.hpp>
+#include <EdgeListReader.hpp>
+
+/**
+ * @brief Description of a generated edge list, stored next to it as "<output>.meta"
+ *
+ * A graph can be grown by a later run that continues the edge list of a
+ * previous one: queries into the old prefix are answered by a sequential scan
+ * of its files (see answerPrefixQueries) and only the new positions are
+ * generated and written. The edge list of a grown graph is hence split into
+ * parts; their concatenation (oldest first, as in the list) is the whole graph.
+ * In memory, the paths of the parts are valid in the working directory; in the
+ * file, they are stored relative to the directory of the metadata file, so it can
+ * be read from any working directory and moved together with its parts.
+ * Paths are normalised lexically, i.e. symbolic links are not resolved.
+ *
+ * The file consists of lines "key value"; "part" and "param" lines may repeat:
+ * @code
+ * model ba
+ * vertices 1000008
+ * positions 8000016
+ * data-width 64
+ * part graph.bin
+ * param edges-per-vertex 4
+ * @endcode
+ */
+struct GraphMetadata {
+   std::string model;                               //!< generator, e.g. "ba" or "bbcr"
+   uint64_t vertices = 0;                           //!< vertex ids are in [0, vertices)
+   uint64_t positions = 0;                          //!< length of the edge list, i.e. twice the number of edges
+   unsigned int data_width = 8 * sizeof(DefaultFileDataType::data_type);
+   std::vector<std::string> parts;                  //!< files forming the edge list
+   std::map<std::string, std::string> parameters;   //!< model parameters that a grown graph has to share
+
+   //! Path of the metadata belonging to @p output
+   static std::string path(const std::string & output) {
+      return output + ".meta";
+   }
+
+   //! Components of @p path without empty and "." ones; ".." removes its predecessor if possible
+   static std::vector<std::string> splitPath(const std::string & path) {
+      std::vector<std::string> components;
+      std::stringstream ss(path);
+      std::string component;
+      while(std::getline(ss, component, '/')) {
+         if (component.empty() || component == ".")
+            continue;
+
+         if (component == ".." && !components.empty() && components.back() != "..")
+            components.pop_back();
+         else
+            components.push_back(component);
+      }
+      return components;
+   }
+
+   //! Absolute and normalised version of @p path, which is relative to the working directory if not absolute
+   static std::vector<std::string> absolutePath(const std::string & path) {
+      std::vector<std::string> components;
+      if (!path.empty() && path.front() == '/') {
+         components = splitPath(path);
+      } else {
+         char cwd[4096];
+         components = splitPath(std::string(getcwd(cwd, sizeof(cwd)) ? cwd : ".") + "/" + path);
+      }
+
+      // the parent of the root is the root
+      auto first = components.begin();
+      while(first != components.end() && *first == "..")
+         ++first;
+      return std::vector<std::string>(first, components.end());
+   }
+
+   //! Path of @p file relative to the directory containing @p reference (both relative to the working directory)
+   static std::string relativePath(const std::string & file, const std::string & reference) {
+      const auto target = absolutePath(file);
+      auto base = absolutePath(reference);
+      if (!base.empty())
+         base.pop_back(); // directory of reference
+
+      size_t common = 0;
+      while(common < base.size() && common < target.size() && base[common] == target[common])
+         common++;
+
+      std::string result;
+      for(size_t i = common; i < base.size(); i++)
+         result += "../";
+      for(size_t i = common; i < target.size(); i++)
+         result += target[i] + (i + 1 < target.size() ? "/" : "");
+      return result;
+   }
+
+   //! Path of @p file given relative to the directory containing @p reference, as valid in the working directory
+   static std::string resolvePath(const std::string & file, const std::string & reference) {
+      const size_t sep = reference.rfind('/');
+      if ((!file.empty() && file.front() == '/') || sep == std::string::npos)
+         return file;
+      return reference.substr(0, sep + 1) + file;
+   }
+
+   template <typename T>
+   void setParameter(const std::string & name, const T & value) {
+      std::ostringstream ss;
+      ss.precision(std::numeric_limits<double>::max_digits10);
+      ss << value;
+      parameters[name] = ss.str();
+   }
+
+   //! Write to @p filename; false on failure
+   bool write(const std::string & filename) const {
+      std::ofstream out(filename);
+      out << "model " << model << "\n"
+          << "vertices " << vertices << "\n"
+          << "positions " << positions << "\n"
+          << "data-width " << data_width << "\n";
+
+      for(const auto & part : parts)
+         out << "part " << relativePath(part, filename) << "\n";
+
+      for(const auto & param : parameters)
+         out << "param " << param.first << " " << param.second << "\n";
+
+      out.close();
+      return !out.fail();
+   }
+
+   //! Read from @p filename; false if it cannot be read or is incomplete
+   bool read(const std::string & filename) {
+      std::ifstream in(filename);
+      if (!in)
+         return false;
+
+      *this = GraphMetadata();
+      data_width = 0;
+
+      std::string line;
+      while(std::getline(in, line)) {
+         const size_t sep = line.find(' ');
+         if (sep == std::string::npos)
+            continue;
+
+         const std::string key = line.substr(0, sep);
+         const std::string value = line.substr(sep + 1);
+
+         if (key == "model") {
+            model = value;
+         } else if (key == "vertices") {
+            vertices = std::stoull(value);
+         } else if (key == "positions") {
+            positions = std::stoull(value);
+         } else if (key == "data-width") {
+            data_width = std::stoul(value);
+         } else if (key == "part") {
+            parts.push_back(resolvePath(value, filename));
+         } else if (key == "param") {
+            const size_t name_end = value.find(' ');
+            if (name_end != std::string::npos)
+               parameters[value.substr(0, name_end)] = value.substr(name_end + 1);
+         }
+      }
+
+      return !model.empty() && data_width && !parts.empty();
+   }
+
+   /**
+    * Number of vertices stored in the parts according to their file sizes;
+    * differs from positions if a part is missing or was not written completely
+    */
+   uint64_t storedPositions() const {
+      uint64_t bytes = 0;
+      for(const auto & part : parts) {
+         std::ifstream in(part, std::ios::binary | std::ios::ate);
+         if (in)
+            bytes += uint64_t(in.tellg());
+      }
+      return bytes / (data_width / 8);
+   }
+
+   /**
+    * True if a graph described by @p other can continue this one, i.e. the
+    * model, the width of the vertex ids and all parameters agree.
+    * The first mismatch is reported to @p os.
+    */
+   bool compatible(const GraphMetadata & other, std::ostream & os) const {
+      if (model != other.model) {
+         os << "model " << model << " cannot continue " << other.model << std::endl;
+         return false;
+      }
+
+      if (data_width != other.data_width) {
+         os << "vertex ids of " << data_width << " bits cannot continue " << other.data_width << " bits" << std::endl;
+         return false;
+      }
+
+      if (parameters != other.parameters) {
+         for(const auto & param : parameters) {
+            auto it = other.parameters.find(param.first);
+            if (it == other.parameters.end() || it->second != param.second) {
+               os << "parameter " << param.first << " is " << param.second << " but was "
+                  << (it == other.parameters.end() ? std::string("unset") : it->second) << std::endl;
+               return false;
+            }
+         }
+         os << "parameters do not match" << std::endl;
+         return false;
+      }
+
+      return true;
+   }
+};
+
+/**
+ * Answer query tokens into an existing edge list by a single sequential scan of
+ * its @p files (interpreted as concatenated binary edge lists).
+ *
+ * @p queries has to be sorted by id; all queries with an id below the length of
+ * the edge list are consumed, and for each of them the link token
+ * (false, requesting position, vertex at the queried position) is pushed into
+ * @p answers, i.e. it has the form of an answer of TFP.
+ *
+ * @return Number of positions scanned
+ */
+template <class QueryStream, class Sink>
+uint64_t answerPrefixQueries(const std::vector<std::string> & files, QueryStream & queries, Sink & answers) {
+   using token_type = typename QueryStream::value_type;
+
+   uint64_t position = 0;
+   for(const auto & file : files) {
+      readEdgeListFile(file, [&] (const DefaultFileDataType::data_type & node) {
+         const uint64_t vertex = DefaultFileDataType::toInternal(node);
+
+         for(; !queries.empty() && (*queries).id() == position; ++queries) {
+            assert((*queries).query());
+            answers.push(token_type(false, (*queries).value(), vertex));
+         }
+
+         position++;
+      });
+   }
+
+   return position;
+}
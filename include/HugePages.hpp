@@ -0,0 +1,168 @@
+/**
+ * @file
+ * @brief Back large heap allocations (STXXL blocks, buffers) with huge pages
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <unistd.h>
+#include <gnu/libc-version.h>
+
+#include <stxxl/bits/common/utils.h>
+
+/**
+ * @brief Back large heap allocations with transparent or explicit huge pages
+ *
+ * The sorters, the priority queue and the writers allocate their blocks
+ * through STXXL's aligned allocator, i.e. glibc's malloc, which is out of our
+ * reach. Instead, the glibc tunable glibc.malloc.hugetlb is used: it makes
+ * malloc advise THP for its mappings (Transparent) or map them with
+ * MAP_HUGETLB (Explicit2M, Explicit1G; pages have to be reserved by the admin).
+ * As glibc reads tunables only at start-up, enable() restarts the process
+ * once with GLIBC_TUNABLES extended.
+ */
+class HugePages {
+public:
+   enum Mode {
+      None,        //!< regular pages
+      Transparent, //!< madvise(MADV_HUGEPAGE); effective unless THP is "never"
+      Explicit2M,  //!< hugetlbfs pages of 2 MiB
+      Explicit1G   //!< hugetlbfs pages of 1 GiB
+   };
+
+protected:
+   static const char* _tunable(Mode mode) {
+      switch(mode) {
+         case Transparent: return "1";
+         case Explicit2M:  return "2097152";
+         case Explicit1G:  return "1073741824";
+         default:          return "0";
+      }
+   }
+
+   //! Number of free reserved pages of the size requested
+   static uint64_t _freePages(Mode mode) {
+      std::ifstream in(std::string("/sys/kernel/mm/hugepages/hugepages-")
+                       + (mode == Explicit1G ? "1048576" : "2048") + "kB/free_hugepages");
+      uint64_t pages = 0;
+      in >> pages;
+      return pages;
+   }
+
+public:
+   static Mode & selected() {
+      static Mode mode = None;
+      return mode;
+   }
+
+   //! Parse mode name ("none", "thp", "2m" or "1g"); returns false if unknown
+   static bool parseMode(const std::string & name, Mode & mode) {
+      if      (name == "none") mode = None;
+      else if (name == "thp")  mode = Transparent;
+      else if (name == "2m")   mode = Explicit2M;
+      else if (name == "1g")   mode = Explicit1G;
+      else return false;
+      return true;
+   }
+
+   /**
+    * Request huge pages for all subsequent large allocations.
+    * Has to be called before any of them (i.e. directly after parsing the
+    * command line) with the original @p argv, since the process is
+    * re-executed once; all output before the call is hence repeated.
+    * If the request cannot be fulfilled, a message is printed and the process continues.
+    */
+   static void enable(Mode mode, char* argv[]) {
+      selected() = mode;
+      if (mode == None)
+         return;
+
+      const char* tunables = getenv("GLIBC_TUNABLES");
+      std::string value(tunables ? tunables : "");
+
+      // already restarted (or set by the user)
+      if (value.find("glibc.malloc.hugetlb=") != std::string::npos)
+         return;
+
+      unsigned int major = 0, minor = 0;
+      if (sscanf(gnu_get_libc_version(), "%u.%u", &major, &minor) != 2 || major < 2 || (major == 2 && minor < 35)) {
+         STXXL_ERRMSG("Huge pages require glibc 2.35 or newer; found " << gnu_get_libc_version() << "; use regular pages");
+         selected() = None;
+         return;
+      }
+
+      if (mode != Transparent && !_freePages(mode))
+         STXXL_ERRMSG("No free huge pages of requested size reserved (see /sys/kernel/mm/hugepages); malloc falls back to regular pages");
+
+      if (!value.empty())
+         value += ":";
+      value += std::string("glibc.malloc.hugetlb=") + _tunable(mode);
+
+      if (setenv("GLIBC_TUNABLES", value.c_str(), 1)) {
+         STXXL_ERRMSG("Cannot set GLIBC_TUNABLES; use regular pages");
+         selected() = None;
+         return;
+      }
+
+      std::cout.flush();
+      std::cerr.flush();
+      execv("/proc/self/exe", argv);
+
+      STXXL_ERRMSG("Cannot restart with huge pages: " << strerror(errno) << "; use regular pages");
+      selected() = None;
+   }
+
+   /**
+    * Print the amount of resident memory backed by huge pages. Call it while
+    * the large buffers are allocated to see whether the request succeeded.
+    */
+   static void report(std::ostream & os = std::cout) {
+      if (selected() == None)
+         return;
+
+      uint64_t rss_kb = 0, thp_kb = 0, hugetlb_kb = 0;
+
+      std::ifstream smaps("/proc/self/smaps_rollup");
+      std::string key;
+      while(smaps >> key) {
+         uint64_t kb = 0;
+         if (key == "Rss:") {
+            smaps >> rss_kb;
+         } else if (key == "AnonHugePages:") {
+            smaps >> thp_kb;
+         } else if (key == "Private_Hugetlb:" || key == "Shared_Hugetlb:") {
+            smaps >> kb;
+            hugetlb_kb += kb;
+         }
+         smaps.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+      }
+
+      os << "Huge pages: " << (thp_kb >> 10) << " MiB transparent, " << (hugetlb_kb >> 10) << " MiB hugetlb; "
+         << (rss_kb >> 10) << " MiB resident in total" << std::endl;
+
+      if (!thp_kb && !hugetlb_kb)
+         STXXL_ERRMSG("Huge pages were requested, but no memory is backed by them");
+   }
+};
@@ -0,0 +1,202 @@
+/**
+ * @file
+ * @brief Minimal wrapper of the Linux io_uring interface
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+   #include <linux/io_uring.h>
+   #define TFP_HAVE_IO_URING 1
+#endif
+
+#include <stxxl/io>
+#include <stxxl/bits/common/utils.h>
+
+#ifdef TFP_HAVE_IO_URING
+
+/**
+ * @brief Minimal wrapper of the Linux io_uring interface
+ *
+ * Sets up a submission and completion ring via the raw system calls, so
+ * neither liburing nor a recent libc is required. Only a single thread
+ * may use an instance.
+ */
+class IoUring {
+protected:
+   int _fd;
+   unsigned int _entries;
+
+   // submission ring
+   void* _sq_ptr;
+   size_t _sq_size;
+   unsigned* _sq_head;
+   unsigned* _sq_tail;
+   unsigned* _sq_mask;
+   unsigned* _sq_array;
+   io_uring_sqe* _sqes;
+   size_t _sqes_size;
+   unsigned int _to_submit;
+
+   // completion ring
+   void* _cq_ptr;
+   size_t _cq_size;
+   unsigned* _cq_head;
+   unsigned* _cq_tail;
+   unsigned* _cq_mask;
+   io_uring_cqe* _cqes;
+
+   int _enter(unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+      int res;
+      do {
+         res = int(syscall(__NR_io_uring_enter, _fd, to_submit, min_complete, flags, nullptr, 0));
+      } while(res < 0 && errno == EINTR);
+      return res;
+   }
+
+   static void* _map(int fd, size_t size, off_t offset) {
+      void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+      if (ptr == MAP_FAILED)
+         STXXL_THROW_ERRNO(stxxl::io_error, "Cannot map io_uring");
+      return ptr;
+   }
+
+public:
+   //! @param entries  Queue depth, i.e. maximum number of requests in flight
+   explicit IoUring(unsigned int entries)
+      : _fd(-1)
+      , _sq_ptr(MAP_FAILED)
+      , _sqes(static_cast<io_uring_sqe*>(MAP_FAILED))
+      , _to_submit(0)
+      , _cq_ptr(MAP_FAILED)
+   {
+      io_uring_params params;
+      std::memset(&params, 0, sizeof(params));
+
+      _fd = int(syscall(__NR_io_uring_setup, entries, &params));
+      if (_fd < 0)
+         STXXL_THROW_ERRNO(stxxl::io_error, "Cannot setup io_uring");
+
+      _entries = params.sq_entries;
+
+      _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      _sq_ptr = _map(_fd, _sq_size, IORING_OFF_SQ_RING);
+      char* sq = static_cast<char*>(_sq_ptr);
+      _sq_head  = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+      _sq_tail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+      _sq_mask  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+      _sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+      _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+      _sqes = static_cast<io_uring_sqe*>(_map(_fd, _sqes_size, IORING_OFF_SQES));
+
+      _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      _cq_ptr = _map(_fd, _cq_size, IORING_OFF_CQ_RING);
+      char* cq = static_cast<char*>(_cq_ptr);
+      _cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+      _cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+      _cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+      _cqes    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+   }
+
+   IoUring(const IoUring &) = delete;
+
+   ~IoUring() {
+      if (_cq_ptr != MAP_FAILED) munmap(_cq_ptr, _cq_size);
+      if (_sqes != MAP_FAILED) munmap(_sqes, _sqes_size);
+      if (_sq_ptr != MAP_FAILED) munmap(_sq_ptr, _sq_size);
+      if (_fd >= 0) close(_fd);
+   }
+
+   //! True if the kernel provides io_uring and it is not blocked (e.g. by seccomp)
+   static bool available() {
+      static const bool result = [] () {
+         io_uring_params params;
+         std::memset(&params, 0, sizeof(params));
+         const int fd = int(syscall(__NR_io_uring_setup, 1, &params));
+         if (fd < 0) return false;
+         close(fd);
+         return true;
+      }();
+      return result;
+   }
+
+   unsigned int entries() const {
+      return _entries;
+   }
+
+   /**
+    * Register fixed buffers to avoid the per-request page mapping;
+    * returns false if not permitted (e.g. due to RLIMIT_MEMLOCK)
+    */
+   bool registerBuffers(const std::vector<iovec> & buffers) {
+      return !syscall(__NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS,
+                      buffers.data(), unsigned(buffers.size()));
+   }
+
+   //! Obtain a cleared submission entry; at most entries() requests may be in flight
+   io_uring_sqe & prepare() {
+      const unsigned int tail = *_sq_tail + _to_submit;
+      assert(tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) < _entries);
+
+      const unsigned int idx = tail & *_sq_mask;
+      io_uring_sqe & sqe = _sqes[idx];
+      std::memset(&sqe, 0, sizeof(sqe));
+      _sq_array[idx] = idx;
+      _to_submit++;
+
+      return sqe;
+   }
+
+   //! Pass all prepared entries to the kernel
+   void submit() {
+      if (!_to_submit) return;
+
+      __atomic_store_n(_sq_tail, *_sq_tail + _to_submit, __ATOMIC_RELEASE);
+      const int res = _enter(_to_submit, 0, 0);
+      if (res < 0)
+         STXXL_THROW_ERRNO(stxxl::io_error, "io_uring_enter failed");
+
+      _to_submit = 0;
+   }
+
+   //! Block until a completion is available and remove it; all entries have to be submitted
+   io_uring_cqe wait() {
+      assert(!_to_submit);
+      for(;;) {
+         const unsigned int head = *_cq_head;
+         if (head != __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe cqe = _cqes[head & *_cq_mask];
+            __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+            return cqe;
+         }
+
+         if (_enter(0, 1, IORING_ENTER_GETEVENTS) < 0)
+            STXXL_THROW_ERRNO(stxxl::io_error, "io_uring_enter failed");
+      }
+   }
+};
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @brief Direct-addressed ring buffer for answers to queries of the near future
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Direct-addressed ring buffer for answers to queries of the near future
+ *
+ * The window covers the edge list positions [current, current + size()).
+ * An answer targeting a covered position can be stored in its slot rather
+ * than being pushed as a link token into the priority queue. Since every
+ * position receives at most one answer and slots are cleared when taken,
+ * no further bookkeeping is required.
+ *
+ * A window of size 0 is disabled, i.e. it covers no position.
+ */
+template <typename T = uint64_t>
+class LookaheadWindow {
+public:
+   using value_type = T;
+
+protected:
+   static constexpr T _empty_slot = std::numeric_limits<T>::max();
+
+   uint64_t _size;
+   uint64_t _mask;
+   std::vector<T> _slots;
+
+   uint64_t _hits;
+
+public:
+   //! @param size Number of positions covered; rounded up to the next power of two
+   explicit LookaheadWindow(uint64_t size = 0)
+      : _size(0)
+      , _hits(0)
+   {
+      if (size) {
+         _size = 1;
+         while(_size < size) _size <<= 1;
+      }
+
+      // a disabled window keeps one (always empty) slot to avoid a branch in has()
+      _mask = _size ? _size - 1 : 0;
+      _slots.assign(_size ? _size : 1, _empty_slot);
+   }
+
+   //! Number of positions covered
+   uint64_t size() const {
+      return _size;
+   }
+
+   //! True if position @p idx may be stored while @p current is the next position to be produced
+   bool covers(uint64_t current, uint64_t idx) const {
+      assert(idx >= current);
+      return idx - current < _size;
+   }
+
+   //! Store answer for position @p idx; it has to be covered
+   void put(uint64_t idx, const T & value) {
+      assert(_size);
+      assert(_slots[idx & _mask] == _empty_slot);
+      _slots[idx & _mask] = value;
+      _hits++;
+   }
+
+   //! True if an answer for position @p idx is stored
+   bool has(uint64_t idx) const {
+      return _slots[idx & _mask] != _empty_slot;
+   }
+
+   //! Remove and return answer for position @p idx
+   T take(uint64_t idx) {
+      assert(has(idx));
+      const T value = _slots[idx & _mask];
+      _slots[idx & _mask] = _empty_slot;
+      return value;
+   }
+
+   //! Number of answers stored in the window so far
+   uint64_t hits() const {
+      return _hits;
+   }
+};
+
+template <typename T>
+constexpr T LookaheadWindow<T>::_empty_slot;
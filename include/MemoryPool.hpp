@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @brief Internal memory budget shared by the phases of a generator run
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Accounting of a fixed memory budget handed from one phase to the next
+ *
+ * Sorters and priority queues allocate their buffers themselves; the pool
+ * only decides how many bytes each of them is told to use. A component leases
+ * its share when it is set up and returns it (by releasing or destroying the
+ * Lease) once the phase that needs it is over, so a later phase can use it.
+ * In the generators this means that the run formation of the token sorter
+ * gets the whole budget, the PQ inherits it once the tokens are sorted, and
+ * the edge sorter merges with the memory of the PQ after TFP completed.
+ *
+ * A lease beyond the memory available is an error, so a phase that needs a
+ * minimum amount has to reserve it (by leasing it early) before earlier phases
+ * take what is left. The pool is not thread-safe and is only used by the thread
+ * setting up the phases.
+ */
+class MemoryPool {
+public:
+   //! Share of the pool; returned on destruction
+   class Lease {
+      MemoryPool * _pool;
+      uint64_t _bytes;
+
+   public:
+      Lease() : _pool(nullptr), _bytes(0) {}
+      Lease(MemoryPool & pool, uint64_t bytes) : _pool(&pool), _bytes(bytes) {}
+
+      Lease(const Lease &) = delete;
+      Lease & operator=(const Lease &) = delete;
+
+      Lease(Lease && other) : _pool(other._pool), _bytes(other._bytes) {
+         other._bytes = 0;
+      }
+
+      Lease & operator=(Lease && other) {
+         if (this != &other) {
+            release();
+            _pool = other._pool;
+            _bytes = other._bytes;
+            other._bytes = 0;
+         }
+         return *this;
+      }
+
+      ~Lease() {release();}
+
+      uint64_t bytes() const {return _bytes;}
+
+      //! Return the memory to the pool; idempotent
+      void release() {
+         if (_pool && _bytes)
+            _pool->_leased -= _bytes;
+         _bytes = 0;
+      }
+   };
+
+protected:
+   const uint64_t _total;
+   uint64_t _leased;
+   uint64_t _peak;
+
+public:
+   explicit MemoryPool(uint64_t total)
+      : _total(total)
+      , _leased(0)
+      , _peak(0)
+   {}
+
+   MemoryPool(const MemoryPool &) = delete;
+
+   //! Lease @p bytes; throws std::length_error if less is available
+   Lease lease(uint64_t bytes) {
+      if (bytes > available()) {
+         std::stringstream ss;
+         ss << "Memory budget exceeded: " << (bytes >> 20) << " MiB requested, but only "
+            << (available() >> 20) << " MiB of " << (_total >> 20) << " MiB available";
+         throw std::length_error(ss.str());
+      }
+
+      _leased += bytes;
+      _peak = std::max(_peak, _leased);
+      return Lease(*this, bytes);
+   }
+
+   /**
+    * Lease @p bytes for a consumer that needs at least @p minimum bytes, e.g. a sorter taking
+    * what is left in the pool; throws std::length_error if fewer are requested or available
+    */
+   Lease lease(uint64_t bytes, uint64_t minimum) {
+      if (bytes < minimum) {
+         std::stringstream ss;
+         ss << "Memory budget too small: " << (bytes >> 20) << " MiB left, but at least "
+            << (minimum >> 20) << " MiB required";
+         throw std::length_error(ss.str());
+      }
+
+      return lease(bytes);
+   }
+
+   uint64_t total() const {return _total;}
+   uint64_t leased() const {return _leased;}
+   uint64_t available() const {return _total - _leased;}
+
+   //! Largest amount leased at the same time
+   uint64_t peak() const {return _peak;}
+
+   /**
+    * Memory an external sorter needs at least: STXXL's sorter refuses less than two blocks
+    * per sort_memory_usage_factor for run formation and merging (8 MiB with the default
+    * blocks of 2 MiB); we keep twice that. A phase starting a sorter with what is left in the
+    * pool has to reserve this amount beforehand.
+    */
+   static uint64_t sorterMinimumMemory() {
+      return uint64_t(16) << 20;
+   }
+
+   /**
+    * Memory held by an external sorter after sort() until it is read: if all
+    * @p data bytes fit into a single run they stay in RAM, otherwise the merge
+    * buffers are allocated and the run buffers are freed.
+    */
+   static uint64_t sorterMemoryAfterSort(uint64_t data, uint64_t run_memory, uint64_t merge_memory) {
+      return (data <= run_memory) ? data : merge_memory;
+   }
+
+   //! Print "<what>: <lease> MiB (<available> MiB left)" to track the phases
+   void report(std::ostream & os, const std::string & what, const Lease & lease) const {
+      os << "Memory for " << what << ": " << (lease.bytes() >> 20) << " MiB ("
+         << (available() >> 20) << " MiB left)" << std::endl;
+   }
+};
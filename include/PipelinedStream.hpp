@@ -0,0 +1,162 @@
+/**
+ * @file
+ * @brief Stream adaptor evaluating its input on a separate thread
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include <stxxl/bits/common/utils.h>
+
+#include <SPSCQueue.hpp>
+
+/**
+ * @brief Runs an STXXL stream on its own thread and hands its elements over in blocks
+ *
+ * A producer thread consumes the input stream, fills blocks of block_size
+ * elements and passes them through an SPSCQueue; the consumer (the owner of this
+ * object) reads them via the usual STXXL streaming interface. Empty blocks
+ * are returned through a second queue and reused, so after start-up no memory
+ * is allocated and at most @p depth blocks are in flight, which bounds the
+ * distance by which the producer may run ahead.
+ *
+ * Chaining several adaptors yields a pipeline with one thread per stage; as
+ * each stage processes its elements in their original order, the output is
+ * identical to the sequential evaluation.
+ *
+ * The input stream is owned by the producer thread until this stream is
+ * empty (the thread is joined then), so the caller must not touch it earlier.
+ * An exception thrown by the input stream is re-thrown by the consumer once
+ * all elements produced before reached it.
+ */
+template <class InputStream>
+class PipelinedStream {
+public:
+   using value_type = typename InputStream::value_type;
+   using block_type = std::vector<value_type>;
+
+   //! 64Ki elements, i.e. 512 KiB of 64-bit tokens: large enough to amortise the hand-over
+   static constexpr size_t default_block_size = 1 << 16;
+   static constexpr size_t default_depth = 4;
+
+protected:
+   const size_t _block_size;
+
+   SPSCQueue<block_type> _full;  //!< producer -> consumer; an empty block terminates
+   SPSCQueue<block_type> _free;  //!< consumer -> producer
+
+   std::atomic<bool> _stop;
+   std::exception_ptr _error;
+   std::thread _producer;
+
+   block_type _block;
+   size_t _pos;
+   bool _empty;
+
+   void _produce(InputStream & input) {
+      block_type block;
+      try {
+         while(!input.empty() && !_stop.load(std::memory_order_relaxed)) {
+            block = _free.pop();
+            block.clear();
+
+            for(; block.size() < _block_size && !input.empty(); ++input)
+               block.push_back(*input);
+
+            _full.push(std::move(block));
+         }
+      } catch (...) {
+         // hand over the elements produced before the failure
+         _error = std::current_exception();
+         if (!block.empty())
+            _full.push(std::move(block));
+      }
+
+      _full.push(block_type());
+   }
+
+   //! Recycle the current block and wait for the next one
+   void _fetch() {
+      if (_block.capacity())
+         _free.push(std::move(_block));
+
+      _block = _full.pop();
+      _pos = 0;
+
+      if (UNLIKELY(_block.empty())) {
+         _empty = true;
+         _producer.join();
+         if (_error)
+            std::rethrow_exception(_error);
+      }
+   }
+
+public:
+   /**
+    * @param input       Stream evaluated by the producer thread
+    * @param block_size  Number of elements per hand-over
+    * @param depth       Number of blocks in flight
+    */
+   explicit PipelinedStream(InputStream & input, size_t block_size = default_block_size, size_t depth = default_depth)
+      : _block_size(block_size)
+      , _full(depth + 1)
+      , _free(depth + 1)
+      , _stop(false)
+      , _pos(0)
+      , _empty(false)
+   {
+      for(size_t i = 0; i < depth; i++) {
+         block_type block;
+         block.reserve(block_size);
+         _free.push(std::move(block));
+      }
+
+      _producer = std::thread([this, &input] {_produce(input);});
+      _fetch();
+   }
+
+   PipelinedStream(const PipelinedStream &) = delete;
+   PipelinedStream & operator=(const PipelinedStream &) = delete;
+
+   //! Stops the producer if the stream was not consumed completely
+   ~PipelinedStream() {
+      if (_empty)
+         return;
+
+      _stop.store(true, std::memory_order_relaxed);
+      while(!_block.empty()) {
+         _free.push(std::move(_block));
+         _block = _full.pop();
+      }
+      _producer.join();
+   }
+
+//! @name STXXL Streaming Interface
+//! @{
+   bool empty() const {return _empty;}
+   const value_type & operator*() const {return _block[_pos];}
+
+   PipelinedStream & operator++() {
+      if (UNLIKELY(++_pos == _block.size()))
+         _fetch();
+      return *this;
+   }
+//! @}
+};
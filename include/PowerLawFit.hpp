@@ -0,0 +1,247 @@
+/**
+ * @file
+ * @brief Discrete power-law fit, CCDF and log-binned output of a degree distribution
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Discrete power-law fit following Clauset, Shalizi and Newman (2009)
+ *
+ * The (degree, count) pairs produced by DistributionCount are pushed in
+ * ascending order while they are written; as the number of distinct degrees
+ * is small, they are kept in memory. For each candidate x_min, alpha is the
+ * maximum likelihood estimate of the discrete power law
+ *    P(X = x) = x^-alpha / zeta(alpha, x_min)
+ * on the tail x >= x_min; x_min minimises the Kolmogorov-Smirnov distance
+ * between the empirical and the fitted tail distribution.
+ */
+class PowerLawFit {
+public:
+   using histogram_type = std::vector<std::pair<uint64_t, uint64_t>>;
+
+   struct Result {
+      bool valid;           //!< false if no tail was large enough
+      double alpha;
+      uint64_t x_min;
+      double ks_distance;
+      uint64_t tail_size;   //!< number of samples >= x_min
+   };
+
+protected:
+   histogram_type _histogram; //!< (value, count) in ascending order of values
+   uint64_t _total;
+
+   //! Bounds of the golden-section search for alpha
+   static constexpr double _min_alpha = 1.0 + 1e-6;
+   static constexpr double _max_alpha = 10.0;
+
+   //! Maximise the log-likelihood of the tail starting at @p x_min
+   static double _estimateAlpha(uint64_t x_min, uint64_t n, double log_sum) {
+      auto log_likelihood = [&] (double alpha) {
+         return -double(n) * std::log(hurwitzZeta(alpha, double(x_min))) - alpha * log_sum;
+      };
+
+      const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+      double a = _min_alpha, b = _max_alpha;
+      double c = b - ratio * (b - a), d = a + ratio * (b - a);
+      double fc = log_likelihood(c), fd = log_likelihood(d);
+
+      while(b - a > 1e-7) {
+         if (fc > fd) {
+            b = d; d = c; fd = fc;
+            c = b - ratio * (b - a);
+            fc = log_likelihood(c);
+         } else {
+            a = c; c = d; fc = fd;
+            d = a + ratio * (b - a);
+            fd = log_likelihood(d);
+         }
+      }
+
+      return (a + b) / 2;
+   }
+
+   //! KS distance of the tail starting at histogram index @p first with @p n samples
+   double _ksDistance(size_t first, uint64_t n, double alpha) const {
+      const double x_min = double(_histogram[first].first);
+      const double norm = hurwitzZeta(alpha, x_min);
+
+      double distance = 0.0;
+      uint64_t remaining = n;           // samples >= current value
+      double zeta = norm;               // zeta(alpha, current value)
+      double zeta_at = x_min;
+
+      for(size_t i = first; i < _histogram.size(); i++) {
+         const double x = double(_histogram[i].first);
+
+         // advance zeta(alpha, .) to x; short gaps by subtraction, long ones directly
+         if (x - zeta_at <= 32.0) {
+            for(; zeta_at < x; zeta_at += 1.0)
+               zeta -= std::pow(zeta_at, -alpha);
+         } else {
+            zeta = hurwitzZeta(alpha, x);
+            zeta_at = x;
+         }
+
+         const double empirical_ge = double(remaining) / n;
+         remaining -= _histogram[i].second;
+         const double empirical_gt = double(remaining) / n;
+
+         const double model_ge = zeta / norm;
+         const double model_gt = (zeta - std::pow(x, -alpha)) / norm;
+
+         distance = std::max(distance, std::max(std::fabs(empirical_ge - model_ge),
+                                                std::fabs(empirical_gt - model_gt)));
+      }
+
+      return distance;
+   }
+
+public:
+   PowerLawFit() : _total(0) {}
+
+   /**
+    * Hurwitz zeta function zeta(s, q) = sum_{k>=0} (k + q)^-s for s > 1, q > 0
+    * by Euler-Maclaurin summation; relative error below 1e-12.
+    */
+   static double hurwitzZeta(double s, double q) {
+      double sum = 0.0;
+      for(; q < 10.0; q += 1.0)
+         sum += std::pow(q, -s);
+
+      // Euler-Maclaurin tail with Bernoulli numbers B_2 .. B_8
+      const double power = std::pow(q, -s);
+      sum += q * power / (s - 1.0) + power / 2.0;
+
+      static const double coefficients[] = {1.0 / 12, -1.0 / 720, 1.0 / 30240, -1.0 / 1209600};
+      double rising = s;            // s (s+1) ... (s+2j-2)
+      double q_power = power / q;   // q^(-s-2j+1)
+      for(unsigned int j = 0; j < 4; j++) {
+         sum += coefficients[j] * rising * q_power;
+         rising *= (s + 2 * j + 1) * (s + 2 * j + 2);
+         q_power /= q * q;
+      }
+
+      return sum;
+   }
+
+   //! Account @p count samples of value @p value; values have to be pushed in ascending order
+   void push(uint64_t value, uint64_t count) {
+      assert(_histogram.empty() || _histogram.back().first < value);
+      if (!count) return;
+      _histogram.emplace_back(value, count);
+      _total += count;
+   }
+
+   const histogram_type & histogram() const {
+      return _histogram;
+   }
+
+   uint64_t totalCount() const {
+      return _total;
+   }
+
+   /**
+    * Fit the power law.
+    * @param min_tail  Smallest number of samples >= x_min considered
+    * @param candidates_per_decade  The 100 smallest distinct values are candidates for x_min;
+    *                  beyond, candidates are thinned out to this many per decade
+    */
+   Result fit(uint64_t min_tail = 50, unsigned int candidates_per_decade = 20) const {
+      Result best{false, 0.0, 0, 1.0, 0};
+
+      // suffix sums of counts and count * ln(value)
+      const size_t k = _histogram.size();
+      std::vector<uint64_t> tail_count(k + 1, 0);
+      std::vector<double> tail_log_sum(k + 1, 0.0);
+      for(size_t i = k; i--; ) {
+         tail_count[i] = tail_count[i + 1] + _histogram[i].second;
+         tail_log_sum[i] = tail_log_sum[i + 1] + _histogram[i].second * std::log(double(_histogram[i].first));
+      }
+
+      const double step = std::pow(10.0, 1.0 / candidates_per_decade);
+      double next_candidate = 0.0;
+
+      for(size_t i = 0; i < k && tail_count[i] >= min_tail; i++) {
+         const uint64_t x_min = _histogram[i].first;
+         if (!x_min) continue;
+
+         if (i >= 100) {
+            if (x_min < next_candidate) continue;
+            next_candidate = x_min * step;
+         }
+
+         const double alpha = _estimateAlpha(x_min, tail_count[i], tail_log_sum[i]);
+         const double distance = _ksDistance(i, tail_count[i], alpha);
+
+         if (!best.valid || distance < best.ks_distance)
+            best = Result{true, alpha, x_min, distance, tail_count[i]};
+      }
+
+      return best;
+   }
+
+   //! Write lines "value P(X >= value)"
+   void writeCCDF(std::ostream & os) const {
+      uint64_t remaining = _total;
+      for(const auto & bin : _histogram) {
+         os << bin.first << " " << (double(remaining) / _total) << "\n";
+         remaining -= bin.second;
+      }
+      os.flush();
+   }
+
+   /**
+    * Write lines "lower upper center density" of logarithmic bins [lower, upper)
+    * with @p bins_per_decade bins per decade; the density is normalised by the
+    * number of integers in the bin. Empty bins are skipped; value 0 forms its own bin.
+    */
+   void writeLogBinned(std::ostream & os, unsigned int bins_per_decade = 10) const {
+      const double factor = std::pow(10.0, 1.0 / bins_per_decade);
+
+      auto it = _histogram.begin();
+      if (it != _histogram.end() && it->first == 0) {
+         os << "0 1 0 " << (double(it->second) / _total) << "\n";
+         ++it;
+      }
+
+      double lower = 1.0;
+      while(it != _histogram.end()) {
+         const double upper = lower * factor;
+         const uint64_t first_int = uint64_t(std::ceil(lower));
+         const uint64_t end_int = uint64_t(std::ceil(upper));
+
+         uint64_t count = 0;
+         for(; it != _histogram.end() && it->first < end_int; ++it)
+            count += it->second;
+
+         if (count && end_int > first_int)
+            os << lower << " " << upper << " " << std::sqrt(lower * upper) << " "
+               << (double(count) / _total / double(end_int - first_int)) << "\n";
+
+         lower = upper;
+      }
+      os.flush();
+   }
+};
@@ -0,0 +1,173 @@
+/**
+ * @file
+ * @brief TFP main loop for Barabasi-Albert graphs with implicit regular vertices
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <stxxl/bits/common/utils.h>
+#include <Token.hpp>
+#include <BAEdgeListLayout.hpp>
+#include <LookaheadWindow.hpp>
+
+/**
+ * @brief TFP main loop for Barabasi-Albert graphs with implicit regular vertices
+ *
+ * Semantically equivalent to a ProcessTokenSequence fed by the merge of
+ * InitialCircle, RegularVertexTokenStream and the random tokens. Here, however,
+ * the vertices at implicit positions (see BAEdgeListLayout) are computed on the
+ * fly, so only the random tokens have to be merged with the priority queue.
+ *
+ * The input stream contains the query tokens and optionally link tokens for
+ * non-implicit positions (e.g. answers received from other processes).
+ * Answers to positions covered by the lookahead window bypass the priority queue.
+ */
+template <class InputStream, class PriorityQueue, class Token = Token64>
+class ProcessImplicitTokenSequence {
+public:
+   using value_type = uint64_t;
+   using token_type = Token;
+
+protected:
+   InputStream & _stream;
+   PriorityQueue & _prio_queue;
+   const BAEdgeListLayout _layout;
+
+   uint64_t _current_idx;
+   const uint64_t _end_idx;
+   bool _empty;
+   uint64_t _current_vertex;
+
+   // the regular vertex is tracked incrementally to avoid a division per token
+   uint64_t _regular_vertex;
+   uint64_t _next_regular_vertex_idx;
+
+   LookaheadWindow<uint64_t> _window;
+
+   //! Obtain link token of a non-implicit position from stream or PQ
+   uint64_t _fetchLink() {
+      if (_window.has(_current_idx)) {
+         return _window.take(_current_idx);
+
+      } else if (!_stream.empty() && (_prio_queue.empty() || *_stream < _prio_queue.top())) {
+         const Token & token = *_stream;
+         assert(!token.query() && token.id() == _current_idx);
+         const uint64_t vertex = token.value();
+         ++_stream;
+         return vertex;
+
+      } else {
+         assert(!_prio_queue.empty());
+         const Token & token = _prio_queue.top();
+         assert(!token.query() && token.id() == _current_idx);
+         const uint64_t vertex = token.value();
+         _prio_queue.pop();
+         return vertex;
+      }
+   }
+
+public:
+   /**
+    * @param stream     Sorted stream of query tokens (and non-implicit link tokens)
+    * @param pq         Priority queue used to reinsert answered queries
+    * @param layout     Describes the implicit positions
+    * @param first_idx  Edge list position of the first vertex produced
+    * @param end_idx    Edge list position past the last vertex produced
+    * @param window_size Number of positions covered by the lookahead window; 0 disables it
+    */
+   ProcessImplicitTokenSequence(InputStream& stream, PriorityQueue & pq, const BAEdgeListLayout & layout,
+                                uint64_t first_idx, uint64_t end_idx, uint64_t window_size = 0)
+      : _stream(stream)
+      , _prio_queue(pq)
+      , _layout(layout)
+      , _current_idx(first_idx)
+      , _end_idx(end_idx)
+      , _empty(false)
+      , _window(window_size)
+   {
+      // first even position after the seed circle
+      const uint64_t idx = std::max(first_idx + (first_idx & 1), _layout.firstRandomIdx());
+      _regular_vertex = _layout.vertex(idx);
+      _next_regular_vertex_idx = _layout.firstIdxOfRandomVertex(_regular_vertex - _layout.seedVertices() + 1);
+
+      ++(*this);
+   }
+
+   //! Number of answers passed through the lookahead window rather than the PQ
+   uint64_t windowHits() const {
+      return _window.hits();
+   }
+
+//! @name STXXL Streaming Interface
+//! @{
+   //! Compute next token
+   ProcessImplicitTokenSequence & operator++() {
+      if (UNLIKELY(_current_idx >= _end_idx)) {
+         assert(_stream.empty() && _prio_queue.empty());
+         _empty = true;
+         return *this;
+      }
+
+      // produce vertex at current position
+      if (_current_idx & 1) {
+         if (UNLIKELY(_current_idx < _layout.firstRandomIdx()))
+            _current_vertex = _layout.vertex(_current_idx);
+         else
+            _current_vertex = _fetchLink();
+
+      } else {
+         if (UNLIKELY(_current_idx < _layout.firstRandomIdx())) {
+            _current_vertex = _layout.vertex(_current_idx);
+
+         } else {
+            if (UNLIKELY(_current_idx >= _next_regular_vertex_idx)) {
+               _regular_vertex++;
+               _next_regular_vertex_idx += 2 * _layout.edgesPerVertex();
+            }
+            _current_vertex = _regular_vertex;
+         }
+      }
+
+      _current_idx++;
+
+      // answer all queries to it; requests of other processes always go to the PQ
+      while(!_stream.empty() && (*_stream).id() + 1 == _current_idx) {
+         const Token & token = *_stream;
+         assert(token.query());
+
+         if (_window.covers(_current_idx, token.value()) && token.value() < _end_idx)
+            _window.put(token.value(), _current_vertex);
+         else
+            _prio_queue.push(Token(false, token.value(), _current_vertex));
+
+         ++_stream;
+      }
+
+      return *this;
+   }
+
+   //! Indicates whether the last increment operation generated a valid value
+   bool empty() const {
+      return _empty;
+   }
+
+   //! Constant reference to the current token (valid only in case !empty)
+   const value_type & operator*() const {
+      return _current_vertex;
+   }
+//! @}
+};
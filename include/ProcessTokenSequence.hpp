@@ -20,13 +20,15 @@
 
 #include <stxxl/bits/common/utils.h>
 #include <Token.hpp>
+#include <LookaheadWindow.hpp>
 
 /**
  * @brief Main loop of TFP processing, i.e. materialize edge and answer queries
  *
  * Given a stream of tokens, create tokens cause that a vertex is written into the
  * edge list while query tokens look-up the last value written and get reinserted
- * into the priority queue. For more details see
+ * into the priority queue. Answers to positions covered by the lookahead window are
+ * stored directly in it instead of the priority queue. For more details see
  * "Generating Massive Scale-Free Networks under Resource Constraints" by U.Meyer/M.Penschuck
  */
 template <class InputStream, class PriorityQueue, class Token = Token64>
@@ -43,12 +45,18 @@ protected:
    bool _empty;
    uint64_t _current_vertex;
 
+   LookaheadWindow<uint64_t> _window;
+
    //! Returns false if a new vertex was "produced"
    bool _processToken(const Token & token) {
       if (token.query()) {
          assert(_current_idx -1 == token.id());
-         Token64 new_token(false, token.value(), _current_vertex);
-         _prio_queue.push(new_token);
+         if (_window.covers(_current_idx, token.value())) {
+            _window.put(token.value(), _current_vertex);
+         } else {
+            Token64 new_token(false, token.value(), _current_vertex);
+            _prio_queue.push(new_token);
+         }
          return true;
 
       } else {
@@ -60,20 +68,40 @@ protected:
    }
 
 public:
-   ProcessTokenSequence(InputStream& stream, PriorityQueue & pq)
+   /**
+    * @param stream     Sorted stream of tokens
+    * @param pq         Priority queue used to reinsert answered queries
+    * @param first_idx  Edge list position of the first vertex produced (non-zero if only a suffix is processed)
+    * @param window_size Number of positions covered by the lookahead window; 0 disables it
+    */
+   ProcessTokenSequence(InputStream& stream, PriorityQueue & pq, uint64_t first_idx = 0, uint64_t window_size = 0)
       : _stream(stream)
       , _prio_queue(pq)
-      , _current_idx(0)
+      , _current_idx(first_idx)
       , _empty(false)
+      , _window(window_size)
    {++(*this);}
 
+   //! Number of answers passed through the lookahead window rather than the PQ
+   uint64_t windowHits() const {
+      return _window.hits();
+   }
+
 //! @name STXXL Streaming Interface
 //! @{
    //! Compute next token
    ProcessTokenSequence & operator++() {
       bool repeat = true;
       while(repeat) {
-         if (_prio_queue.empty() && _stream.empty()) {
+         if (_window.has(_current_idx)
+             && (_stream.empty() || (*_stream).id() >= _current_idx)
+             && (_prio_queue.empty() || _prio_queue.top().id() >= _current_idx)) {
+            // all queries to the previous position are answered, so the
+            // current one can be taken from the window
+            _current_vertex = _window.take(_current_idx);
+            _current_idx++;
+            repeat = false;
+         } else if (_prio_queue.empty() && _stream.empty()) {
             _empty = true;
             repeat = false;
          } else if (_prio_queue.empty()) {
@@ -0,0 +1,154 @@
+/**
+ * @file
+ * @brief Stateless random-access generation of Barabasi-Albert edge lists
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+#include <BAEdgeListLayout.hpp>
+#include <CounterHashRandom.hpp>
+
+/**
+ * @brief Stateless random-access generation of Barabasi-Albert edge lists
+ *
+ * The random position at index idx copies the vertex of a position drawn
+ * uniformly from [0, weight) by a counter-based hash of idx; the weight is
+ * the same as the one used by the TFP generator. If the drawn position is
+ * random as well, the chain is followed until an implicit position is reached
+ * (see BAEdgeListLayout). As half of all positions are implicit, a chain has
+ * 2 steps in expectation.
+ *
+ * Hence the vertex at any position is computed without sorter or PQ; each range
+ * of the edge list can be generated independently and without communication.
+ * The graphs follow the same distribution as the TFP generator's, but, due
+ * to the different source of randomness, are not identical to them.
+ */
+class RandomAccessBA {
+protected:
+   const BAEdgeListLayout _layout;
+   const bool _edge_dependencies;
+   const CounterHashRandom _random;
+
+public:
+   using edge_type = std::pair<uint64_t, uint64_t>;
+
+   /**
+    * @param layout             Layout of the edge list
+    * @param edge_dependencies  Edges of a vertex may point to the positions of its earlier edges
+    * @param seed               Seed of the counter-based RNG; equal seeds yield equal graphs
+    */
+   RandomAccessBA(const BAEdgeListLayout & layout, bool edge_dependencies, uint64_t seed)
+      : _layout(layout)
+      , _edge_dependencies(edge_dependencies)
+      , _random(seed)
+   {}
+
+   const BAEdgeListLayout & layout() const {return _layout;}
+
+   //! Position queried by the random position @p idx
+   uint64_t queryPosition(uint64_t idx) const {
+      assert(!_layout.implicit(idx));
+
+      const uint64_t relative = idx - _layout.firstRandomIdx();
+      const uint64_t epv2 = 2 * _layout.edgesPerVertex();
+      const uint64_t vertex = relative / epv2;
+      const uint64_t edge = (relative % epv2) / 2;
+
+      const uint64_t weight = _layout.firstIdxOfRandomVertex(vertex) + 2 * edge * _edge_dependencies;
+      return _random(idx, weight);
+   }
+
+   //! Vertex at edge list position @p idx
+   uint64_t vertex(uint64_t idx) const {
+      while(!_layout.implicit(idx))
+         idx = queryPosition(idx);
+
+      return _layout.vertex(idx);
+   }
+
+   //! Edge number @p e, i.e. the vertices at positions 2e and 2e+1
+   edge_type edge(uint64_t e) const {
+      return edge_type(vertex(2 * e), vertex(2 * e + 1));
+   }
+
+   /**
+    * @brief Vertices at the positions [first_idx, end_idx) in STXXL streaming interface
+    *
+    * Can be used in place of a TFP process, e.g. by EdgeWriter::writeVertices.
+    */
+   class Stream {
+   public:
+      using value_type = uint64_t;
+
+   protected:
+      const RandomAccessBA & _engine;
+      uint64_t _current_idx;
+      const uint64_t _end_idx;
+      uint64_t _current_vertex;
+      uint64_t _lookups;
+
+   public:
+      Stream(const RandomAccessBA & engine, uint64_t first_idx, uint64_t end_idx)
+         : _engine(engine)
+         , _current_idx(first_idx)
+         , _end_idx(end_idx)
+         , _lookups(0)
+      {
+         if (!empty())
+            _fetch();
+      }
+
+      //! Number of random positions resolved to obtain the vertices so far
+      uint64_t lookups() const {
+         return _lookups;
+      }
+
+   //! @name STXXL Streaming Interface
+   //! @{
+      bool empty() const {
+         return _current_idx >= _end_idx;
+      }
+
+      const value_type & operator*() const {
+         return _current_vertex;
+      }
+
+      Stream & operator++() {
+         _current_idx++;
+         if (!empty())
+            _fetch();
+         return *this;
+      }
+   //! @}
+
+   protected:
+      void _fetch() {
+         const BAEdgeListLayout & layout = _engine.layout();
+
+         uint64_t idx = _current_idx;
+         while(!layout.implicit(idx)) {
+            idx = _engine.queryPosition(idx);
+            _lookups++;
+         }
+
+         _current_vertex = layout.vertex(idx);
+      }
+   };
+};
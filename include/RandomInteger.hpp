@@ -18,68 +18,228 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#define RAND_STXXL
+#include <stxxl/random>
+#include <stxxl/bits/common/utils.h>
 
-#ifdef RAND_STXXL
-   #include <stxxl/random>
-   /**
-   * @brief Simple trait wrapper to STXXL PRNG based on the integer size.
-   * 
-   * In general the 64 bit generator is used; a faster specialization for 32 bit is provided.
-   */
-   template <size_t size>
-   struct RandomInteger {
-      /**
-      * Uniformly draw a random number form the interval [0; supremum[.
-      */
-      inline static uint64_t randint(uint64_t supremum) {
-         static stxxl::random_number64 rand;
-         static_assert(size <= 8, "RandomInteger only supports integers up to 64bit");
-         return rand(supremum);
+#if defined(__x86_64__) && defined(__GNUC__)
+   // the AVX2 path is compiled for its own target and selected at run time
+   #define RANDOM_BATCH_AVX2
+   #include <immintrin.h>
+#endif
+
+/**
+ * @brief Batched xoshiro256++ generator with bounded integers by Lemire's
+ * nearly divisionless multiply-shift reduction.
+ *
+ * The generator runs @p lanes independent xoshiro256++ streams (seeded by
+ * splitmix64) whose states are kept as structure of arrays; if the CPU supports
+ * AVX2 (checked at run time, so no -mavx2 is needed), each step advances all lanes
+ * with four 256-bit vectors, otherwise a scalar loop over the lanes is used (which
+ * compilers may vectorise themselves). Both produce the same sequence. Random
+ * numbers are produced in batches, either into a caller-provided buffer (fill,
+ * fillBounded) or into an internal buffer consumed by the scalar accessors.
+ *
+ * A bounded integer in [0, s) is the upper half of the 128-bit product of a
+ * random word and s; only if the lower half is below s a division is needed
+ * to decide whether the draw is rejected (with probability < s / 2^64).
+ */
+class RandomBatch {
+public:
+   static constexpr size_t lanes = 8;
+   static constexpr size_t buffer_size = 512;
+
+protected:
+   uint64_t _state[4][lanes];
+   uint64_t _buffer[buffer_size];
+   size_t _buffer_pos;
+   const bool _avx2;
+
+   static uint64_t _rotate(uint64_t x, int k) {
+      return (x << k) | (x >> (64 - k));
+   }
+
+   static uint64_t _splitmix64(uint64_t & x) {
+      uint64_t z = (x += 0x9e3779b97f4a7c15llu);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9llu;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebllu;
+      return z ^ (z >> 31);
+   }
+
+#ifdef RANDOM_BATCH_AVX2
+   __attribute__((target("avx2")))
+   static __m256i _rotate256(__m256i x, int k) {
+      return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+   }
+
+   //! Write lanes * blocks random words to out using AVX2
+   __attribute__((target("avx2")))
+   void _generateAVX2(uint64_t* out, size_t blocks) {
+      static_assert(lanes == 8, "AVX2 path advances two vectors of four lanes");
+      __m256i s[4][2];
+      for(unsigned int w = 0; w < 4; w++)
+         for(unsigned int h = 0; h < 2; h++)
+            s[w][h] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_state[w] + 4 * h));
+
+      for(size_t b = 0; b < blocks; b++, out += lanes) {
+         for(unsigned int h = 0; h < 2; h++) {
+            const __m256i result = _mm256_add_epi64(_rotate256(_mm256_add_epi64(s[0][h], s[3][h]), 23), s[0][h]);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4 * h), result);
+
+            const __m256i t = _mm256_slli_epi64(s[1][h], 17);
+            s[2][h] = _mm256_xor_si256(s[2][h], s[0][h]);
+            s[3][h] = _mm256_xor_si256(s[3][h], s[1][h]);
+            s[1][h] = _mm256_xor_si256(s[1][h], s[2][h]);
+            s[0][h] = _mm256_xor_si256(s[0][h], s[3][h]);
+            s[2][h] = _mm256_xor_si256(s[2][h], t);
+            s[3][h] = _rotate256(s[3][h], 45);
+         }
       }
-   };
-
-   //! @copydoc RandomInteger
-   template <>
-   struct RandomInteger<4> {
-      //! @copydoc RandomInteger::randint
-      inline static uint32_t randint(uint32_t supremum) {
-         static stxxl::random_number32 rand;
-         return rand(supremum);
+
+      for(unsigned int w = 0; w < 4; w++)
+         for(unsigned int h = 0; h < 2; h++)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(_state[w] + 4 * h), s[w][h]);
+   }
+#endif
+
+   //! Write lanes * blocks random words to out
+   void _generate(uint64_t* out, size_t blocks) {
+#ifdef RANDOM_BATCH_AVX2
+      if (_avx2) {
+         _generateAVX2(out, blocks);
+         return;
       }
-   };
+#endif
 
-#else
-   #include <random>
-   template <size_t size>
-   struct RandomInteger {
-      /**
-      * Uniformly draw a random number form the interval [0; supremum[.
-      */
-      FORCE_INLINE static uint64_t randint(uint64_t supremum) {
-         static std::mt19937_64 generator;
-         static std::uniform_int_distribution<uint64_t> distribution(0,supremum-1);
-         
-         if (distribution.b() != supremum + 1)
-            distribution = std::uniform_int_distribution<uint64_t>(0,supremum-1);
-         
-         return distribution(generator);
+      uint64_t* s0 = _state[0];
+      uint64_t* s1 = _state[1];
+      uint64_t* s2 = _state[2];
+      uint64_t* s3 = _state[3];
+
+      for(size_t b = 0; b < blocks; b++, out += lanes) {
+         for(size_t l = 0; l < lanes; l++) {
+            out[l] = _rotate(s0[l] + s3[l], 23) + s0[l];
+
+            const uint64_t t = s1[l] << 17;
+            s2[l] ^= s0[l];
+            s3[l] ^= s1[l];
+            s1[l] ^= s2[l];
+            s0[l] ^= s3[l];
+            s2[l] ^= t;
+            s3[l] = _rotate(s3[l], 45);
+         }
       }
-   };
-
-   //! @copydoc RandomInteger
-   template <>
-   struct RandomInteger<4> {
-      //! @copydoc RandomInteger::randint
-      FORCE_INLINE static uint32_t randint(uint32_t supremum) {
-         static std::mt19937 generator;
-         static std::uniform_int_distribution<uint32_t> distribution(0,supremum-1);
-         
-         if (distribution.b() != supremum + 1)
-            distribution = std::uniform_int_distribution<uint32_t>(0,supremum-1);
-         
-         return distribution(generator);
+   }
+
+   void _refill() {
+      _generate(_buffer, buffer_size / lanes);
+      _buffer_pos = 0;
+   }
+
+   //! Lemire's reduction of the random word @p x to [0, supremum)
+   uint64_t _reduce(uint64_t x, uint64_t supremum) {
+      __uint128_t m = __uint128_t(x) * supremum;
+      uint64_t low = uint64_t(m);
+      if (UNLIKELY(low < supremum)) {
+         const uint64_t threshold = -supremum % supremum;
+         while(low < threshold) {
+            m = __uint128_t((*this)()) * supremum;
+            low = uint64_t(m);
+         }
       }
-   };
+      return uint64_t(m >> 64);
+   }
+
+public:
+   //! Whether the CPU executing supports the AVX2 path
+   static bool avx2Supported() {
+#ifdef RANDOM_BATCH_AVX2
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
 #endif
+   }
+
+   //! @param allow_avx2  Use the AVX2 path if supported; the sequence is the same either way
+   explicit RandomBatch(uint64_t seed = stxxl::get_next_seed(), bool allow_avx2 = true)
+      : _avx2(allow_avx2 && avx2Supported())
+   {
+      for(unsigned int w = 0; w < 4; w++)
+         for(size_t l = 0; l < lanes; l++)
+            _state[w][l] = _splitmix64(seed);
+      _refill();
+   }
+
+   //! Uniform random 64 bit word
+   uint64_t operator()() {
+      if (UNLIKELY(_buffer_pos == buffer_size))
+         _refill();
+      return _buffer[_buffer_pos++];
+   }
+
+   //! Uniform random integer from [0, supremum); supremum has to be positive
+   uint64_t operator()(uint64_t supremum) {
+      return _reduce((*this)(), supremum);
+   }
+
+   //! Uniform double from [0, 1)
+   double uniform() {
+      return ((*this)() >> 11) * (1.0 / (1llu << 53));
+   }
+
+   //! Write @p n random words to @p out; the internal buffer is bypassed for full blocks
+   void fill(uint64_t* out, size_t n) {
+      const size_t blocks = n / lanes;
+      _generate(out, blocks);
+      for(size_t i = blocks * lanes; i < n; i++)
+         out[i] = (*this)();
+   }
+
+   /**
+    * Write @p n uniform integers to @p out, where out[i] is drawn from
+    * [0, supremum + i * increment); all bounds have to be positive.
+    */
+   void fillBounded(uint64_t* out, size_t n, uint64_t supremum, uint64_t increment = 0) {
+      fill(out, n);
+      for(size_t i = 0; i < n; i++, supremum += increment)
+         out[i] = _reduce(out[i], supremum);
+   }
+
+   //! Whether this generator uses the AVX2 path
+   bool usesAVX2() const {
+      return _avx2;
+   }
+};
+
+/**
+ * @brief Simple trait wrapper to a thread-local RandomBatch based on the integer size.
+ *
+ * Each thread uses its own generator, so randint may be called concurrently.
+ */
+template <size_t size>
+struct RandomInteger {
+   /**
+   * Uniformly draw a random number form the interval [0; supremum[.
+   */
+   inline static uint64_t randint(uint64_t supremum) {
+      static_assert(size <= 8, "RandomInteger only supports integers up to 64bit");
+      return generator()(supremum);
+   }
+
+   //! Generator of the calling thread, e.g. for batched requests
+   static RandomBatch & generator() {
+      static thread_local RandomBatch rand;
+      return rand;
+   }
+};
+
+/**
+ * @brief Uniform double in (0, 1] with 53 random bits; never zero, so its logarithm is finite.
+ */
+struct RandomDouble {
+   inline static double uniform() {
+      return (RandomInteger<8>::randint(1llu << 53) + 1) * (1.0 / (1llu << 53));
+   }
+};
@@ -18,6 +18,11 @@
  * limitations under the License.
  */
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
+#include <limits>
 #include <vector>
 #include <stxxl/bits/common/utils.h>
 #include <RandomInteger.hpp>
@@ -26,6 +31,12 @@ template <typename T, typename IndexType=uint64_t>
 /***
  * @brief Implementation of reservoir sampling to sample k elements
  * from a stream of unknown size. Supports erase.
+ *
+ * Once the reservoir is filled, the number of elements rejected before the
+ * next replacement is drawn directly from its (geometric-like) distribution
+ * following Li's Algorithm L, i.e. only O(k (1 + log(n/k))) random numbers
+ * are drawn for n elements. push(begin, end) and skip() allow a producer to
+ * jump over rejected elements without touching them.
  */
 class ReservoirSampling {
 public:
@@ -39,12 +50,44 @@ protected:
     size_t _reservoir_target_size;
     IndexType _elements_pushed;
 
+    double _max_key;   //!< Algorithm L: largest of the k smallest uniform keys seen so far
+    IndexType _skip;   //!< Number of elements rejected before the next replacement
+
+    //! Update the largest key and draw the number of elements to reject before the next replacement
+    void _drawSkip() {
+        _max_key *= std::exp(std::log(RandomDouble::uniform()) / _reservoir_target_size);
+        _drawSkipLength();
+    }
+
+    void _drawSkipLength() {
+        const double skip = std::floor(std::log(RandomDouble::uniform()) / std::log1p(-_max_key));
+        _skip = (skip < double(std::numeric_limits<IndexType>::max()))
+              ? IndexType(skip) : std::numeric_limits<IndexType>::max();
+    }
+
+    //! Store a sampled element once the reservoir was filled
+    void _replace(const T& d) {
+        IndexType r = Random::randint(_reservoir_target_size);
+
+        if (LIKELY(r < _reservoir.size())) {
+            // Sample by replacement
+            _reservoir[r] = d;
+        } else {
+            // Sample by adding (in case reservoir grew smaller)
+            _reservoir.push_back(d);
+        }
+
+        _drawSkip();
+    }
+
 public:
     //! Initialize and allocate a reservoir of requested size.
     //! @param reservoir_size has to be positive
     ReservoirSampling(size_t reservoir_size)
         : _reservoir_target_size(reservoir_size)
         , _elements_pushed(0)
+        , _max_key(1.0)
+        , _skip(0)
     {
         assert(reservoir_size > 0);
         _reservoir.reserve(reservoir_size);
@@ -57,21 +100,107 @@ public:
         if (UNLIKELY(_reservoir_target_size >= _elements_pushed)) {
             // Initial fill
             _reservoir.push_back(d);
-        } else {
-            IndexType r = Random::randint(_elements_pushed);
+            if (_reservoir_target_size == _elements_pushed)
+                _drawSkip();
 
+        } else if (LIKELY(_skip)) {
             // Do not sample
-            if (LIKELY(r >= _reservoir_target_size))
-                return;
-
-            if (LIKELY(r < _reservoir.size())) {
-                // Sample by replacement
-                _reservoir[r] = d;
-            } else {
-                // Sample by adding (in case reservoir grew smaller)
-                _reservoir.push_back(d);
-            }
+            --_skip;
+
+        } else {
+            _replace(d);
+        }
+    }
+
+    //! Push all elements of [begin, end); rejected elements are not dereferenced
+    template <typename Iterator>
+    void push(Iterator begin, Iterator end) {
+        // Initial fill
+        for(; begin != end && _elements_pushed < _reservoir_target_size; ++begin)
+            push(*begin);
+
+        IndexType remaining = std::distance(begin, end);
+        while(remaining > _skip) {
+            std::advance(begin, _skip);
+            _elements_pushed += _skip + 1;
+            remaining -= _skip + 1;
+
+            _replace(*begin);
+            ++begin;
+        }
+
+        _skip -= remaining;
+        _elements_pushed += remaining;
+    }
+
+    //! Number of elements that will be rejected before the next one is sampled;
+    //! zero during the initial fill
+    IndexType skip() const {
+        return _skip;
+    }
+
+    //! Account @p n rejected elements without providing them; requires n <= skip()
+    void skip(IndexType n) {
+        assert(n <= _skip);
+        _skip -= n;
+        _elements_pushed += n;
+    }
+
+    //! Number of elements pushed or skipped so far
+    IndexType elementsPushed() const {
+        return _elements_pushed;
+    }
+
+    /**
+     * Merge the sample of @p other, e.g. the reservoir of another thread that
+     * processed a different part of the stream, into this one. Afterwards this
+     * reservoir is a uniform sample of both streams and further pushes continue
+     * as if both streams were pushed into it.
+     * Both reservoirs have to have the same size and no erased elements.
+     */
+    void merge(const ReservoirSampling& other) {
+        assert(_reservoir_target_size == other._reservoir_target_size);
+        assert(_reservoir.size() == std::min<IndexType>(_reservoir_target_size, _elements_pushed));
+        assert(other._reservoir.size() == std::min<IndexType>(other._reservoir_target_size, other._elements_pushed));
+
+        std::vector<T> samples[2] = {std::move(_reservoir), other._reservoir};
+        IndexType population[2] = {_elements_pushed, other._elements_pushed};
+
+        _elements_pushed += other._elements_pushed;
+        const size_t size = std::min<IndexType>(_reservoir_target_size, _elements_pushed);
+
+        // Draw without replacement from the union: an element of stream i is
+        // chosen with probability population[i] / (population[0] + population[1]);
+        // as samples[i] is a uniform subset of stream i, any of its elements is
+        // a uniform choice among the remaining elements of stream i.
+        _reservoir.clear();
+        _reservoir.reserve(_reservoir_target_size);
+        while(_reservoir.size() < size) {
+            const unsigned int i = Random::randint(population[0] + population[1]) >= population[0];
+            auto & sample = samples[i];
+
+            const IndexType r = Random::randint(sample.size());
+            _reservoir.push_back(sample[r]);
+            std::swap(sample[r], sample.back());
+            sample.pop_back();
+            population[i]--;
+        }
+
+        if (_elements_pushed <= _reservoir_target_size) {
+            _max_key = 1.0;
+            _skip = 0;
+            return;
         }
+
+        // The largest kept key is the k-th smallest of n uniform keys; draw the
+        // order statistics incrementally: given the i-th smallest key x, the next
+        // one is x + (1 - x) * min of (n - i) uniforms on [0, 1]
+        double key = 0.0;
+        for(IndexType i = 0; i < _reservoir_target_size; i++)
+            key += (1.0 - key) * -std::expm1(std::log(RandomDouble::uniform()) / double(_elements_pushed - i));
+
+        _max_key = key;
+        _drawSkipLength();
     }
 
     //! Returns true iff no item is in reservoir
@@ -125,3 +254,127 @@ public:
     const iterator end() const {return _reservoir.end();}
 
 };
+
+template <typename T>
+/***
+ * @brief Weighted reservoir sampling of k elements without replacement from
+ * a stream of unknown size (Efraimidis and Spirakis, Algorithm A-ExpJ).
+ *
+ * Each element of weight w > 0 conceptually receives the key u^(1/w) for a
+ * uniform u; the k elements of largest key are kept, i.e. elements are drawn
+ * proportionally to their weights, e.g. vertices proportionally to their degree.
+ * Keys are stored as log(u) / w to avoid underflow. Instead of drawing a key for
+ * every element, the total weight rejected before the next insertion is drawn
+ * (exponential jumps), so only O(k log(W/k)) random numbers are needed for a
+ * total weight of W. Reservoirs of disjoint streams are merged by keeping the
+ * k largest keys of both.
+ */
+class WeightedReservoirSampling {
+public:
+    using value_type = T; //! Type of the items sampled
+    using entry_type = std::pair<double, T>; //! (logarithm of key, item)
+    using const_iterator = typename std::vector<entry_type>::const_iterator;
+
+protected:
+    struct KeyGreater {
+        bool operator()(const entry_type& a, const entry_type& b) const {return a.first > b.first;}
+    };
+
+    std::vector<entry_type> _heap; //!< Min-heap w.r.t. the keys
+    size_t _reservoir_target_size;
+    double _total_weight;
+    double _skip_weight;           //!< Weight to reject before the next insertion
+
+    void _drawSkipWeight() {
+        const double min_key = _heap.front().first;
+        _skip_weight = (min_key < 0.0) ? std::log(RandomDouble::uniform()) / min_key
+                                       : std::numeric_limits<double>::infinity();
+    }
+
+    //! Replace the element of smallest key
+    void _replace(const entry_type& entry) {
+        std::pop_heap(_heap.begin(), _heap.end(), KeyGreater());
+        _heap.back() = entry;
+        std::push_heap(_heap.begin(), _heap.end(), KeyGreater());
+    }
+
+    void _insert(const entry_type& entry) {
+        if (_heap.size() < _reservoir_target_size) {
+            _heap.push_back(entry);
+            std::push_heap(_heap.begin(), _heap.end(), KeyGreater());
+        } else if (entry.first > _heap.front().first) {
+            _replace(entry);
+        }
+    }
+
+public:
+    //! Initialize and allocate a reservoir of requested size.
+    //! @param reservoir_size has to be positive
+    WeightedReservoirSampling(size_t reservoir_size)
+        : _reservoir_target_size(reservoir_size)
+        , _total_weight(0.0)
+        , _skip_weight(0.0)
+    {
+        assert(reservoir_size > 0);
+        _heap.reserve(reservoir_size);
+    }
+
+    //! Add element with weight @p weight > 0
+    void push(const T& d, double weight) {
+        assert(weight > 0.0);
+        _total_weight += weight;
+
+        if (UNLIKELY(_heap.size() < _reservoir_target_size)) {
+            // Initial fill
+            _insert(entry_type(std::log(RandomDouble::uniform()) / weight, d));
+            if (_heap.size() == _reservoir_target_size)
+                _drawSkipWeight();
+            return;
+        }
+
+        _skip_weight -= weight;
+        if (LIKELY(_skip_weight > 0.0))
+            return;
+
+        // The key of the inserted element is conditioned to exceed the smallest key t,
+        // i.e. u is uniform on (t^w, 1]; u = 1 - (1 - t^w) v for uniform v
+        const double log_u = std::log1p(std::expm1(weight * _heap.front().first) * RandomDouble::uniform());
+        _replace(entry_type(log_u / weight, d));
+        _drawSkipWeight();
+    }
+
+    /**
+     * Merge the sample of @p other, e.g. the reservoir of another thread that
+     * processed a different part of the stream; both need the same size.
+     */
+    void merge(const WeightedReservoirSampling& other) {
+        assert(_reservoir_target_size == other._reservoir_target_size);
+        for(const auto & entry : other._heap)
+            _insert(entry);
+        _total_weight += other._total_weight;
+
+        // jumps are memoryless, so a fresh one w.r.t. the new smallest key is exact
+        if (_heap.size() == _reservoir_target_size)
+            _drawSkipWeight();
+    }
+
+    //! Returns true iff no item is in reservoir
+    bool empty() const {
+        return _heap.empty();
+    }
+
+    size_t size() const {
+        return _heap.size();
+    }
+
+    //! Sum of the weights pushed so far
+    double totalWeight() const {
+        return _total_weight;
+    }
+
+    //! Iterator to first (key, item) pair of the reservoir (in no particular order)
+    const_iterator begin() const {return _heap.cbegin();}
+
+    //! Iterator to past-the-end (key, item) pair of the reservoir
+    const_iterator end() const {return _heap.cend();}
+};
@@ -0,0 +1,127 @@
+/**
+ * @file
+ * @brief Bounded lock-free single-producer single-consumer queue
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Ring buffer connecting exactly one producer thread with one consumer thread
+ *
+ * Head and tail are monotonic counters; the producer only writes the tail,
+ * the consumer only the head, so a release store of one's own counter and an
+ * acquire load of the other's suffice. Both counters are kept on separate
+ * cache lines. The capacity is rounded up to the next power of two.
+ *
+ * The blocking variants push() and pop() spin briefly and then yield, since
+ * the stages connected are typically long-running and may share cores.
+ */
+template <typename T>
+class SPSCQueue {
+protected:
+   static constexpr size_t _cache_line = 64;
+
+   std::vector<T> _slots;
+   const size_t _mask;
+
+   char _pad0[_cache_line];
+   std::atomic<size_t> _head; //!< next slot read by the consumer
+   char _pad1[_cache_line - sizeof(std::atomic<size_t>)];
+   std::atomic<size_t> _tail; //!< next slot written by the producer
+   char _pad2[_cache_line - sizeof(std::atomic<size_t>)];
+
+   static size_t _roundUp(size_t capacity) {
+      size_t result = 1;
+      while(result < capacity)
+         result <<= 1;
+      return result;
+   }
+
+   static void _backoff(unsigned int & spins) {
+      if (spins < 64) {
+         spins++;
+      } else {
+         std::this_thread::yield();
+      }
+   }
+
+public:
+   explicit SPSCQueue(size_t capacity)
+      : _slots(_roundUp(capacity))
+      , _mask(_slots.size() - 1)
+      , _head(0)
+      , _tail(0)
+   {
+      assert(capacity > 0);
+   }
+
+   SPSCQueue(const SPSCQueue &) = delete;
+   SPSCQueue & operator=(const SPSCQueue &) = delete;
+
+   size_t capacity() const {
+      return _slots.size();
+   }
+
+   //! Producer only; moves @p value into the queue unless it is full
+   bool tryPush(T & value) {
+      const size_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail - _head.load(std::memory_order_acquire) == _slots.size())
+         return false;
+
+      _slots[tail & _mask] = std::move(value);
+      _tail.store(tail + 1, std::memory_order_release);
+      return true;
+   }
+
+   //! Consumer only; moves the oldest element into @p value unless the queue is empty
+   bool tryPop(T & value) {
+      const size_t head = _head.load(std::memory_order_relaxed);
+      if (head == _tail.load(std::memory_order_acquire))
+         return false;
+
+      value = std::move(_slots[head & _mask]);
+      _head.store(head + 1, std::memory_order_release);
+      return true;
+   }
+
+   //! Producer only; waits until there is space
+   void push(T value) {
+      unsigned int spins = 0;
+      while(!tryPush(value))
+         _backoff(spins);
+   }
+
+   //! Consumer only; waits until an element is available
+   T pop() {
+      T value;
+      unsigned int spins = 0;
+      while(!tryPop(value))
+         _backoff(spins);
+      return value;
+   }
+
+   //! Snapshot; exact only if called by the producer or consumer while the other is idle
+   size_t size() const {
+      return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+   }
+};
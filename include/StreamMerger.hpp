@@ -22,6 +22,9 @@
 //! @brief Merger for multiple asc. sorting streams based on a less comparator (STXXL semantics)
 template <typename T, class Compare, class Stream, typename... Streams>
 class StreamMerger {
+public:
+   using value_type = T;
+
 private:
    using StreamMergerOthers = StreamMerger<T, Compare, Streams...>;
 
@@ -80,6 +83,8 @@ class StreamMerger<T, Compare, Stream> {
    Stream & _my_stream;
 
 public:
+   using value_type = T;
+
    StreamMerger(Compare &, Stream & stream) : _my_stream(stream) {}
 
 //! @name STXXL Streaming Interface
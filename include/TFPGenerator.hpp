@@ -0,0 +1,140 @@
+/**
+ * @file
+ * @brief Library interface to the generators; streams edges to the caller without intermediate files
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+//! Parameters of a Barabasi-Albert graph (see tfp_ba)
+struct BAParameters {
+   uint64_t number_of_vertices = 1;
+   uint64_t edges_per_vertex = 2;
+   bool edge_dependencies = true;
+
+   bool filter_self_loops = false;
+   bool filter_multi_edges = false;
+
+   uint64_t window_size = 1 << 16;
+   uint64_t sorter_memory = 1 << 30;
+};
+
+//! Parameters of a directed graph following Bollobas et al. (see tfp_bbcr)
+struct BBCRParameters {
+   uint64_t number_of_edges = 1;
+   uint64_t number_of_seed_vertices = 100;
+
+   double alpha = 0.1;
+   double beta  = 0.8;
+   double gamma = 0.1;
+
+   double degree_offset_in = 0.0;
+   double degree_offset_out = 0.0;
+
+   bool filter_self_loops = false;
+   bool filter_multi_edges = false;
+
+   uint64_t window_size = 1 << 16;
+   uint64_t sorter_memory = 1 << 30;
+};
+
+/**
+ * @brief Pull-based source of the edges of a generated graph
+ *
+ * The whole TFP pipeline (token generation, sorting, PQ, process) is kept
+ * behind this interface and compiled into the tfpgen library, so in-process
+ * consumers obtain the edge list without a write and read of a file and
+ * without instantiating the STXXL templates themselves.
+ *
+ * @code
+ * BAParameters params;
+ * params.number_of_vertices = 1000000;
+ * params.edges_per_vertex = 10;
+ *
+ * // pull blocks
+ * auto source = EdgeSource::createBA(params);
+ * std::vector<EdgeSource::edge_type> block;
+ * while(source->nextBlock(block, 1 << 16)) {...}
+ *
+ * // or push blocks into a callback
+ * EdgeSource::createBA(params)->forEach([] (const EdgeSource::edge_type* begin, const EdgeSource::edge_type* end) {...});
+ * @endcode
+ *
+ * Without filters, the edges are produced in the order of the edge list written by
+ * the command line tools; with filters they are sorted lexicographically.
+ */
+class EdgeSource {
+public:
+   using edge_type = std::pair<uint64_t, uint64_t>;
+   using callback_type = std::function<void(const edge_type* begin, const edge_type* end)>;
+
+protected:
+   uint64_t _edges_produced;
+
+   EdgeSource() : _edges_produced(0) {}
+
+   //! Write up to @p max_edges edges into @p edges; returns the number written, 0 iff exhausted
+   virtual size_t _pull(edge_type* edges, size_t max_edges) = 0;
+
+public:
+   EdgeSource(const EdgeSource &) = delete;
+   virtual ~EdgeSource() {}
+
+   /**
+    * Write the next up to @p max_edges edges into @p edges.
+    * @return Number of edges written; 0 iff all edges were produced
+    */
+   size_t nextBlock(edge_type* edges, size_t max_edges) {
+      const size_t n = _pull(edges, max_edges);
+      _edges_produced += n;
+      return n;
+   }
+
+   /**
+    * Replace the content of @p block with the next up to @p max_edges edges.
+    * @return False iff all edges were produced
+    */
+   bool nextBlock(std::vector<edge_type> & block, size_t max_edges) {
+      block.resize(max_edges);
+      block.resize(nextBlock(block.data(), max_edges));
+      return !block.empty();
+   }
+
+   //! Pass all remaining edges in blocks of @p block_size to @p callback; returns number of edges
+   uint64_t forEach(const callback_type & callback, size_t block_size = 1 << 16) {
+      std::vector<edge_type> block;
+      uint64_t edges = 0;
+      while(nextBlock(block, block_size)) {
+         callback(block.data(), block.data() + block.size());
+         edges += block.size();
+      }
+      return edges;
+   }
+
+   //! Number of edges pulled so far
+   uint64_t edgesProduced() const {
+      return _edges_produced;
+   }
+
+   static std::unique_ptr<EdgeSource> createBA(const BAParameters & params);
+   static std::unique_ptr<EdgeSource> createBBCR(const BBCRParameters & params);
+};
@@ -0,0 +1,407 @@
+/**
+ * @file
+ * @brief Parallel text output of edge lists, Matrix Market and METIS files
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <stxxl/sorter>
+#include <stxxl/vector>
+#include <stxxl/bits/common/utils.h>
+
+#include <FdSink.hpp>
+
+//! @brief Conversion of unsigned integers to decimal strings
+struct DecimalFormat {
+   //! Number of decimal digits of @p x
+   static unsigned int digits(uint64_t x) {
+      unsigned int n = 1;
+      for(;;) {
+         if (x < 10) return n;
+         if (x < 100) return n + 1;
+         if (x < 1000) return n + 2;
+         if (x < 10000) return n + 3;
+         x /= 10000;
+         n += 4;
+      }
+   }
+
+   /**
+    * Write @p x without terminator to @p out; returns the position past the last digit.
+    * Two digits are produced per division using a lookup table.
+    */
+   static char* write(char* out, uint64_t x) {
+      static const char pairs[201] =
+         "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+         "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+         "8081828384858687888990919293949596979899";
+
+      const unsigned int n = digits(x);
+      char* pos = out + n;
+
+      while(x >= 100) {
+         const unsigned int r = x % 100;
+         x /= 100;
+         pos -= 2;
+         pos[0] = pairs[2 * r];
+         pos[1] = pairs[2 * r + 1];
+      }
+
+      if (x >= 10) {
+         pos -= 2;
+         pos[0] = pairs[2 * x];
+         pos[1] = pairs[2 * x + 1];
+      } else {
+         *--pos = char('0' + x);
+      }
+
+      return out + n;
+   }
+};
+
+/**
+ * @brief Parallel text output of edge lists, Matrix Market and METIS files
+ *
+ * Edges are collected in blocks; once a batch of blocks is complete, the blocks
+ * are formatted concurrently (one per thread) and written in order to an FdSink.
+ *
+ * - EdgeList: one line "u v" per edge with 0-based vertex ids, as produced.
+ * - MatrixMarket: coordinate pattern matrix with 1-based ids. The header has to
+ *   state the dimensions and number of edges; for regular files it is written
+ *   padded and overwritten on close, otherwise the edges are spooled to external
+ *   memory and emitted on close.
+ * - Metis: undirected adjacency lists with 1-based ids. All edges are
+ *   symmetrised and sorted in external memory; since METIS requires simple
+ *   graphs, self-loops and multi-edges are dropped. The output is emitted on close.
+ */
+class TextEdgeWriter {
+public:
+   using edge_type = std::pair<uint64_t, uint64_t>;
+
+   enum Format {
+      EdgeList, MatrixMarket, Metis
+   };
+
+protected:
+   struct EdgeCompare {
+      bool operator()(const edge_type & a, const edge_type & b) const {return a < b;}
+      edge_type min_value() const {return edge_type(std::numeric_limits<uint64_t>::min(), std::numeric_limits<uint64_t>::min());}
+      edge_type max_value() const {return edge_type(std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max());}
+   };
+
+   using sorter_type = stxxl::sorter<edge_type, EdgeCompare>;
+   using spool_type = typename stxxl::VECTOR_GENERATOR<edge_type>::result;
+
+   static constexpr const char* mm_banner = "%%MatrixMarket matrix coordinate pattern general\n";
+
+   //! Header line of Matrix Market files stating the sizes; padded to a fixed width
+   static constexpr size_t mm_size_line = 64;
+
+   const Format _format;
+   FdSink _sink;
+
+   // batch of blocks; block i is preceded by edge _previous[i] in the output order
+   const size_t _block_size;
+   std::vector<std::vector<edge_type>> _blocks;
+   std::vector<edge_type> _previous;
+   std::vector<std::vector<char>> _texts;
+   std::vector<size_t> _text_sizes;
+   unsigned int _current_block;
+   edge_type _last_edge;
+   bool _has_last_edge;
+   bool _has_previous_batch;
+
+   // statistics needed for headers
+   uint64_t _edges_pushed;
+   uint64_t _max_vertex;
+
+   // buffering in external memory until all edges are known
+   std::unique_ptr<sorter_type> _sorter;
+   std::unique_ptr<spool_type> _spool;
+   std::unique_ptr<typename spool_type::bufwriter_type> _spool_writer;
+   bool _header_pending;
+
+   bool _closed;
+
+   static void _reserve(std::vector<char> & text, size_t & fill, size_t bytes) {
+      if (UNLIKELY(fill + bytes > text.size()))
+         text.resize(std::max(2 * text.size(), fill + bytes));
+   }
+
+   //! Format block @p i into _texts[i]
+   void _formatBlock(unsigned int i) {
+      const std::vector<edge_type> & edges = _blocks[i];
+      std::vector<char> & text = _texts[i];
+      size_t fill = 0;
+
+      if (_format == Metis) {
+         // first line holds the neighbors of vertex 0; a block continues the
+         // line of its predecessor's source
+         uint64_t line = (i || _has_previous_batch) ? _previous[i].first : 0;
+         bool first_in_line = !(i || _has_previous_batch);
+
+         for(const edge_type & edge : edges) {
+            if (edge.first != line) {
+               const uint64_t newlines = edge.first - line;
+               _reserve(text, fill, newlines);
+               std::memset(text.data() + fill, '\n', newlines);
+               fill += newlines;
+               line = edge.first;
+               first_in_line = true;
+            }
+
+            _reserve(text, fill, 22);
+            char* out = text.data() + fill;
+            if (!first_in_line) *out++ = ' ';
+            out = DecimalFormat::write(out, edge.second + 1);
+            fill = out - text.data();
+            first_in_line = false;
+         }
+
+      } else {
+         const uint64_t base = (_format == MatrixMarket);
+         _reserve(text, fill, 42 * edges.size());
+         char* out = text.data() + fill;
+         for(const edge_type & edge : edges) {
+            out = DecimalFormat::write(out, edge.first + base);
+            *out++ = ' ';
+            out = DecimalFormat::write(out, edge.second + base);
+            *out++ = '\n';
+         }
+         fill = out - text.data();
+      }
+
+      _text_sizes[i] = fill;
+   }
+
+   //! Format all non-empty blocks in parallel and write them in order
+   void _flushBatch() {
+      const int blocks = int(_current_block + !_blocks[_current_block].empty());
+
+      #pragma omp parallel for schedule(dynamic, 1)
+      for(int i = 0; i < blocks; i++)
+         _formatBlock(i);
+
+      for(int i = 0; i < blocks; i++) {
+         _sink.write(_texts[i].data(), _text_sizes[i]);
+         _blocks[i].clear();
+      }
+
+      _current_block = 0;
+      _has_previous_batch = _has_previous_batch || blocks;
+      _previous[0] = _last_edge;
+   }
+
+   //! Append edge to the current batch in output order
+   void _emit(const edge_type & edge) {
+      _blocks[_current_block].push_back(edge);
+      _last_edge = edge;
+      _has_last_edge = true;
+
+      if (UNLIKELY(_blocks[_current_block].size() == _block_size)) {
+         if (++_current_block == _blocks.size()) {
+            _current_block--;
+            _flushBatch();
+         } else {
+            _previous[_current_block] = edge;
+         }
+      }
+   }
+
+   std::string _mmSizeLine() const {
+      const uint64_t n = _edges_pushed ? _max_vertex + 1 : 0;
+      std::string line = std::to_string(n) + " " + std::to_string(n) + " " + std::to_string(_edges_pushed);
+      line.resize(mm_size_line - 1, ' ');
+      return line + "\n";
+   }
+
+   void _writeString(const std::string & str) {
+      _sink.write(str.data(), str.size());
+   }
+
+public:
+   /**
+    * @param path        Output path; "-" denotes stdout
+    * @param format      Text format
+    * @param block_size  Number of edges formatted per task
+    * @param sorter_memory  Memory of the external sorter (METIS only)
+    */
+   TextEdgeWriter(const std::string & path, Format format,
+                  size_t block_size = 1 << 16, stxxl::unsigned_type sorter_memory = 1 << 30)
+      : _format(format)
+      , _sink(path)
+      , _block_size(block_size)
+      , _current_block(0)
+      , _has_last_edge(false)
+      , _has_previous_batch(false)
+      , _edges_pushed(0)
+      , _max_vertex(0)
+      , _header_pending(false)
+      , _closed(false)
+   {
+      #ifdef _OPENMP
+      const unsigned int threads = omp_get_max_threads();
+      #else
+      const unsigned int threads = 1;
+      #endif
+
+      _blocks.resize(2 * threads);
+      _previous.resize(_blocks.size());
+      _texts.resize(_blocks.size());
+      _text_sizes.resize(_blocks.size());
+      for(auto & block : _blocks)
+         block.reserve(_block_size);
+
+      if (_format == MatrixMarket) {
+         _writeString(mm_banner);
+         if (_sink.seekable()) {
+            _writeString(_mmSizeLine()); // placeholder
+            _sink.flush();
+         } else {
+            _header_pending = true;
+            _spool.reset(new spool_type());
+            _spool_writer.reset(new typename spool_type::bufwriter_type(*_spool));
+         }
+
+      } else if (_format == Metis) {
+         _sorter.reset(new sorter_type(EdgeCompare(), sorter_memory));
+
+      }
+   }
+
+   TextEdgeWriter(const TextEdgeWriter &) = delete;
+
+   //! Callers should close() explicitly; failures at destruction are only reported
+   ~TextEdgeWriter() {
+      try {
+         close();
+      } catch (const std::exception & e) {
+         STXXL_ERRMSG("Closing text output failed: " << e.what());
+      }
+   }
+
+   //! Parse format name ("text", "mtx" or "metis"); returns false if unknown
+   static bool parseFormat(const std::string & name, Format & format) {
+      if (name == "text") {
+         format = EdgeList;
+      } else if (name == "mtx") {
+         format = MatrixMarket;
+      } else if (name == "metis") {
+         format = Metis;
+      } else {
+         return false;
+      }
+      return true;
+   }
+
+   //! Write edge (u, v)
+   void operator()(uint64_t u, uint64_t v) {
+      assert(!_closed);
+      _edges_pushed++;
+      _max_vertex = std::max(_max_vertex, std::max(u, v));
+
+      if (_sorter) {
+         if (u != v) {
+            _sorter->push(edge_type(u, v));
+            _sorter->push(edge_type(v, u));
+         }
+      } else if (_spool_writer) {
+         *_spool_writer << edge_type(u, v);
+      } else {
+         _emit(edge_type(u, v));
+      }
+   }
+
+   //! Emit all pending data and write headers; idempotent
+   void close() {
+      if (_closed) return;
+      _closed = true;
+
+      if (_format == MatrixMarket && _header_pending) {
+         _spool_writer->finish();
+         _spool_writer.reset();
+
+         _writeString(_mmSizeLine());
+         for(typename spool_type::bufreader_type reader(*_spool); !reader.empty(); ++reader)
+            _emit(*reader);
+         _spool.reset();
+
+      } else if (_format == Metis) {
+         _sorter->sort();
+
+         // count distinct undirected edges for the header
+         uint64_t directed = 0;
+         {
+            edge_type last(1, 0); // never a valid symmetrised edge as first element
+            for(; !_sorter->empty(); ++(*_sorter)) {
+               directed += (**_sorter != last);
+               last = **_sorter;
+            }
+            _sorter->rewind();
+         }
+
+         const uint64_t n = _edges_pushed ? _max_vertex + 1 : 0;
+         _writeString(std::to_string(n) + " " + std::to_string(directed / 2) + "\n");
+
+         edge_type last(1, 0);
+         for(; !_sorter->empty(); ++(*_sorter)) {
+            if (**_sorter != last)
+               _emit(**_sorter);
+            last = **_sorter;
+         }
+         _sorter.reset();
+      }
+
+      _flushBatch();
+
+      if (_format == Metis) {
+         // terminate the line of the last source and add empty lines up to the last vertex
+         const uint64_t n = _edges_pushed ? _max_vertex + 1 : 0;
+         const uint64_t line = _has_last_edge ? _last_edge.first : 0;
+         _writeString(std::string(n - line, '\n'));
+      }
+
+      if (_format == MatrixMarket && !_header_pending) {
+         _sink.flush();
+         const std::string size_line = _mmSizeLine();
+         _sink.writeAt(std::strlen(mm_banner), size_line.data(), size_line.size());
+      }
+
+      _sink.close();
+   }
+
+   //! Number of edges passed to the writer so far
+   uint64_t edgesWritten() const {
+      return _edges_pushed;
+   }
+
+   uint64_t bytesWritten() const {
+      return _sink.bytesWritten();
+   }
+};
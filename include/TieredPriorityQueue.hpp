@@ -0,0 +1,377 @@
+/**
+ * @file
+ * @brief Monotone priority queue with an in-cache heap, RAM buckets and external buckets
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <stxxl/vector>
+#include <stxxl/bits/common/utils.h>
+#include <Token.hpp>
+
+/**
+ * @brief Unsorted bucket of tokens written sequentially to external memory
+ *
+ * The underlying STXXL vector caches only a single block, which is all the RAM
+ * the bucket needs; hence the budget given to the constructor is not used.
+ */
+template <typename T = Token64, unsigned BlockSize = (1u << 20)>
+class ExternalTokenBucket {
+   using vector_type = typename stxxl::VECTOR_GENERATOR<T, 1, 1, BlockSize>::result;
+   vector_type _vector;
+
+public:
+   //! RAM required: the block cached
+   static constexpr uint64_t minimumBytes = BlockSize;
+   static constexpr uint64_t defaultBytes = BlockSize;
+
+   explicit ExternalTokenBucket(uint64_t /*bytes*/ = defaultBytes) {}
+
+   void push(const T & token) {
+      _vector.push_back(token);
+   }
+
+   uint64_t size() const {
+      return _vector.size();
+   }
+
+   //! Call @p f for each token (in arbitrary order) and clear bucket
+   template <typename F>
+   void consume(F f) {
+      _vector.flush();
+      for(typename vector_type::bufreader_type reader(_vector); !reader.empty(); ++reader)
+         f(*reader);
+      _vector.clear();
+   }
+};
+
+template <typename T, unsigned BlockSize>
+constexpr uint64_t ExternalTokenBucket<T, BlockSize>::minimumBytes;
+
+template <typename T, unsigned BlockSize>
+constexpr uint64_t ExternalTokenBucket<T, BlockSize>::defaultBytes;
+
+/**
+ * @brief Monotone priority queue with an in-cache heap, RAM buckets and external buckets
+ *
+ * In TFP every token pushed into the PQ has a larger id than the token
+ * popped last. This allows for a bucket structure keyed by token id:
+ *  - Tokens due soon are kept in a small binary heap.
+ *  - The next mid_buckets ranges of the same width are kept in unsorted RAM buckets;
+ *    once the heap runs empty, the next RAM bucket is heapified.
+ *  - The next far_buckets ranges, each covering all RAM buckets, are sequentially
+ *    written to external memory. Once all RAM buckets are consumed, the next
+ *    external bucket is read back once and distributed into the RAM buckets.
+ *  - Tokens beyond are written into an external overflow bucket which is
+ *    redistributed into the external buckets once these are consumed. Their width
+ *    is then chosen to cover all overflowing tokens, but at most the width fitting into
+ *    the RAM budget; tokens beyond that are written into a fresh overflow bucket for the
+ *    next stage.
+ *
+ * As an external bucket is loaded into the RAM buckets at once, the width of the
+ * external buckets is capped such that the keys it covers fit into the RAM budget
+ * given to the constructor. This bounds the RAM used since TFP pushes at most one
+ * token per key (the answer to the query of its position). The buffers of the
+ * external buckets are sized by a separate budget (see externalBytes()).
+ *
+ * Far-future tokens hence cost sequential writes and reads instead of repeated merging:
+ * a token within the range of the external buckets is written and read once. A token
+ * in the overflow is read (and written again) once per stage until its stage is reached,
+ * where a stage covers far_buckets * maxFarWidth() keys. A single stage suffices if the
+ * keys pushed span less than that (e.g. 2^33 keys with a RAM budget of 1 GiB); beyond,
+ * the overflow volume grows with the number of stages, which is reported by
+ * overflowStages() and overflowTokensRespilled() to make this cost visible.
+ *
+ * The interface matches the subset of the STXXL PQ used by the TFP loops; note
+ * that top() yields the smallest element.
+ *
+ * @tparam T               Token type providing id() and a ComparatorDesc
+ * @tparam ExternalBucket  Storage of far-future tokens, e.g. ExternalTokenBucket or CompressedTokenBucket
+ */
+template <typename T = Token64, class ExternalBucket = ExternalTokenBucket<T>>
+class TieredPriorityQueue {
+public:
+   using value_type = T;
+   using size_type = uint64_t;
+
+protected:
+   using key_type = uint64_t;
+   using bucket_type = std::vector<T>;
+   using external_bucket_type = ExternalBucket;
+
+   const key_type _initial_near_width;
+   const unsigned int _number_of_mid_buckets;
+   const unsigned int _number_of_far_buckets;
+   const key_type _max_far_width; //!< keys of an external bucket fitting into the RAM budget
+   const uint64_t _bucket_bytes;  //!< RAM budget of each external bucket
+
+   size_type _size;
+   key_type _last_key; //!< key of the token popped last; lower bound of all keys
+
+   // near future: keys < _mid_base + _mid_next * _mid_width
+   bucket_type _heap;
+   typename T::ComparatorDesc _compare; // turns std heap into min-heap
+
+   // mid range: RAM bucket i covers [_mid_base + i*_mid_width, _mid_base + (i+1)*_mid_width)
+   std::vector<bucket_type> _mid;
+   key_type _mid_base;
+   key_type _mid_width;
+   unsigned int _mid_next;
+
+   // far range: external bucket j covers [_far_base + j*_far_width, _far_base + (j+1)*_far_width)
+   std::vector<std::unique_ptr<external_bucket_type>> _far;
+   key_type _far_base;
+   key_type _far_width;
+   unsigned int _far_next;
+
+   // beyond
+   std::unique_ptr<external_bucket_type> _overflow;
+   key_type _overflow_max;
+
+   // statistics
+   uint64_t _far_tokens_loaded;
+   uint64_t _overflow_tokens_loaded;
+   uint64_t _overflow_tokens_respilled;
+   unsigned int _overflow_stages;
+
+   static key_type _key(const T & token) {
+      return token.id();
+   }
+
+   key_type _heapEnd() const {
+      return _mid_base + _mid_next * _mid_width;
+   }
+
+   key_type _farEnd() const {
+      return _far_base + _number_of_far_buckets * _far_width;
+   }
+
+   //! Anchor all tiers at the last key popped; only valid if the PQ is empty
+   void _rebase() {
+      assert(!_size);
+      const key_type key = _last_key;
+
+      _mid_width = _initial_near_width;
+      _mid_base = key;
+      _mid_next = 0;
+
+      _far_width = _mid_width * _number_of_mid_buckets;
+      _far_base = key;
+      _far_next = 1; // the first far range coincides with the mid range
+   }
+
+   //! Insert without any refill of the heap
+   void _insert(const T & token) {
+      const key_type key = _key(token);
+
+      if (key < _heapEnd()) {
+         _heap.push_back(token);
+         std::push_heap(_heap.begin(), _heap.end(), _compare);
+
+      } else if (key < _far_base + _far_next * _far_width) {
+         _mid[(key - _mid_base) / _mid_width].push_back(token);
+
+      } else if (key < _farEnd()) {
+         _far[(key - _far_base) / _far_width]->push(token);
+
+      } else {
+         _overflow->push(token);
+         _overflow_max = std::max(_overflow_max, key);
+
+      }
+   }
+
+   //! Move next far bucket into the RAM buckets
+   void _loadFarBucket() {
+      assert(_far_next < _number_of_far_buckets);
+
+      _mid_width = _far_width / _number_of_mid_buckets;
+      _mid_base = _far_base + _far_next * _far_width;
+      _mid_next = 0;
+
+      auto & bucket = *_far[_far_next++];
+      _far_tokens_loaded += bucket.size();
+      bucket.consume([this] (const T & token) {
+         _mid[(_key(token) - _mid_base) / _mid_width].push_back(token);
+      });
+   }
+
+   //! Redistribute overflow into new far buckets wide enough to cover as much of it as the RAM budget allows
+   void _loadOverflow() {
+      assert(_far_next == _number_of_far_buckets);
+
+      const key_type base = _farEnd();
+      const key_type span = _overflow_max - base + 1;
+      const key_type granularity = _initial_near_width * _number_of_mid_buckets;
+
+      key_type width = (span + _number_of_far_buckets - 1) / _number_of_far_buckets;
+      width = std::max(granularity, (width + granularity - 1) / granularity * granularity);
+
+      _far_base = base;
+      _far_width = std::min(width, _max_far_width);
+      _far_next = 0;
+
+      // tokens beyond the new far range go into a fresh overflow for the next stage;
+      // as all RAM buckets are consumed, _insert puts all others into far buckets
+      std::unique_ptr<external_bucket_type> overflow(new external_bucket_type(_bucket_bytes));
+      overflow.swap(_overflow);
+      _overflow_max = 0;
+
+      _overflow_stages++;
+      _overflow_tokens_loaded += overflow->size();
+      overflow->consume([this] (const T & token) {
+         _insert(token);
+      });
+      _overflow_tokens_respilled += _overflow->size();
+   }
+
+   //! Ensure that the heap holds the minimum unless the PQ is empty
+   void _refill() {
+      while(_heap.empty() && _size) {
+         if (_mid_next < _number_of_mid_buckets) {
+            _heap.swap(_mid[_mid_next++]);
+            std::make_heap(_heap.begin(), _heap.end(), _compare);
+
+         } else if (_far_next < _number_of_far_buckets) {
+            _loadFarBucket();
+
+         } else {
+            _loadOverflow();
+
+         }
+      }
+   }
+
+public:
+   /**
+    * Number of bytes of the heap and the RAM buckets required at least, i.e.
+    * for the keys of a single external bucket of the initial width (see maxFarWidth()).
+    */
+   static uint64_t minimumRamBytes(uint64_t near_width = 1 << 16, unsigned int mid_buckets = 64) {
+      return 2 * sizeof(T) * std::max<uint64_t>(1, near_width) * std::max(1u, mid_buckets);
+   }
+
+   /**
+    * Budget of the external buckets if each gets @p bucket_bytes: besides the far buckets
+    * and the overflow, a fresh overflow exists while the old one is redistributed.
+    */
+   static uint64_t externalBytes(unsigned int far_buckets = 256, uint64_t bucket_bytes = ExternalBucket::defaultBytes) {
+      return (std::max(1u, far_buckets) + 2) * bucket_bytes;
+   }
+
+   /**
+    * @param ram_bytes       Budget of the heap and the RAM buckets; at least minimumRamBytes()
+    * @param external_bytes  Budget of the buffers of all external buckets; at least
+    *                        externalBytes(far_buckets, ExternalBucket::minimumBytes)
+    * @param near_width      Range of keys covered by the heap and each RAM bucket (initially)
+    * @param mid_buckets     Number of RAM buckets
+    * @param far_buckets     Number of external buckets
+    */
+   TieredPriorityQueue(uint64_t ram_bytes, uint64_t external_bytes,
+                       uint64_t near_width = 1 << 16, unsigned int mid_buckets = 64, unsigned int far_buckets = 256)
+      : _initial_near_width(std::max<uint64_t>(1, near_width))
+      , _number_of_mid_buckets(std::max(1u, mid_buckets))
+      , _number_of_far_buckets(std::max(1u, far_buckets))
+      // vectors may hold twice the capacity needed; round down to a multiple of the initial far width
+      , _max_far_width(std::max<key_type>(1, ram_bytes / minimumRamBytes(near_width, mid_buckets))
+                       * _initial_near_width * _number_of_mid_buckets)
+      , _bucket_bytes(external_bytes / externalBytes(far_buckets, 1))
+      , _size(0)
+      , _last_key(0)
+      , _mid(_number_of_mid_buckets)
+      , _overflow(new external_bucket_type(_bucket_bytes))
+      , _overflow_max(0)
+      , _far_tokens_loaded(0)
+      , _overflow_tokens_loaded(0)
+      , _overflow_tokens_respilled(0)
+      , _overflow_stages(0)
+   {
+      assert(_bucket_bytes >= ExternalBucket::minimumBytes);
+      for(unsigned int i = 0; i < _number_of_far_buckets; i++)
+         _far.emplace_back(new external_bucket_type(_bucket_bytes));
+
+      _rebase();
+   }
+
+   TieredPriorityQueue(const TieredPriorityQueue &) = delete;
+
+   void push(const T & token) {
+      assert(_key(token) >= _last_key);
+
+      if (UNLIKELY(!_size))
+         _rebase();
+
+      _insert(token);
+      _size++;
+
+      if (UNLIKELY(_heap.empty()))
+         _refill();
+   }
+
+   //! Smallest token; PQ must not be empty
+   const T & top() const {
+      assert(!_heap.empty());
+      return _heap.front();
+   }
+
+   void pop() {
+      assert(!_heap.empty());
+      _last_key = _key(_heap.front());
+      std::pop_heap(_heap.begin(), _heap.end(), _compare);
+      _heap.pop_back();
+      _size--;
+
+      if (UNLIKELY(_heap.empty()))
+         _refill();
+   }
+
+   bool empty() const {
+      return !_size;
+   }
+
+   size_type size() const {
+      return _size;
+   }
+
+   //! Number of tokens read back from the external buckets
+   uint64_t farTokensLoaded() const {
+      return _far_tokens_loaded;
+   }
+
+   //! Number of tokens read back from the overflow bucket (in all stages)
+   uint64_t overflowTokensLoaded() const {
+      return _overflow_tokens_loaded;
+   }
+
+   //! Number of tokens written into a fresh overflow bucket again, i.e. beyond their first stage
+   uint64_t overflowTokensRespilled() const {
+      return _overflow_tokens_respilled;
+   }
+
+   //! Number of times the overflow bucket was redistributed
+   unsigned int overflowStages() const {
+      return _overflow_stages;
+   }
+
+   //! Largest range of keys covered by an external bucket, i.e. loaded into RAM at once
+   uint64_t maxFarWidth() const {
+      return _max_far_width;
+   }
+};
@@ -0,0 +1,298 @@
+/**
+ * @file
+ * @brief File-based exchange of tokens between cooperating generator processes
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stxxl/io>
+#include <stxxl/bits/common/utils.h>
+#include <Token.hpp>
+
+/**
+ * @brief File-based exchange of tokens between cooperating generator processes
+ *
+ * The edge list is split into P consecutive ranges of positions; rank r owns
+ * positions [boundary[r], boundary[r+1]). Tokens are routed to the rank owning
+ * their id: a query token to the rank owning the queried position, a link token
+ * (i.e. an answer) to the rank owning the requesting position.
+ *
+ * Each (kind, receiver, sender) triple is mapped to a file in a directory shared
+ * by all processes. A file is written under a temporary name and atomically renamed
+ * once the sender closed it; hence its existence signals completeness to the receiver.
+ * The exchange therefore works for several processes on one box as well as for
+ * processes on different hosts sharing a network filesystem.
+ *
+ * All file names contain a job id shared by the processes of a run, so runs using
+ * the same directory do not interfere. Files a rank would send and that are left
+ * over from an earlier (e.g. crashed) run with the same job id are removed on
+ * construction. A receiver gives up with an exception if a file does not appear
+ * within the timeout, e.g. because its sender crashed.
+ */
+class TokenExchange {
+public:
+   using token_type = Token64;
+
+   enum Kind : char {
+      Query = 'q', Answer = 'a'
+   };
+
+protected:
+   //! Buffered writer producing a single exchange file
+   class Writer {
+      std::string _path;
+      std::FILE* _file;
+      std::vector<token_type> _buffer;
+      uint64_t _tokens_written;
+
+      void _flush() {
+         if (_buffer.empty()) return;
+
+         if (std::fwrite(_buffer.data(), sizeof(token_type), _buffer.size(), _file) != _buffer.size())
+            STXXL_THROW_ERRNO(stxxl::io_error, "Cannot write to exchange file " << _path);
+
+         _tokens_written += _buffer.size();
+         _buffer.clear();
+      }
+
+   public:
+      Writer(const std::string & path, size_t buffer_size)
+         : _path(path)
+         , _file(std::fopen((path + ".tmp").c_str(), "wb"))
+         , _tokens_written(0)
+      {
+         if (!_file)
+            STXXL_THROW_ERRNO(stxxl::io_error, "Cannot open exchange file " << path);
+
+         _buffer.reserve(buffer_size);
+      }
+
+      ~Writer() {close();}
+
+      void push(const token_type & token) {
+         _buffer.push_back(token);
+         if (UNLIKELY(_buffer.size() == _buffer.capacity()))
+            _flush();
+      }
+
+      //! Flush buffer and publish file to the receiver; idempotent
+      void close() {
+         if (!_file) return;
+
+         _flush();
+         std::fclose(_file);
+         _file = nullptr;
+
+         if (std::rename((_path + ".tmp").c_str(), _path.c_str()))
+            STXXL_THROW_ERRNO(stxxl::io_error, "Cannot publish exchange file " << _path);
+      }
+
+      uint64_t tokensWritten() const {
+         return _tokens_written;
+      }
+   };
+
+   const std::string _directory;
+   const std::string _job;
+   const unsigned int _rank;
+   const std::vector<uint64_t> _boundaries;
+   const size_t _buffer_size;
+   const std::chrono::seconds _timeout;
+
+   std::vector<std::unique_ptr<Writer>> _writers[2];
+
+   std::string _path(Kind kind, unsigned int to, unsigned int from) const {
+      std::stringstream ss;
+      ss << _directory << "/tfp_" << _job << "_" << char(kind) << "_" << to << "_" << from << ".bin";
+      return ss.str();
+   }
+
+   std::vector<std::unique_ptr<Writer>> & _writers_of(Kind kind) {
+      return _writers[kind == Answer];
+   }
+
+public:
+   /**
+    * @param directory   Directory shared by all processes; may be empty if only one partition exists
+    * @param job         Identifier of the run shared by all of its processes; part of all file names;
+    *                    may be empty if only one partition exists
+    * @param rank        Rank of this process in [0, partitions)
+    * @param boundaries  Sorted list of P+1 edge list positions; rank r owns [boundaries[r], boundaries[r+1])
+    * @param timeout     Time receive() waits for a file before it throws; 0 waits forever
+    * @param buffer_size Number of tokens buffered per outgoing file
+    */
+   TokenExchange(const std::string & directory, const std::string & job, unsigned int rank,
+                 const std::vector<uint64_t> & boundaries, std::chrono::seconds timeout = std::chrono::seconds(0),
+                 size_t buffer_size = 1 << 16)
+      : _directory(directory)
+      , _job(job)
+      , _rank(rank)
+      , _boundaries(boundaries)
+      , _buffer_size(buffer_size)
+      , _timeout(timeout)
+   {
+      assert(_boundaries.size() >= 2);
+      assert(_rank + 1 < _boundaries.size());
+      assert(partitions() == 1 || !(_directory.empty() || _job.empty()));
+
+      // remove stale files of an earlier run with the same job id that we would send
+      if (partitions() > 1 && !_directory.empty()) {
+         for(Kind kind : {Query, Answer}) {
+            for(unsigned int to = 0; to < partitions(); to++) {
+               const std::string path = _path(kind, to, _rank);
+               std::remove(path.c_str());
+               std::remove((path + ".tmp").c_str());
+            }
+         }
+      }
+   }
+
+   //! Number of cooperating processes
+   unsigned int partitions() const {
+      return _boundaries.size() - 1;
+   }
+
+   unsigned int rank() const {
+      return _rank;
+   }
+
+   //! First position owned by this rank
+   uint64_t begin() const {
+      return _boundaries[_rank];
+   }
+
+   //! Position past the last one owned by this rank
+   uint64_t end() const {
+      return _boundaries[_rank + 1];
+   }
+
+   //! Rank owning edge list position @p pos
+   unsigned int owner(uint64_t pos) const {
+      return std::upper_bound(_boundaries.begin() + 1, _boundaries.end() - 1, pos) - _boundaries.begin() - 1;
+   }
+
+   /**
+    * Create the outgoing files of the given kind to all ranks in [first, last).
+    * All of them have to be closed before a receiver may proceed, even if empty.
+    */
+   void open(Kind kind, unsigned int first, unsigned int last) {
+      auto & writers = _writers_of(kind);
+      writers.resize(partitions());
+      for(unsigned int to = first; to < last; to++)
+         writers[to].reset(new Writer(_path(kind, to, _rank), _buffer_size));
+   }
+
+   //! Route a token to the rank owning its id; the file has to be opened before
+   void send(Kind kind, const token_type & token) {
+      auto & writers = _writers_of(kind);
+      const unsigned int to = owner(token.id());
+      assert(to < writers.size() && writers[to]);
+      writers[to]->push(token);
+   }
+
+   //! Publish all outgoing files of the given kind; returns number of tokens sent
+   uint64_t close(Kind kind) {
+      uint64_t tokens = 0;
+      for(auto & w : _writers_of(kind)) {
+         if (!w) continue;
+         w->close();
+         tokens += w->tokensWritten();
+      }
+      _writers_of(kind).clear();
+      return tokens;
+   }
+
+   /**
+    * Block until the file of the given kind sent by rank @p from is complete and push
+    * all of its tokens into @p sink (e.g. a sorter). The file is removed afterwards.
+    * @throw stxxl::io_error if the file does not appear within the timeout
+    * @return Number of tokens received
+    */
+   template <class Sink>
+   uint64_t receive(Kind kind, unsigned int from, Sink & sink) {
+      const std::string path = _path(kind, _rank, from);
+      const auto deadline = std::chrono::steady_clock::now() + _timeout;
+
+      std::FILE* file;
+      while(!(file = std::fopen(path.c_str(), "rb"))) {
+         if (_timeout.count() && std::chrono::steady_clock::now() > deadline)
+            STXXL_THROW(stxxl::io_error, "Rank " << from << " did not publish exchange file " << path
+                        << " within " << _timeout.count() << " s");
+         std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+
+      std::vector<token_type> buffer(_buffer_size);
+      uint64_t tokens = 0;
+      while(size_t n = std::fread(buffer.data(), sizeof(token_type), buffer.size(), file)) {
+         for(size_t i = 0; i < n; i++)
+            sink.push(buffer[i]);
+         tokens += n;
+      }
+
+      if (std::ferror(file))
+         STXXL_THROW_ERRNO(stxxl::io_error, "Cannot read exchange file " << path);
+
+      std::fclose(file);
+      std::remove(path.c_str());
+
+      return tokens;
+   }
+};
+
+/**
+ * @brief Priority queue adapter diverting link tokens into the exchange
+ *
+ * Answers to queries of positions not owned by this rank are not pushed into
+ * the local priority queue but sent to the owning rank instead.
+ */
+template <class PriorityQueue>
+class PartitionedPriorityQueue {
+public:
+   using value_type = typename PriorityQueue::value_type;
+
+protected:
+   PriorityQueue & _pq;
+   TokenExchange & _exchange;
+   const uint64_t _end;
+
+public:
+   PartitionedPriorityQueue(PriorityQueue & pq, TokenExchange & exchange)
+      : _pq(pq)
+      , _exchange(exchange)
+      , _end(exchange.end())
+   {}
+
+   void push(const value_type & token) {
+      if (LIKELY(token.id() < _end))
+         _pq.push(token);
+      else
+         _exchange.send(TokenExchange::Answer, token);
+   }
+
+   const value_type & top() const {return _pq.top();}
+   void pop() {_pq.pop();}
+   bool empty() const {return _pq.empty();}
+   typename PriorityQueue::size_type size() const {return _pq.size();}
+};
@@ -0,0 +1,342 @@
+/**
+ * @file
+ * @brief Triangle counting and clustering coefficients in external memory
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <stxxl/sorter>
+#include <stxxl/vector>
+
+#include <DistributionCount.hpp>
+#include <GenericComparator.hpp>
+
+/**
+ * @brief Triangle counting by a sorting-based wedge/edge join
+ *
+ * Edges are symmetrised, sorted and deduplicated (self-loops are dropped).
+ * Each edge is then oriented from the endpoint with smaller (degree, id) to
+ * the one with the larger, so every vertex has at most sqrt(2m) out-neighbours
+ * and every triangle has exactly one vertex that sees both other vertices as
+ * out-neighbours. For each vertex, all pairs (a, b) of out-neighbours with
+ * rank(a) < rank(b) form a wedge; the wedges are sorted and merged with the
+ * oriented edges, and each wedge closed by the edge a -> b is a triangle.
+ *
+ * All passes are scans over sorters and a degree vector, so only the
+ * out-neighbours of a single vertex are held in internal memory.
+ */
+class ExternalTriangleCount {
+public:
+   using edge_type = std::pair<uint64_t, uint64_t>;
+   using degree_vector_type = stxxl::VECTOR_GENERATOR<edge_type>::result; //!< (vertex, degree)
+
+   //! Average local clustering of the vertices of one degree
+   struct DegreeClustering {
+      uint64_t number_of_vertices;
+      double sum_local_clustering;
+   };
+   using spectrum_type = std::map<uint64_t, DegreeClustering>;
+
+protected:
+   //! Sorted by (first, second); meaning of the fields depends on the sorter
+   struct Triple {
+      uint64_t first;
+      uint64_t second;
+      uint64_t third;
+
+      bool operator<(const Triple & o) const {
+         return std::tie(first, second) < std::tie(o.first, o.second);
+      }
+   };
+
+   struct EdgeCompare {
+      bool operator()(const edge_type & a, const edge_type & b) const {return a < b;}
+      edge_type min_value() const {return edge_type(std::numeric_limits<uint64_t>::min(), std::numeric_limits<uint64_t>::min());}
+      edge_type max_value() const {return edge_type(std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max());}
+   };
+
+   struct TripleCompare {
+      bool operator()(const Triple & a, const Triple & b) const {return a < b;}
+      Triple min_value() const {return Triple{std::numeric_limits<uint64_t>::min(), std::numeric_limits<uint64_t>::min(), 0};}
+      Triple max_value() const {return Triple{std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max(), 0};}
+   };
+
+   using edge_sorter_type = stxxl::sorter<edge_type, EdgeCompare>;
+   using triple_sorter_type = stxxl::sorter<Triple, TripleCompare>;
+   using vertex_sorter_type = stxxl::sorter<uint64_t, GenericComparator<uint64_t>::Ascending>;
+
+   const uint64_t _memory;
+   edge_sorter_type _arcs;
+
+   degree_vector_type _degrees;
+   spectrum_type _spectrum;
+
+   uint64_t _number_of_loops;
+   uint64_t _number_of_duplicates;
+   uint64_t _number_of_edges;
+   uint64_t _number_of_triangles;
+   uint64_t _number_of_wedges;
+   uint64_t _number_of_vertices_with_wedges;
+   double _sum_local_clustering;
+
+   //! Order used for the orientation; ties in the degree are broken by id
+   static bool _rankLess(uint64_t degree_u, uint64_t u, uint64_t degree_v, uint64_t v) {
+      return std::tie(degree_u, u) < std::tie(degree_v, v);
+   }
+
+   //! Deduplicate the arcs and write the degree of every non-isolated vertex
+   void _computeDegrees() {
+      _arcs.sort();
+      _degrees.clear();
+
+      degree_vector_type::bufwriter_type writer(_degrees);
+      edge_type last(0, 0);
+      bool first = true;
+      uint64_t arcs = 0;
+
+      for(; !_arcs.empty(); ++_arcs) {
+         const edge_type & arc = *_arcs;
+         if (!first && arc == last) {
+            _number_of_duplicates++;
+            continue;
+         }
+
+         if (!first && arc.first != last.first) {
+            writer << edge_type(last.first, arcs);
+            arcs = 0;
+         }
+
+         arcs++;
+         last = arc;
+         first = false;
+      }
+
+      if (!first)
+         writer << edge_type(last.first, arcs);
+      writer.finish();
+
+      // every undirected edge and each duplicate were pushed in both directions
+      _number_of_duplicates /= 2;
+      _arcs.rewind();
+   }
+
+   /**
+    * Attach the degree of the source to each edge {x, y} with x < y (keyed by y),
+    * then orient it by rank and push (source, target, degree of target) into @p oriented
+    */
+   void _orient(triple_sorter_type & oriented) {
+      triple_sorter_type keyed(TripleCompare(), _memory);
+      {
+         degree_vector_type::bufreader_type degrees(_degrees);
+         edge_type last(0, 0);
+         bool first = true;
+
+         for(; !_arcs.empty(); ++_arcs) {
+            const edge_type arc = *_arcs;
+            if (!first && arc == last) continue;
+            last = arc;
+            first = false;
+
+            while((*degrees).first < arc.first)
+               ++degrees;
+
+            if (arc.first < arc.second)
+               keyed.push(Triple{arc.second, arc.first, (*degrees).second});
+         }
+      }
+      _arcs.clear();
+      keyed.sort();
+
+      degree_vector_type::bufreader_type degrees(_degrees);
+      for(; !keyed.empty(); ++keyed) {
+         const Triple & edge = *keyed;
+         while((*degrees).first < edge.first)
+            ++degrees;
+
+         const uint64_t y = edge.first, degree_y = (*degrees).second;
+         const uint64_t x = edge.second, degree_x = edge.third;
+
+         if (_rankLess(degree_x, x, degree_y, y))
+            oriented.push(Triple{x, y, degree_y});
+         else
+            oriented.push(Triple{y, x, degree_x});
+
+         _number_of_edges++;
+      }
+      oriented.sort();
+   }
+
+   //! Push (a, b, center) for each pair of out-neighbours a, b of a center with rank(a) < rank(b)
+   void _generateWedges(triple_sorter_type & oriented, triple_sorter_type & wedges) {
+      std::vector<edge_type> neighbours; // (degree, id)
+
+      auto flush = [&] (uint64_t center) {
+         std::sort(neighbours.begin(), neighbours.end());
+         for(auto a = neighbours.cbegin(); a != neighbours.cend(); ++a)
+            for(auto b = a + 1; b != neighbours.cend(); ++b)
+               wedges.push(Triple{a->second, b->second, center});
+         neighbours.clear();
+      };
+
+      uint64_t center = 0;
+      for(; !oriented.empty(); ++oriented) {
+         const Triple & arc = *oriented;
+         if (arc.first != center) {
+            flush(center);
+            center = arc.first;
+         }
+         neighbours.emplace_back(arc.third, arc.second);
+      }
+      flush(center);
+
+      oriented.rewind();
+      wedges.sort();
+   }
+
+   //! Merge wedges and oriented edges; push the three vertices of each triangle
+   void _closeWedges(triple_sorter_type & oriented, triple_sorter_type & wedges, vertex_sorter_type & corners) {
+      for(; !wedges.empty(); ++wedges) {
+         const Triple & wedge = *wedges;
+         while(!oriented.empty() && *oriented < wedge)
+            ++oriented;
+
+         if (oriented.empty())
+            break;
+
+         if (!(wedge < *oriented)) {
+            corners.push(wedge.first);
+            corners.push(wedge.second);
+            corners.push(wedge.third);
+            _number_of_triangles++;
+         }
+      }
+
+      corners.sort();
+   }
+
+   //! Merge the triangles per vertex with the degrees into the clustering coefficients
+   void _computeClustering(vertex_sorter_type & corners) {
+      DistributionCount<vertex_sorter_type> triangles(corners);
+
+      for(const auto & entry : degree_vector_type::bufreader_type(_degrees)) {
+         const uint64_t vertex = entry.first, degree = entry.second;
+         while(!triangles.empty() && triangles->value < vertex)
+            ++triangles;
+
+         const uint64_t vertex_triangles = (!triangles.empty() && triangles->value == vertex) ? triangles->count : 0;
+         const uint64_t wedges = degree * (degree - 1) / 2;
+         _number_of_wedges += wedges;
+
+         double local = 0.0;
+         if (wedges) {
+            local = double(vertex_triangles) / wedges;
+            _sum_local_clustering += local;
+            _number_of_vertices_with_wedges++;
+         }
+
+         DegreeClustering & bin = _spectrum[degree];
+         bin.number_of_vertices++;
+         bin.sum_local_clustering += local;
+      }
+   }
+
+public:
+   //! @param memory  Bytes of internal memory of each sorter; at most three are alive at the same time
+   explicit ExternalTriangleCount(uint64_t memory = 1llu << 30)
+      : _memory(memory)
+      , _arcs(EdgeCompare(), memory)
+      , _number_of_loops(0)
+      , _number_of_duplicates(0)
+      , _number_of_edges(0)
+      , _number_of_triangles(0)
+      , _number_of_wedges(0)
+      , _number_of_vertices_with_wedges(0)
+      , _sum_local_clustering(0.0)
+   {}
+
+   //! Account undirected edge {u, v}; self-loops are ignored
+   void operator()(uint64_t u, uint64_t v) {
+      if (u == v) {
+         _number_of_loops++;
+         return;
+      }
+
+      _arcs.push(edge_type(u, v));
+      _arcs.push(edge_type(v, u));
+   }
+
+   //! Count the triangles and compute the clustering coefficients
+   void compute() {
+      _computeDegrees();
+
+      triple_sorter_type oriented(TripleCompare(), _memory);
+      _orient(oriented);
+
+      vertex_sorter_type corners(GenericComparator<uint64_t>::Ascending(), _memory);
+      {
+         triple_sorter_type wedges(TripleCompare(), _memory);
+         _generateWedges(oriented, wedges);
+         _closeWedges(oriented, wedges, corners);
+      }
+
+      _computeClustering(corners);
+   }
+
+   //! Number of vertices with at least one edge; requires compute()
+   uint64_t numberOfVertices() const {return _degrees.size();}
+
+   uint64_t numberOfEdges() const {return _number_of_edges;}
+   uint64_t numberOfLoops() const {return _number_of_loops;}
+   uint64_t numberOfDuplicates() const {return _number_of_duplicates;}
+   uint64_t numberOfTriangles() const {return _number_of_triangles;}
+
+   //! Number of paths of length two, i.e. sum of deg(v) choose 2
+   uint64_t numberOfWedges() const {return _number_of_wedges;}
+
+   //! Transitivity 3 * triangles / wedges
+   double globalClustering() const {
+      return _number_of_wedges ? 3.0 * _number_of_triangles / _number_of_wedges : 0.0;
+   }
+
+   //! Average local clustering over all vertices with degree >= 2
+   double averageLocalClustering() const {
+      return _number_of_vertices_with_wedges ? _sum_local_clustering / _number_of_vertices_with_wedges : 0.0;
+   }
+
+   //! Average local clustering over all non-isolated vertices (degree-1 vertices count as 0)
+   double averageLocalClusteringAllVertices() const {
+      return numberOfVertices() ? _sum_local_clustering / numberOfVertices() : 0.0;
+   }
+
+   //! Number of vertices and sum of their local clustering coefficients by degree
+   const spectrum_type & spectrum() const {return _spectrum;}
+
+   //! Write lines "degree vertices average-local-clustering"
+   void writeSpectrum(std::ostream & os) const {
+      for(const auto & bin : _spectrum)
+         os << bin.first << " " << bin.second.number_of_vertices << " "
+            << (bin.second.sum_local_clustering / bin.second.number_of_vertices) << "\n";
+      os.flush();
+   }
+};
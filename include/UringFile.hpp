@@ -0,0 +1,446 @@
+/**
+ * @file
+ * @brief Sequential file output and input through io_uring with runtime backend selection
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stxxl/io>
+#include <stxxl/bits/common/utils.h>
+
+#include <IoUring.hpp>
+
+//! @brief Runtime selection of the I/O backend used for edge list files
+struct IOBackend {
+   enum Type {
+      LinuxAIO, //!< STXXL linuxaio_file (default)
+      Uring     //!< io_uring with registered buffers and deep queues
+   };
+
+   static Type & selected() {
+      static Type type = LinuxAIO;
+      return type;
+   }
+
+   static bool uringAvailable() {
+#ifdef TFP_HAVE_IO_URING
+      return IoUring::available();
+#else
+      return false;
+#endif
+   }
+
+   //! Select backend; io_uring falls back to linuxaio if it is unavailable
+   static void select(Type type) {
+      if (type == Uring && !uringAvailable()) {
+         STXXL_ERRMSG("io_uring is not available; fall back to linuxaio");
+         type = LinuxAIO;
+      }
+      selected() = type;
+   }
+
+   static bool uring() {
+      return selected() == Uring;
+   }
+};
+
+#ifdef TFP_HAVE_IO_URING
+
+/**
+ * @brief Common part of UringWriter and UringReader
+ *
+ * Manages the file descriptor (opened with O_DIRECT if supported by the
+ * file system), the ring and a set of aligned buffers. The buffers are
+ * registered with the kernel, if permitted, to avoid mapping them per request.
+ */
+class UringFileBase {
+protected:
+   static constexpr size_t alignment = 4096;
+
+   const std::string _path;
+   int _fd;
+   bool _direct;
+
+   const size_t _block_size;
+   IoUring _ring;
+   bool _fixed_buffers;
+   std::vector<char*> _buffers;
+
+   UringFileBase(const std::string & path, int flags, size_t block_size, unsigned int queue_depth)
+      : _path(path)
+      , _fd(-1)
+      , _direct(true)
+      , _block_size((std::max(block_size, size_t(alignment)) + alignment - 1) / alignment * alignment)
+      , _ring(queue_depth)
+   {
+      _fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+      if (_fd < 0 && errno == EINVAL) {
+         // file system does not support direct I/O
+         _direct = false;
+         _fd = ::open(path.c_str(), flags, 0644);
+      }
+
+      if (_fd < 0)
+         STXXL_THROW_ERRNO(stxxl::io_error, "Cannot open " << path);
+
+      std::vector<iovec> iovecs;
+      for(unsigned int i = 0; i < _ring.entries(); i++) {
+         void* ptr;
+         if (posix_memalign(&ptr, alignment, _block_size))
+            STXXL_THROW(stxxl::io_error, "Cannot allocate I/O buffers for " << path);
+
+         _buffers.push_back(static_cast<char*>(ptr));
+         iovecs.push_back(iovec{ptr, _block_size});
+      }
+
+      _fixed_buffers = _ring.registerBuffers(iovecs);
+   }
+
+   ~UringFileBase() {
+      for(char* buffer : _buffers)
+         std::free(buffer);
+
+      if (_fd >= 0)
+         ::close(_fd);
+   }
+
+   void _prepare(bool write, unsigned int buffer, size_t length, uint64_t offset) {
+      io_uring_sqe & sqe = _ring.prepare();
+      if (_fixed_buffers) {
+         sqe.opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+         sqe.buf_index = buffer;
+      } else {
+         sqe.opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+      }
+
+      sqe.fd = _fd;
+      sqe.addr = reinterpret_cast<uint64_t>(_buffers[buffer]);
+      sqe.len = unsigned(length);
+      sqe.off = offset;
+      sqe.user_data = buffer;
+   }
+
+   //! Wait for a completion; throws on failure
+   io_uring_cqe _complete() {
+      const io_uring_cqe cqe = _ring.wait();
+      if (cqe.res < 0) {
+         errno = -cqe.res;
+         STXXL_THROW_ERRNO(stxxl::io_error, "I/O request on " << _path << " failed");
+      }
+      return cqe;
+   }
+
+public:
+   UringFileBase(const UringFileBase &) = delete;
+
+   //! True if the file is accessed with O_DIRECT
+   bool direct() const {return _direct;}
+
+   //! True if the buffers could be registered with the kernel
+   bool fixedBuffers() const {return _fixed_buffers;}
+};
+
+/**
+ * @brief Sequential file output through io_uring
+ *
+ * Data is copied into one of queue_depth buffers; a full buffer is submitted
+ * as a single write request and the next free buffer is used. Hence up to
+ * queue_depth writes are in flight. The file is truncated to the number of
+ * bytes written on close.
+ */
+class UringWriter : public UringFileBase {
+protected:
+   std::vector<size_t> _lengths;
+   std::vector<unsigned int> _free;
+   unsigned int _in_flight;
+
+   unsigned int _current;
+   size_t _fill;
+   uint64_t _offset;
+   uint64_t _bytes_written;
+   bool _closed;
+
+   void _reap() {
+      const io_uring_cqe cqe = _complete();
+      const unsigned int buffer = unsigned(cqe.user_data);
+      if (size_t(cqe.res) != _lengths[buffer])
+         STXXL_THROW(stxxl::io_error, "Short write to " << _path);
+
+      _free.push_back(buffer);
+      _in_flight--;
+   }
+
+   void _submit(size_t length) {
+      _prepare(true, _current, length, _offset);
+      _ring.submit();
+
+      _lengths[_current] = length;
+      _offset += length;
+      _in_flight++;
+
+      if (_free.empty())
+         _reap();
+
+      _current = _free.back();
+      _free.pop_back();
+      _fill = 0;
+   }
+
+public:
+   /**
+    * @param path         Output file; it is created or truncated
+    * @param block_size   Bytes per write request; rounded up to a multiple of 4 KiB
+    * @param queue_depth  Number of buffers, i.e. maximum number of requests in flight
+    */
+   explicit UringWriter(const std::string & path, size_t block_size = 1 << 20, unsigned int queue_depth = 32)
+      : UringFileBase(path, O_WRONLY | O_CREAT | O_TRUNC, block_size, queue_depth)
+      , _lengths(_buffers.size())
+      , _in_flight(0)
+      , _current(0)
+      , _fill(0)
+      , _offset(0)
+      , _bytes_written(0)
+      , _closed(false)
+   {
+      for(unsigned int i = _buffers.size() - 1; i > 0; i--)
+         _free.push_back(i);
+   }
+
+   //! Callers should close() explicitly; failures at destruction are only reported
+   ~UringWriter() {
+      try {
+         close();
+      } catch (const std::exception & e) {
+         STXXL_ERRMSG("Closing " << _path << " failed: " << e.what());
+      }
+   }
+
+   void write(const void* data, size_t size) {
+      const char* bytes = static_cast<const char*>(data);
+      _bytes_written += size;
+
+      while(size) {
+         const size_t n = std::min(size, _block_size - _fill);
+         std::memcpy(_buffers[_current] + _fill, bytes, n);
+         _fill += n;
+         bytes += n;
+         size -= n;
+
+         if (_fill == _block_size)
+            _submit(_block_size);
+      }
+   }
+
+   //! Write pending data and wait for all requests; idempotent
+   void close() {
+      if (_closed) return;
+      _closed = true;
+
+      if (_fill) {
+         size_t length = _fill;
+         if (_direct) {
+            // direct I/O requires aligned lengths; the padding is truncated below
+            length = (_fill + alignment - 1) / alignment * alignment;
+            std::memset(_buffers[_current] + _fill, 0, length - _fill);
+         }
+         _submit(length);
+      }
+
+      while(_in_flight)
+         _reap();
+
+      if (_offset != _bytes_written && ftruncate(_fd, _bytes_written))
+         STXXL_THROW_ERRNO(stxxl::io_error, "Cannot truncate " << _path);
+   }
+
+   uint64_t bytesWritten() const {
+      return _bytes_written;
+   }
+};
+
+/**
+ * @brief Sequential file input through io_uring
+ *
+ * Keeps queue_depth read requests of consecutive blocks in flight;
+ * blocks are returned in file order.
+ */
+class UringReader : public UringFileBase {
+protected:
+   uint64_t _file_size;
+   uint64_t _number_of_blocks;
+   uint64_t _next_block;    //!< next block to request
+   uint64_t _current_block; //!< next block to return
+   std::vector<int64_t> _results; //!< bytes read into buffer; negative while pending
+   unsigned int _in_flight;
+   bool _returned;          //!< the block before _current_block was handed out and may be reused
+
+   void _request(uint64_t block) {
+      const unsigned int buffer = unsigned(block % _buffers.size());
+      _prepare(false, buffer, _block_size, block * _block_size);
+      _results[buffer] = -1;
+      _in_flight++;
+   }
+
+public:
+   /**
+    * @param path         Input file
+    * @param block_size   Bytes per read request; rounded up to a multiple of 4 KiB
+    * @param queue_depth  Number of buffers, i.e. maximum number of requests in flight
+    */
+   explicit UringReader(const std::string & path, size_t block_size = 1 << 20, unsigned int queue_depth = 32)
+      : UringFileBase(path, O_RDONLY, block_size, queue_depth)
+      , _next_block(0)
+      , _current_block(0)
+      , _results(_buffers.size(), -1)
+      , _in_flight(0)
+      , _returned(false)
+   {
+      struct stat st;
+      if (fstat(_fd, &st))
+         STXXL_THROW_ERRNO(stxxl::io_error, "Cannot stat " << path);
+
+      _file_size = st.st_size;
+      _number_of_blocks = (_file_size + _block_size - 1) / _block_size;
+
+      for(; _next_block < std::min<uint64_t>(_number_of_blocks, _buffers.size()); _next_block++)
+         _request(_next_block);
+      _ring.submit();
+   }
+
+   ~UringReader() {
+      // requests still in flight refer to our buffers
+      for(; _in_flight; _in_flight--)
+         _ring.wait();
+   }
+
+   uint64_t fileSize() const {
+      return _file_size;
+   }
+
+   /**
+    * Return the next block of the file and store its length in @p bytes;
+    * nullptr at the end of the file. The block is valid until the next call.
+    */
+   const char* next(size_t & bytes) {
+      // the buffer handed out last is free again
+      if (_returned && _next_block < _number_of_blocks) {
+         _request(_next_block++);
+         _ring.submit();
+      }
+      _returned = false;
+
+      if (_current_block >= _number_of_blocks)
+         return nullptr;
+
+      const unsigned int buffer = unsigned(_current_block % _buffers.size());
+      while(_results[buffer] < 0) {
+         const io_uring_cqe cqe = _complete();
+         _results[cqe.user_data] = cqe.res;
+         _in_flight--;
+      }
+
+      bytes = std::min<uint64_t>(_block_size, _file_size - _current_block * _block_size);
+      if (uint64_t(_results[buffer]) < bytes)
+         STXXL_THROW(stxxl::io_error, "Short read from " << _path);
+
+      _current_block++;
+      _returned = true;
+      return _buffers[buffer];
+   }
+};
+
+/**
+ * @brief Values of type T stored in a file, read through io_uring
+ *
+ * Values may span block boundaries (e.g. 40 bit integers).
+ */
+template <typename T>
+class UringValueStream {
+public:
+   using value_type = T;
+
+protected:
+   UringReader _reader;
+   const char* _block;
+   size_t _bytes;
+   size_t _pos;
+   T _current;
+   bool _empty;
+
+   void _fetch() {
+      if (LIKELY(_pos + sizeof(T) <= _bytes)) {
+         std::memcpy(&_current, _block + _pos, sizeof(T));
+         _pos += sizeof(T);
+         return;
+      }
+
+      // value spans the block boundary
+      char tmp[sizeof(T)];
+      size_t have = _bytes - _pos;
+      std::memcpy(tmp, _block + _pos, have);
+
+      while(have < sizeof(T)) {
+         _block = _reader.next(_bytes);
+         if (!_block) {
+            _empty = true;
+            return;
+         }
+
+         const size_t take = std::min(sizeof(T) - have, _bytes);
+         std::memcpy(tmp + have, _block, take);
+         have += take;
+         _pos = take;
+      }
+
+      std::memcpy(&_current, tmp, sizeof(T));
+   }
+
+public:
+   explicit UringValueStream(const std::string & path, size_t block_size = 1 << 20, unsigned int queue_depth = 32)
+      : _reader(path, block_size, queue_depth)
+      , _block(nullptr)
+      , _bytes(0)
+      , _pos(0)
+      , _empty(false)
+   {
+      _fetch();
+   }
+
+   //! Number of values in the file
+   uint64_t size() const {
+      return _reader.fileSize() / sizeof(T);
+   }
+
+//! @name STXXL Streaming Interface
+//! @{
+   bool empty() const {return _empty;}
+   const T & operator*() const {return _current;}
+   UringValueStream & operator++() {_fetch(); return *this;}
+//! @}
+};
+
+#endif
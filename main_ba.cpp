@@ -15,25 +15,38 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <stxxl/cmdline>
 #include <stxxl/sorter>
 #include <stxxl/bits/containers/priority_queue.h>
 
-#include <InitialCircle.hpp>
-#include <RegularVertexTokenStream.hpp>
+#include <BAEdgeListLayout.hpp>
 #include <RandomInteger.hpp>
 #include <StreamMerger.hpp>
-#include <ProcessTokenSequence.hpp>
+#include <ProcessImplicitTokenSequence.hpp>
+#include <TokenExchange.hpp>
+#include <TieredPriorityQueue.hpp>
+#include <CompressedTokenSorter.hpp>
+#include <BucketedTokenSorter.hpp>
+#include <RandomAccessBA.hpp>
 
 #include <EdgeWriter.hpp>
+#include <HugePages.hpp>
 #include <EdgeSorter.hpp>
 #include <EdgeFilter.hpp>
+#include <PipelinedStream.hpp>
+#include <MemoryPool.hpp>
+#include <GraphGrowth.hpp>
 
 
-int main(int argc, char* argv[]) {
-   // parse command-line arguments
+//! Parameters of a run as given on the command line
+struct Config {
    uint64_t number_of_vertices = 1;
    uint64_t edges_per_vertex = 2;
    bool edge_dependencies = true;
@@ -41,101 +54,580 @@ int main(int argc, char* argv[]) {
    bool filter_self_loops = false;
    bool filter_multi_edges = false;
 
+   uint64_t window_size = 1 << 16;
+   bool tiered_pq = false;
+   bool compress_runs = false;
+   bool io_uring = false;
+   bool pipeline = false;
+   unsigned int sort_buckets = 1;
+   HugePages::Mode huge_pages = HugePages::None;
+
+   bool random_access = false;
+   uint64_t seed = 1;
+
+   unsigned int partitions = 1;
+   unsigned int rank = 0;
+   std::string exchange_dir;
+   std::string job_id;
+   unsigned int exchange_timeout = 24 * 3600;
+
    std::string output_file;
+   EdgeWriter::Format output_format = EdgeWriter::Binary;
+
+   //! Shared by the sorters, the PQ and the edge sorter (see MemoryPool)
+   uint64_t memory = uint64_t(4) << 30;
+
+   //! Graph grown from (see GraphMetadata); its random vertices precede the generated ones
+   std::string grow_from;
+   GraphMetadata prefix;
+   uint64_t prefix_vertices = 0;
+
+   // compile-time config
+   static constexpr size_t pq_size = 1 << 30;
+   static constexpr size_t pq_min_pools = 1 << 26; //!< prefetch and write pools of the STXXL PQ at least
+};
+
+/**
+ * Memory the PQ selected needs at least; it is reserved while the tokens are sorted,
+ * so the sorted tokens kept in RAM cannot take it.
+ * @tparam ExternalBucket  Far-future storage of the tiered PQ (if selected)
+ */
+template <class ExternalBucket>
+uint64_t queue_memory_required(const Config & config) {
+   if (config.tiered_pq) {
+      using pq_type = TieredPriorityQueue<Token64, ExternalBucket>;
+      return pq_type::minimumRamBytes() + pq_type::externalBytes(256, ExternalBucket::minimumBytes);
+   }
+
+   return Config::pq_size + Config::pq_min_pools;
+}
+
+/**
+ * Memory the sorters of the output need at least, i.e. the edge sorter (if filters are
+ * selected) and the ones of the output format; it is reserved until the output starts,
+ * so the sorted tokens and the PQ cannot take it.
+ */
+uint64_t output_memory_required(const Config & config) {
+   const bool filter = config.filter_self_loops || config.filter_multi_edges;
+   return filter * MemoryPool::sorterMinimumMemory() + EdgeWriter::minimumMemory(config.output_format);
+}
+
+/**
+ * Memory of the sorters of the output format (if any); as they form their runs while
+ * the vertices are produced, they get half of what is left if the edge sorter does as well.
+ */
+MemoryPool::Lease lease_writer_memory(const Config & config, MemoryPool & pool) {
+   const uint64_t minimum = EdgeWriter::minimumMemory(config.output_format);
+   if (!minimum)
+      return MemoryPool::Lease();
+
+   const bool filter = config.filter_self_loops || config.filter_multi_edges;
+   MemoryPool::Lease memory = pool.lease(std::max(minimum, filter ? pool.available() / 2 : pool.available()));
+   pool.report(std::cout, "output sorter", memory);
+   return memory;
+}
+
+/**
+ * Write the stream of vertices (two per edge) produced by TFP, optionally
+ * sorting the edges to filter self-loops and multi-edges.
+ * The edge sorter forms its runs with the memory left in the pool (at least
+ * its minimum has to be available); once
+ * @p vertices is exhausted, @p release_input frees the memory of its producer,
+ * and the merge uses everything available.
+ */
+template <class VertexStream, class ReleaseInput>
+void write_vertices(const Config & config, MemoryPool & pool, EdgeWriter & edge_writer,
+                    VertexStream & vertices, ReleaseInput release_input)
+{
+   if (config.filter_self_loops || config.filter_multi_edges) {
+      MemoryPool::Lease edge_memory = pool.lease(pool.available(), MemoryPool::sorterMinimumMemory());
+      pool.report(std::cout, "edge sorter runs", edge_memory);
+
+      EdgeSorter<VertexStream> sortedEdges(vertices, edge_memory.bytes(), [&] {
+         release_input();
+         edge_memory.release();
+         edge_memory = pool.lease(pool.available(), MemoryPool::sorterMinimumMemory());
+         pool.report(std::cout, "edge sorter merge", edge_memory);
+         return edge_memory.bytes();
+      });
+
+      EdgeFilter<decltype(sortedEdges)> filteredEdges(sortedEdges, config.filter_self_loops, config.filter_multi_edges);
+      edge_writer.writeEdges(filteredEdges);
+   } else {
+      edge_writer.writeVertices(vertices);
+   }
+}
+
+/**
+ * Run TFP on the merged token stream using the priority queue provided
+ * and write the resulting edge list. The output sorters take the memory
+ * left by the PQ, which includes @p output_reserve.
+ */
+template <class TokenStream, class PriorityQueue, class ReleaseQueue>
+void process_and_write(const Config & config, MemoryPool & pool, const BAEdgeListLayout & layout,
+                       TokenStream & tokens, PriorityQueue & prio_queue, TokenExchange & exchange,
+                       ReleaseQueue release_queue, MemoryPool::Lease & output_reserve)
+{
+   // Answers to queries of later ranks are diverted into the exchange
+   exchange.open(TokenExchange::Answer, config.rank + 1, config.partitions);
+   PartitionedPriorityQueue<PriorityQueue> partitioned_queue(prio_queue, exchange);
+
+   // Process streams
+   ProcessImplicitTokenSequence<TokenStream, decltype(partitioned_queue)>
+      process(tokens, partitioned_queue, layout, exchange.begin(), exchange.end(), config.window_size);
+
+   // Write graph into file
+   output_reserve.release();
+   EdgeWriter edge_writer(config.output_file, (exchange.end() - exchange.begin()) / 2, config.output_format,
+                          false, lease_writer_memory(config, pool));
+
+   if (config.pipeline) {
+      // TFP runs on its own thread, the writer (and edge sorter) on this one
+      PipelinedStream<decltype(process)> vertices(process);
+      write_vertices(config, pool, edge_writer, vertices, release_queue);
+   } else {
+      write_vertices(config, pool, edge_writer, process, release_queue);
+   }
+
+   edge_writer.close();
+   std::cout << "Wrote " << edge_writer.edgesWritten() << " edges" << std::endl;
+   std::cout << "Answers passed through lookahead window: " << process.windowHits() << std::endl;
+   HugePages::report();
+
+   if (config.partitions > 1)
+      std::cout << "Sent " << exchange.close(TokenExchange::Answer) << " answers to later ranks" << std::endl;
+}
+
+/**
+ * Compute the edge list positions [first_idx, end_idx) independently of all
+ * other ranks with the stateless random-access engine and write them.
+ */
+void random_access_write(const Config & config, MemoryPool & pool, const BAEdgeListLayout & layout, uint64_t first_idx, uint64_t end_idx) {
+   RandomAccessBA engine(layout, config.edge_dependencies, config.seed);
+   RandomAccessBA::Stream vertices(engine, first_idx, end_idx);
+
+   EdgeWriter edge_writer(config.output_file, (end_idx - first_idx) / 2, config.output_format,
+                          false, lease_writer_memory(config, pool));
+   write_vertices(config, pool, edge_writer, vertices, [] {});
+   edge_writer.close();
+
+   std::cout << "Wrote " << edge_writer.edgesWritten() << " edges" << std::endl;
+   std::cout << "Random positions resolved: " << vertices.lookups() << std::endl;
+   HugePages::report();
+}
+
+/**
+ * Setup the priority queue selected and run TFP on @p tokens.
+ * Once TFP is complete, the queue is destroyed and its memory as well as
+ * @p token_memory (held by the exhausted token streams) return to the pool.
+ * @p output_reserve is held until the output starts.
+ * @tparam ExternalBucket  Far-future storage of the tiered PQ (if selected)
+ */
+template <class ExternalBucket, class TokenStream>
+void select_queue_and_process(const Config & config, MemoryPool & pool, const BAEdgeListLayout & layout,
+                              TokenStream & tokens, TokenExchange & exchange, MemoryPool::Lease & token_memory,
+                              MemoryPool::Lease & output_reserve)
+{
+   const bool sorted_output = output_memory_required(config) > 0;
+
+   if (config.tiered_pq) {
+      using pq_type = TieredPriorityQueue<Token64, ExternalBucket>;
+
+      // The external buckets buffer (at most) a block and a chunk each; the heap and RAM buckets
+      // get what is left (half of it, if output sorters form runs at the same time),
+      // which bounds the width of the external buckets. At least the minimum of both was reserved.
+      MemoryPool::Lease bucket_memory = pool.lease(std::max(pq_type::externalBytes(256, ExternalBucket::minimumBytes),
+                                                            std::min(pq_type::externalBytes(), pool.available() / 4)));
+      MemoryPool::Lease queue_memory = pool.lease(std::max(pq_type::minimumRamBytes(),
+                                                           sorted_output ? pool.available() / 2 : pool.available()));
+      pool.report(std::cout, "PQ external buckets", bucket_memory);
+      pool.report(std::cout, "PQ RAM buckets", queue_memory);
+
+      std::unique_ptr<pq_type> prio_queue(new pq_type(queue_memory.bytes(), bucket_memory.bytes()));
+
+      auto release = [&] {
+         if (!prio_queue) return;
+         std::cout << "Tokens loaded from external PQ buckets: "
+                   << (prio_queue->farTokensLoaded() + prio_queue->overflowTokensLoaded()) << std::endl;
+         std::cout << "Overflow redistributed in " << prio_queue->overflowStages() << " stages; "
+                   << prio_queue->overflowTokensLoaded() << " tokens read, "
+                   << prio_queue->overflowTokensRespilled() << " written again ("
+                   << ((prio_queue->overflowTokensLoaded() + prio_queue->overflowTokensRespilled()) * sizeof(Token64) >> 20)
+                   << " MiB)" << std::endl;
+         prio_queue.reset();
+         bucket_memory.release();
+         queue_memory.release();
+         token_memory.release();
+      };
+
+      process_and_write(config, pool, layout, tokens, *prio_queue, exchange, release, output_reserve);
+      release();
+
+   } else {
+      // The internal memory of the PQ is fixed at compile-time; its prefetch and write pools
+      // get what is left (half of it, if output sorters form runs at the same time).
+      // At least the minimum of both was reserved.
+      MemoryPool::Lease queue_memory = pool.lease(Config::pq_size);
+      MemoryPool::Lease pool_memory = pool.lease(std::max(uint64_t(Config::pq_min_pools),
+                                                              sorted_output ? pool.available() / 2 : pool.available()));
+      pool.report(std::cout, "PQ pools", pool_memory);
+
+      // we need an desc comparator, since its a max-pq and we want the smallest element on top
+      using pq_type = stxxl::PRIORITY_QUEUE_GENERATOR<Token64, Token64::ComparatorDesc, Config::pq_size, size_t(1) << 30>::result;
+      //using pq_type = stxxl::priority_queue<stxxl::priority_queue_config<Token<unsigned long>, Token<unsigned long>::ComparatorDesc, 32u, 8192u, 64u, 2u, 4194304u, 64u, 2u, stxxl::RC>>;
+      std::unique_ptr<pq_type> prio_queue(new pq_type(pool_memory.bytes() / 2, pool_memory.bytes() / 2));
+
+      auto release = [&] {
+         prio_queue.reset();
+         queue_memory.release();
+         pool_memory.release();
+         token_memory.release();
+      };
+
+      process_and_write(config, pool, layout, tokens, *prio_queue, exchange, release, output_reserve);
+      release();
+   }
+}
+
+/**
+ * Generate the random tokens, collect the ones of other ranks, and run TFP.
+ * @tparam Sorter          External sorter of tokens, e.g. stxxl::sorter or CompressedTokenSorter
+ * @tparam ExternalBucket  Far-future storage of the tiered PQ (if selected)
+ */
+template <class Sorter, class ExternalBucket>
+void generate_and_process(const Config & config, MemoryPool & pool, const BAEdgeListLayout & layout, TokenExchange & exchange) {
+   const uint64_t edges_per_vertex = config.edges_per_vertex;
+   const unsigned int partitions = config.partitions;
+   const unsigned int rank = config.rank;
+
+   const uint64_t new_vertices = config.number_of_vertices - config.prefix_vertices;
+   const uint64_t first_vertex = config.prefix_vertices + new_vertices * rank / partitions;
+   const uint64_t last_vertex = config.prefix_vertices + new_vertices * (rank + 1) / partitions;
+
+   // When growing a graph, queries into its edge list are sorted with our own ones;
+   // as they are the smallest, they are answered by a scan before TFP starts
+   const uint64_t prefix_end = config.prefix.positions;
+
+   // Now generate random indices and substantially sort them,
+   // to ensure that they are available at the moment in time,
+   // when the queried value is produced. Queries to positions
+   // owned by earlier ranks are sent to them.
+   // Buckets of the id range are sorted in the background while TFP consumes the earlier ones.
+   // Until then, only the run formation needs memory (besides the minima of the PQ and
+   // the sorters started later); however, buckets sorted in the background keep their
+   // run buffers while TFP runs, so they get a quarter then.
+   MemoryPool::Lease queue_reserve = pool.lease(queue_memory_required<ExternalBucket>(config));
+   MemoryPool::Lease output_reserve = pool.lease(output_memory_required(config));
+   MemoryPool::Lease foreign_reserve = pool.lease(MemoryPool::sorterMinimumMemory());
+   const uint64_t token_minimum = config.sort_buckets * MemoryPool::sorterMinimumMemory();
+   MemoryPool::Lease token_memory = pool.lease(std::max(token_minimum, config.sort_buckets > 1 ? pool.available() / 4 : pool.available()));
+   const uint64_t merge_memory = std::max(token_minimum, std::min(pool.total() / 8, token_memory.bytes()));
+   pool.report(std::cout, "token sorter runs", token_memory);
+
+   // The buckets receive the same expected number of queries, which are issued by
+   // our positions and the ones of later ranks and concentrate on small ids
+   Token64::ComparatorAsc comparator;
+   BucketedTokenSorter<Sorter> randomTokens(comparator, token_memory.bytes(), merge_memory,
+      BucketedTokenSorter<Sorter>::queryBoundaries(prefix_end ? 0 : exchange.begin(), exchange.end(), config.sort_buckets,
+                                                   exchange.begin(), layout.firstIdxOfRandomVertex(config.number_of_vertices)));
+
+   exchange.open(TokenExchange::Query, 0, rank);
+
+   // the edges of a vertex draw from [0, weight + 2 * edge_dependencies * edge)
+   RandomBatch & random = RandomInteger<8>::generator();
+   std::vector<uint64_t> random_positions(edges_per_vertex);
+
+   uint64_t weight = layout.firstIdxOfRandomVertex(first_vertex);
+   uint64_t idx = weight + 1;
+   for(uint64_t vertex = first_vertex; vertex < last_vertex; vertex++) {
+      random.fillBounded(random_positions.data(), edges_per_vertex, weight, 2 * config.edge_dependencies);
+      for(uint64_t edge = 0; edge < edges_per_vertex; edge++) {
+         Token64 token(true, random_positions[edge], idx);
+         if (LIKELY(token.id() >= exchange.begin()) || token.id() < prefix_end)
+            randomTokens.push(token);
+         else
+            exchange.send(TokenExchange::Query, token);
+         idx += 2;
+      }
+
+      weight += 2 * edges_per_vertex;
+   }
+
+   if (partitions > 1)
+      std::cout << "Sent " << exchange.close(TokenExchange::Query) << " queries to earlier ranks" << std::endl;
+
+   // Queries of later ranks into our range are answered as if they were local ones
+   for(unsigned int from = rank + 1; from < partitions; from++)
+      exchange.receive(TokenExchange::Query, from, randomTokens);
+
+   randomTokens.sort();
+   token_memory.release();
+   token_memory = pool.lease(randomTokens.memoryAfterSort());
+
+   // Answers to our queries into earlier ranks are available only after these
+   // ranks completed their own processing; they enter as ordinary link tokens
+   foreign_reserve.release();
+   MemoryPool::Lease foreign_memory = pool.lease(rank || prefix_end ? pool.available() : MemoryPool::sorterMinimumMemory(),
+                                                 MemoryPool::sorterMinimumMemory());
+   Sorter foreignAnswers(comparator, foreign_memory.bytes(), std::min(merge_memory, foreign_memory.bytes()));
+   for(unsigned int from = 0; from < rank; from++)
+      exchange.receive(TokenExchange::Answer, from, foreignAnswers);
+
+   if (prefix_end) {
+      const uint64_t answers = foreignAnswers.size();
+      const uint64_t scanned = answerPrefixQueries(config.prefix.parts, randomTokens, foreignAnswers);
+      assert(scanned == prefix_end);
+      std::cout << "Answered " << (foreignAnswers.size() - answers) << " queries by scanning "
+                << scanned << " positions of the graph grown from" << std::endl;
+   }
+
+   foreignAnswers.sort();
+
+   // From now on, the sorted tokens only hold their merge buffers (or stay in RAM)
+   const uint64_t sorted_memory = token_memory.bytes() + MemoryPool::sorterMemoryAfterSort(
+      foreignAnswers.size() * sizeof(Token64), foreign_memory.bytes(), std::min(merge_memory, foreign_memory.bytes()));
+   token_memory.release();
+   foreign_memory.release();
+   token_memory = pool.lease(sorted_memory);
+   pool.report(std::cout, "sorted tokens", token_memory);
+
+   // Merge all these streams
+   using merger_type = StreamMerger<
+         Token64, Token64::ComparatorAsc,
+         decltype(randomTokens), decltype(foreignAnswers)
+   >;
+   merger_type merger(comparator, randomTokens, foreignAnswers);
+
+   queue_reserve.release();
+
+   if (config.pipeline) {
+      // merging the sorted runs is the first stage of the pipeline
+      PipelinedStream<merger_type> tokens(merger);
+      select_queue_and_process<ExternalBucket>(config, pool, layout, tokens, exchange, token_memory, output_reserve);
+   } else {
+      select_queue_and_process<ExternalBucket>(config, pool, layout, merger, exchange, token_memory, output_reserve);
+   }
+}
+
+//! Metadata of the graph generated, listing the parts of the graph grown from (if any)
+GraphMetadata graph_metadata(const Config & config, const BAEdgeListLayout & layout) {
+   GraphMetadata meta;
+   meta.model = "ba";
+   meta.vertices = layout.seedVertices() + config.number_of_vertices;
+   meta.positions = layout.firstIdxOfRandomVertex(config.number_of_vertices);
+   meta.parts = config.prefix.parts;
+   meta.setParameter("edges-per-vertex", config.edges_per_vertex);
+   meta.setParameter("edge-dependencies", config.edge_dependencies);
+   return meta;
+}
+
+int main(int argc, char* argv[]) {
+   // parse command-line arguments
+   Config config;
 
    {
       stxxl::cmdline_parser cp;
       cp.set_author("Manuel Penschuck <manuel at ae.cs.uni-frankfurt.de>");
       cp.set_description("Barabasi-Albert Preferential Attachment EM Graph Generator");
 
-      cp.add_param_string("filename", output_file, "Path to output file");
+      cp.add_param_string("filename", config.output_file, "Path to output file; - writes to stdout");
 
       stxxl::uint64 verts, epv;
       cp.add_param_bytes("no-vertices", verts, "Number of random vertices; positive");
       cp.add_param_bytes("edges-per-vert", epv, "Edge per random vertex; positive");
 
-      cp.add_flag('d', "edge-dependencies", edge_dependencies, "Dependencies between edges of same vertex");
-      cp.add_flag('s', "filter-self-loops", filter_self_loops, "Remove all self-loops (w/o replacement)");
-      cp.add_flag('m', "filter-multi-edges", filter_multi_edges, "Collapse parallel edges into a single one");
+      cp.add_flag('d', "edge-dependencies", config.edge_dependencies, "Dependencies between edges of same vertex");
+      cp.add_flag('s', "filter-self-loops", config.filter_self_loops, "Remove all self-loops (w/o replacement)");
+      cp.add_flag('m', "filter-multi-edges", config.filter_multi_edges, "Collapse parallel edges into a single one");
+
+      stxxl::uint64 window = config.window_size;
+      cp.add_bytes('w', "window", window, "Positions covered by lookahead window for near answers; 0 disables; default 64Ki");
+      cp.add_flag('T', "tiered-pq", config.tiered_pq, "Use tiered bucket PQ (heap, RAM and external buckets) instead of STXXL PQ");
+      cp.add_flag('C', "compress-runs", config.compress_runs, "Delta/varint compress sorter runs and external PQ buckets");
+      cp.add_flag('u', "io-uring", config.io_uring, "Write binary output through io_uring instead of linuxaio (falls back if unavailable)");
+      cp.add_flag('p', "pipeline", config.pipeline, "Run merging of sorted tokens, TFP and output on three threads");
+      cp.add_uint('b', "sort-buckets", config.sort_buckets, "Split random tokens into this many id ranges; all but the first are sorted while TFP runs; default 1");
+
+      cp.add_flag('r', "random-access", config.random_access, "Compute each edge independently with a counter-based RNG instead of TFP; needs no exchange between partitions");
+      stxxl::uint64 seed = config.seed;
+      cp.add_bytes('S', "seed", seed, "Seed of the random-access engine; default 1");
+
+      cp.add_uint('P', "partitions", config.partitions, "Number of cooperating processes; default 1");
+      cp.add_uint('R', "rank", config.rank, "Rank of this process in [0, partitions)");
+      cp.add_string('e', "exchange-dir", config.exchange_dir, "Directory shared by all processes to exchange tokens");
+      cp.add_string('J', "job-id", config.job_id, "Identifier of the run shared by all processes; part of the exchange file names");
+      cp.add_uint('x', "exchange-timeout", config.exchange_timeout, "Seconds to wait for tokens of another rank before giving up; 0 waits forever; default 86400");
+
+      std::string format = "binary";
+      cp.add_string('f', "format", format, "Output format: binary (default), text, mtx (Matrix Market), metis or degrees");
+
+      stxxl::uint64 memory = config.memory;
+      cp.add_bytes('M', "memory", memory, "Internal memory handed from the token sorter to the PQ to the edge sorter; default 4Gi");
+
+      cp.add_string('G', "grow-from", config.grow_from, "Continue the binary output of a previous run (see its .meta file); only the vertices beyond it are generated and written");
+
+      std::string huge_pages = "none";
+      cp.add_string('H', "huge-pages", huge_pages, "Back sorter, PQ and writer buffers with huge pages: none (default), thp, 2m or 1g");
 
       if (!cp.process(argc, argv)) return -1;
 
+      if (!HugePages::parseMode(huge_pages, config.huge_pages)) {
+         std::cout << "huge-pages is none, thp, 2m or 1g" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
+      // restarts the process once if huge pages are requested
+      HugePages::enable(config.huge_pages, argv);
+
+      if (!EdgeWriter::parseFormat(format, config.output_format)) {
+         std::cout << "format is binary, text, mtx, metis or degrees" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
+      // keep stdout free for the edges
+      FdSink::redirectMessages(config.output_file);
+      IOBackend::select(config.io_uring ? IOBackend::Uring : IOBackend::LinuxAIO);
+
       if (!verts || !epv) {
          cp.print_usage();
          return -1;
       }
 
+      if (!config.sort_buckets || config.sort_buckets > 256) {
+         std::cout << "sort-buckets in [1, 256]" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
+      // the PQ and the token sorters (buckets and foreign answers) are only needed by TFP
+      const uint64_t queue_memory = config.compress_runs
+         ? queue_memory_required<CompressedTokenBucket<Token64>>(config)
+         : queue_memory_required<ExternalTokenBucket<Token64>>(config);
+      const uint64_t required_memory = output_memory_required(config) + (config.random_access ? 0
+         : 2 * queue_memory + (config.sort_buckets + 1) * MemoryPool::sorterMinimumMemory());
+      if (memory < required_memory) {
+         std::cout << "memory >= " << (required_memory >> 20) << " MiB for the PQ and sorters selected" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
+      if (!config.partitions || config.rank >= config.partitions || config.partitions > verts
+          || (config.partitions > 1 && (config.exchange_dir.empty() || config.job_id.empty()) && !config.random_access)) {
+         std::cout << "partitions > 0; rank < partitions; partitions <= no-vertices; exchange-dir and job-id required if partitions > 1 (except for random-access)" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
+      if (config.partitions > 1 && (config.filter_self_loops || config.filter_multi_edges
+                                    || config.output_format == EdgeWriter::Degrees)) {
+         // each rank only sees the edges of its own shard
+         std::cout << "filter-self-loops, filter-multi-edges and format degrees require partitions = 1" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
+      if (config.job_id.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789._-") != std::string::npos) {
+         std::cout << "job-id consists of letters, digits, '.', '_' and '-'" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
       // apply config
       cp.print_result();
-      number_of_vertices = verts;
-      edges_per_vertex = epv;
+      config.window_size = window;
+      config.memory = memory;
+      config.seed = seed;
+      config.number_of_vertices = verts;
+      config.edges_per_vertex = epv;
    }
 
-   // compile-time config
-   const unsigned int sorter_size = 1 << 30;
-   constexpr size_t pq_size = 1 << 30;
+   const uint64_t number_of_vertices = config.number_of_vertices;
+   const unsigned int partitions = config.partitions;
+   const unsigned int rank = config.rank;
 
-   // This stream yields all token to define a small initial circle
-   InitialCircle seedTokens(2 * edges_per_vertex);
+   // The seed graph is a circle with 2*edges_per_vertex vertices and edges;
+   // its tokens as well as the regular vertices are implicit, i.e. computed by
+   // the TFP loop on the fly, and do not need to be materialised as tokens
+   const BAEdgeListLayout layout(2 * config.edges_per_vertex, config.edges_per_vertex);
 
-   // This stream gives all "fixed" vertices of the edge list
-   RegularVertexTokenStream regularTokens(
-      seedTokens.maxVertexId() + 1,
-      2*seedTokens.numberOfEdges(),
-      number_of_vertices,
-      edges_per_vertex
-   );
+   const bool filter = config.filter_self_loops || config.filter_multi_edges;
+   const std::string output_file = config.output_file;
 
-   // Now generate random indices and substantially sort them,
-   // to ensure that they are available at the moment in time,
-   // when the queried value is produced
-   Token64::ComparatorAsc comparator;
-   stxxl::sorter<Token64, Token64::ComparatorAsc> randomTokens(comparator, sorter_size);
+   if (!config.grow_from.empty()) {
+      GraphMetadata & prefix = config.prefix;
+      if (!prefix.read(GraphMetadata::path(config.grow_from))) {
+         std::cout << "Cannot read " << GraphMetadata::path(config.grow_from) << std::endl;
+         return -1;
+      }
 
-   uint64_t weight = seedTokens.numberOfEdges() * 2;
-   uint64_t idx = weight + 1;
-   for(uint64_t vertex = 0; vertex < number_of_vertices; vertex++) {
-      uint64_t this_weight = weight;
-      for(uint64_t edge = 0; edge < edges_per_vertex; edge++) {
-         Token64 token(true, RandomInteger<8>::randint(this_weight), idx);
-         randomTokens.push(token);
-         this_weight += 2 * edge_dependencies;
-         idx += 2;
+      if (!graph_metadata(config, layout).compatible(prefix, std::cout))
+         return -1;
+
+      if (config.random_access || filter || config.output_format != EdgeWriter::Binary) {
+         std::cout << "grow-from requires binary output without filters and excludes random-access" << std::endl;
+         return -1;
       }
 
-      weight += 2 * edges_per_vertex;
-   }
-   randomTokens.sort();
+      if (prefix.storedPositions() != prefix.positions) {
+         std::cout << "The parts of the graph grown from hold " << prefix.storedPositions()
+                   << " instead of " << prefix.positions << " positions" << std::endl;
+         return -1;
+      }
 
-   // Merge all these streams
-   using merger_type = StreamMerger<
-         Token64, Token64::ComparatorAsc,
-         decltype(regularTokens), decltype(randomTokens), decltype(seedTokens)
-   >;
-   merger_type merger(comparator, regularTokens, randomTokens, seedTokens);
+      config.prefix_vertices = (prefix.positions - layout.firstRandomIdx()) / (2 * config.edges_per_vertex);
+      if (number_of_vertices <= config.prefix_vertices
+          || number_of_vertices - config.prefix_vertices < partitions) {
+         std::cout << "no-vertices >= " << (config.prefix_vertices + partitions)
+                   << " to grow a graph of " << config.prefix_vertices << " random vertices" << std::endl;
+         return -1;
+      }
 
-   // Setup priority queue
-   // we need an desc comparator, since its a max-pq and we want the smallest element on top
-   using pq_type = stxxl::PRIORITY_QUEUE_GENERATOR<Token64, Token64::ComparatorDesc, pq_size, size_t(1) << 30>::result;
-   //using pq_type = stxxl::priority_queue<stxxl::priority_queue_config<Token<unsigned long>, Token<unsigned long>::ComparatorDesc, 32u, 8192u, 64u, 2u, 4194304u, 64u, 2u, stxxl::RC>>;
-   pq_type prio_queue(pq_size / 2, pq_size / 2);
+      std::cout << "Growing graph of " << config.prefix_vertices << " random vertices stored in "
+                << prefix.parts.size() << " part(s)" << std::endl;
+   }
 
-   // Process streams
-   ProcessTokenSequence<decltype(merger), decltype(prio_queue)> process(merger, prio_queue);
+   // Partition the new random vertices (and hence the edge list) into consecutive ranges;
+   // the first rank additionally owns the seed graph unless a graph is grown
+   std::vector<uint64_t> partition_boundaries(1, config.prefix.positions);
+   for(unsigned int r = 1; r <= partitions; r++)
+      partition_boundaries.push_back(layout.firstIdxOfRandomVertex(
+         config.prefix_vertices + (number_of_vertices - config.prefix_vertices) * r / partitions));
 
-   // Write graph into file
-   EdgeWriter edge_writer(output_file, seedTokens.numberOfEdges() + number_of_vertices*edges_per_vertex);
+   if (partitions > 1) {
+      if (config.output_file != "-")
+         config.output_file += "." + std::to_string(rank);
+      std::cout << "Rank " << rank << " of " << partitions << " owns edge list positions ["
+                << partition_boundaries[rank] << ", " << partition_boundaries[rank + 1] << ")" << std::endl;
+   }
 
+   MemoryPool pool(config.memory);
 
-   if (filter_self_loops || filter_multi_edges) {
-      EdgeSorter<decltype(process)> sortedEdges(process, sorter_size);
-      EdgeFilter<decltype(sortedEdges)> filteredEdges(sortedEdges, filter_self_loops, filter_multi_edges);
-      edge_writer.writeEdges(filteredEdges);
+   if (config.random_access) {
+      // no exchange (and hence no exchange directory) is involved
+      random_access_write(config, pool, layout, partition_boundaries[rank], partition_boundaries[rank + 1]);
    } else {
-      edge_writer.writeVertices(process);
+      TokenExchange exchange(config.exchange_dir, config.job_id, rank, partition_boundaries,
+                             std::chrono::seconds(config.exchange_timeout));
+
+      if (config.compress_runs)
+         generate_and_process<CompressedTokenSorter<Token64>, CompressedTokenBucket<Token64>>(config, pool, layout, exchange);
+      else
+         generate_and_process<stxxl::sorter<Token64, Token64::ComparatorAsc>, ExternalTokenBucket<Token64>>(config, pool, layout, exchange);
    }
 
-   std::cout << "Wrote " << edge_writer.edgesWritten() << " edges" << std::endl;
+   std::cout << "Peak memory leased: " << (pool.peak() >> 20) << " MiB of " << (pool.total() >> 20) << " MiB" << std::endl;
+
+   // Allow to grow the graph later; the first rank lists the files of all ranks
+   if (!rank && !filter && config.output_format == EdgeWriter::Binary && output_file != "-") {
+      GraphMetadata meta = graph_metadata(config, layout);
+      for(unsigned int r = 0; r < partitions; r++)
+         meta.parts.push_back(partitions > 1 ? output_file + "." + std::to_string(r) : output_file);
+
+      if (!meta.write(GraphMetadata::path(output_file)))
+         std::cout << "Cannot write " << GraphMetadata::path(output_file) << std::endl;
+   }
 
    return 0;
 }
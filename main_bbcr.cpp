@@ -19,7 +19,10 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <string>
 
 #include <stxxl/cmdline>
 #include <stxxl/sorter>
@@ -28,29 +31,316 @@
 #include <InitialCircle.hpp>
 #include <StreamMerger.hpp>
 #include <ProcessTokenSequence.hpp>
+#include <TieredPriorityQueue.hpp>
+#include <CompressedTokenSorter.hpp>
 
 #include <EdgeWriter.hpp>
+#include <HugePages.hpp>
 #include <EdgeSorter.hpp>
 #include <EdgeFilter.hpp>
+#include <MemoryPool.hpp>
+#include <GraphGrowth.hpp>
 
 #include "models/ModelBBCR.hpp"
 
-int main(int argc, char* argv[]) {
-   // parse command-line arguments
+//! Parameters of a run as given on the command line
+struct Config {
    uint64_t number_of_seed_vertices = 2;
    uint64_t number_of_edges = 1;
 
    bool filter_self_loops = false;
    bool filter_multi_edges = false;
 
+   uint64_t window_size = 1 << 16;
+   bool tiered_pq = false;
+   bool compress_runs = false;
+   bool io_uring = false;
+   HugePages::Mode huge_pages = HugePages::None;
+
    double alpha = 0.1;
    double beta  = 0.8;
    double gamma = 0.1;
+   bool beta_runs = false;
 
    double degree_offset_out = 0.0;
    double degree_offset_in = 0.0;
 
    std::string output_file;
+   EdgeWriter::Format output_format = EdgeWriter::Binary;
+
+   //! Shared by the token sorter, the PQ and the edge sorter (see MemoryPool)
+   uint64_t memory = uint64_t(4) << 30;
+
+   //! Graph grown from (see GraphMetadata); its random edges precede the generated ones
+   std::string grow_from;
+   GraphMetadata prefix;
+   uint64_t prefix_edges = 0;
+
+   // compile-time config
+   static constexpr size_t pq_size = 1 << 30;
+   static constexpr size_t pq_min_pools = 1 << 26; //!< prefetch and write pools of the STXXL PQ at least
+};
+
+/**
+ * Memory the PQ selected needs at least; it is reserved while the tokens are sorted,
+ * so the sorted tokens kept in RAM cannot take it.
+ * @tparam ExternalBucket  Far-future storage of the tiered PQ (if selected)
+ */
+template <class ExternalBucket>
+uint64_t queue_memory_required(const Config & config) {
+   if (config.tiered_pq) {
+      using pq_type = TieredPriorityQueue<Token64, ExternalBucket>;
+      return pq_type::minimumRamBytes() + pq_type::externalBytes(256, ExternalBucket::minimumBytes);
+   }
+
+   return Config::pq_size + Config::pq_min_pools;
+}
+
+/**
+ * Memory the sorters of the output need at least, i.e. the edge sorter (if filters are
+ * selected) and the ones of the output format; it is reserved until the output starts,
+ * so the sorted tokens and the PQ cannot take it.
+ */
+uint64_t output_memory_required(const Config & config) {
+   const bool filter = config.filter_self_loops || config.filter_multi_edges;
+   return filter * MemoryPool::sorterMinimumMemory() + EdgeWriter::minimumMemory(config.output_format, true);
+}
+
+/**
+ * Memory of the sorters of the output format (if any); as they form their runs while
+ * the edges are produced, they get half of what is left if the edge sorter does as well.
+ */
+MemoryPool::Lease lease_writer_memory(const Config & config, MemoryPool & pool) {
+   const uint64_t minimum = EdgeWriter::minimumMemory(config.output_format, true);
+   if (!minimum)
+      return MemoryPool::Lease();
+
+   const bool filter = config.filter_self_loops || config.filter_multi_edges;
+   MemoryPool::Lease memory = pool.lease(std::max(minimum, filter ? pool.available() / 2 : pool.available()));
+   pool.report(std::cout, "output sorter", memory);
+   return memory;
+}
+
+/**
+ * Run TFP on the merged token stream using the priority queue provided
+ * and write the resulting edge list.
+ * The output sorters form their runs with the memory left in the pool, which
+ * includes @p output_reserve. Once TFP is complete, @p release_queue frees
+ * the PQ and the sorted tokens, and the merge of the edge sorter uses everything available.
+ */
+template <class TokenStream, class PriorityQueue, class ReleaseQueue>
+void process_and_write(const Config & config, MemoryPool & pool, TokenStream & tokens, PriorityQueue & prio_queue,
+                       uint64_t first_idx, uint64_t expected_edges, ReleaseQueue release_queue,
+                       MemoryPool::Lease & output_reserve)
+{
+   const bool filter = config.filter_self_loops || config.filter_multi_edges;
+
+   // Process streams
+   ProcessTokenSequence<TokenStream, PriorityQueue> process(tokens, prio_queue, first_idx, config.window_size);
+
+   // Write graph into file
+   output_reserve.release();
+   EdgeWriter edge_writer(config.output_file, expected_edges, config.output_format, true, lease_writer_memory(config, pool));
+
+   if (filter) {
+      MemoryPool::Lease edge_memory = pool.lease(pool.available(), MemoryPool::sorterMinimumMemory());
+      pool.report(std::cout, "edge sorter runs", edge_memory);
+
+      EdgeSorter<decltype(process)> sortedEdges(process, edge_memory.bytes(), [&] {
+         release_queue();
+         edge_memory.release();
+         edge_memory = pool.lease(pool.available(), MemoryPool::sorterMinimumMemory());
+         pool.report(std::cout, "edge sorter merge", edge_memory);
+         return edge_memory.bytes();
+      });
+
+      EdgeFilter<decltype(sortedEdges)> filteredEdges(sortedEdges, config.filter_self_loops, config.filter_multi_edges);
+      edge_writer.writeEdges(filteredEdges);
+   } else {
+      edge_writer.writeVertices(process);
+   }
+
+   edge_writer.close();
+   std::cout << "Wrote " << edge_writer.edgesWritten() << " edges" << std::endl;
+   std::cout << "Answers passed through lookahead window: " << process.windowHits() << std::endl;
+   HugePages::report();
+}
+
+/**
+ * Setup the priority queue selected and run TFP on @p tokens, which start at
+ * edge list position @p first_idx.
+ * Once TFP is complete, the queue is destroyed and its memory as well as
+ * @p token_memory (held by the exhausted token streams) return to the pool.
+ * @p output_reserve is held until the output starts.
+ * @tparam ExternalBucket  Far-future storage of the tiered PQ (if selected)
+ */
+template <class ExternalBucket, class TokenStream>
+void select_queue_and_process(const Config & config, MemoryPool & pool, TokenStream & tokens,
+                              uint64_t first_idx, uint64_t expected_edges, MemoryPool::Lease & token_memory,
+                              MemoryPool::Lease & output_reserve)
+{
+   const bool sorted_output = output_memory_required(config) > 0;
+   if (config.tiered_pq) {
+      using pq_type = TieredPriorityQueue<Token64, ExternalBucket>;
+
+      // The external buckets buffer (at most) a block and a chunk each; the heap and RAM buckets
+      // get what is left (half of it, if output sorters form runs at the same time),
+      // which bounds the width of the external buckets. At least the minimum of both was reserved.
+      MemoryPool::Lease bucket_memory = pool.lease(std::max(pq_type::externalBytes(256, ExternalBucket::minimumBytes),
+                                                            std::min(pq_type::externalBytes(), pool.available() / 4)));
+      MemoryPool::Lease queue_memory = pool.lease(std::max(pq_type::minimumRamBytes(),
+                                                           sorted_output ? pool.available() / 2 : pool.available()));
+      pool.report(std::cout, "PQ external buckets", bucket_memory);
+      pool.report(std::cout, "PQ RAM buckets", queue_memory);
+
+      std::unique_ptr<pq_type> prio_queue(new pq_type(queue_memory.bytes(), bucket_memory.bytes()));
+
+      auto release = [&] {
+         if (!prio_queue) return;
+         std::cout << "Tokens loaded from external PQ buckets: "
+                   << (prio_queue->farTokensLoaded() + prio_queue->overflowTokensLoaded()) << std::endl;
+         std::cout << "Overflow redistributed in " << prio_queue->overflowStages() << " stages; "
+                   << prio_queue->overflowTokensLoaded() << " tokens read, "
+                   << prio_queue->overflowTokensRespilled() << " written again ("
+                   << ((prio_queue->overflowTokensLoaded() + prio_queue->overflowTokensRespilled()) * sizeof(Token64) >> 20)
+                   << " MiB)" << std::endl;
+         prio_queue.reset();
+         bucket_memory.release();
+         queue_memory.release();
+         token_memory.release();
+      };
+
+      process_and_write(config, pool, tokens, *prio_queue, first_idx, expected_edges, release, output_reserve);
+      release();
+
+   } else {
+      // The internal memory of the PQ is fixed at compile-time; its prefetch and write pools
+      // get what is left (half of it, if output sorters form runs at the same time).
+      // At least the minimum of both was reserved.
+      MemoryPool::Lease queue_memory = pool.lease(Config::pq_size);
+      MemoryPool::Lease pool_memory = pool.lease(std::max(uint64_t(Config::pq_min_pools),
+                                                          sorted_output ? pool.available() / 2 : pool.available()));
+      pool.report(std::cout, "PQ pools", pool_memory);
+
+      // we need an desc comparator, since its a max-pq and we want the smallest element on top
+      using pq_type = stxxl::PRIORITY_QUEUE_GENERATOR<Token64, Token64::ComparatorDesc, Config::pq_size, size_t(1) << 20>::result;
+      //using pq_type = stxxl::priority_queue<stxxl::priority_queue_config<Token<unsigned long>, Token<unsigned long>::ComparatorDesc, 32u, 8192u, 64u, 2u, 4194304u, 64u, 2u, stxxl::RC>>;
+      std::unique_ptr<pq_type> prio_queue(new pq_type(pool_memory.bytes() / 2, pool_memory.bytes() / 2));
+
+      auto release = [&] {
+         prio_queue.reset();
+         queue_memory.release();
+         pool_memory.release();
+         token_memory.release();
+      };
+
+      process_and_write(config, pool, tokens, *prio_queue, first_idx, expected_edges, release, output_reserve);
+      release();
+   }
+}
+
+/**
+ * Generate the random tokens of the model, merge them with the seed graph
+ * (or the answers from the graph grown from), and run TFP.
+ * @tparam Sorter          External sorter of tokens, e.g. stxxl::sorter or CompressedTokenSorter
+ * @tparam ExternalBucket  Far-future storage of the tiered PQ (if selected)
+ * @return Number of vertices of the graph generated
+ */
+template <class Sorter, class ExternalBucket>
+uint64_t generate_and_process(const Config & config, MemoryPool & pool) {
+   // This stream yields all token to define a small initial circle
+   InitialCircle seedTokens(config.number_of_seed_vertices);
+
+   // A grown graph continues the edge list of the graph grown from instead of the circle
+   const uint64_t prefix_end = config.prefix.positions;
+   const uint64_t new_edges = config.number_of_edges - config.prefix_edges;
+
+   // Now generate random indices and substantially sort them,
+   // to ensure that they are available at the moment in time,
+   // when the queried value is produced. Until then, only the
+   // run formation of the sorter needs memory (besides the minima of
+   // the PQ and the sorters started later).
+   MemoryPool::Lease queue_reserve = pool.lease(queue_memory_required<ExternalBucket>(config));
+   MemoryPool::Lease output_reserve = pool.lease(output_memory_required(config));
+   MemoryPool::Lease answer_reserve = pool.lease(prefix_end ? MemoryPool::sorterMinimumMemory() : 0);
+   MemoryPool::Lease token_memory = pool.lease(pool.available(), MemoryPool::sorterMinimumMemory());
+   const uint64_t merge_memory = std::max(MemoryPool::sorterMinimumMemory(), std::min(pool.total() / 8, token_memory.bytes()));
+   pool.report(std::cout, "token sorter runs", token_memory);
+
+   ModelBBCR<Sorter> model(
+         new_edges,
+         prefix_end ? config.prefix.vertices : seedTokens.maxVertexId() + 1,
+         prefix_end ? prefix_end / 2 : seedTokens.numberOfEdges(),
+         config.alpha, config.beta,
+         config.degree_offset_in, config.degree_offset_out,
+         token_memory.bytes(), config.beta_runs, merge_memory
+   );
+
+   // From now on, the sorted tokens only hold their merge buffers (or stay in RAM)
+   const uint64_t sorted_memory = MemoryPool::sorterMemoryAfterSort(
+      model.sorter().size() * sizeof(Token64), token_memory.bytes(), merge_memory);
+   token_memory.release();
+   token_memory = pool.lease(sorted_memory);
+
+   Token64::ComparatorAsc compare;
+
+   if (!prefix_end) {
+      pool.report(std::cout, "sorted tokens", token_memory);
+
+      // Merge all these streams
+      using merger_type = StreamMerger<Token64, Token64::ComparatorAsc, typename decltype(model)::sorter_type, decltype(seedTokens)>;
+      merger_type merger(compare, model.sorter(), seedTokens);
+
+      queue_reserve.release();
+      select_queue_and_process<ExternalBucket>(config, pool, merger, 0, seedTokens.numberOfEdges() + new_edges,
+                                               token_memory, output_reserve);
+      return model.numberOfVertices();
+   }
+
+   // Queries into the graph grown from are the smallest ones; a scan of its
+   // files answers them, and the answers enter as ordinary link tokens
+   answer_reserve.release();
+   MemoryPool::Lease answer_memory = pool.lease(pool.available(), MemoryPool::sorterMinimumMemory());
+   const uint64_t answer_merge_memory = std::min(merge_memory, answer_memory.bytes());
+   Sorter prefixAnswers(compare, answer_memory.bytes(), answer_merge_memory);
+
+   const uint64_t scanned = answerPrefixQueries(config.prefix.parts, model.sorter(), prefixAnswers);
+   std::cout << "Answered " << prefixAnswers.size() << " queries by scanning "
+             << scanned << " positions of the graph grown from" << std::endl;
+   prefixAnswers.sort();
+
+   const uint64_t answered_memory = token_memory.bytes() + MemoryPool::sorterMemoryAfterSort(
+      prefixAnswers.size() * sizeof(Token64), answer_memory.bytes(), answer_merge_memory);
+   token_memory.release();
+   answer_memory.release();
+   token_memory = pool.lease(answered_memory);
+   pool.report(std::cout, "sorted tokens", token_memory);
+
+   using merger_type = StreamMerger<Token64, Token64::ComparatorAsc, typename decltype(model)::sorter_type, Sorter>;
+   merger_type merger(compare, model.sorter(), prefixAnswers);
+
+   queue_reserve.release();
+   select_queue_and_process<ExternalBucket>(config, pool, merger, prefix_end, new_edges, token_memory, output_reserve);
+   return model.numberOfVertices();
+}
+
+//! Metadata of the graph generated, listing the parts of the graph grown from (if any)
+GraphMetadata graph_metadata(const Config & config) {
+   GraphMetadata meta;
+   meta.model = "bbcr";
+   meta.positions = 2 * (InitialCircle(config.number_of_seed_vertices).numberOfEdges() + config.number_of_edges);
+   meta.parts = config.prefix.parts;
+   meta.setParameter("seed-vertices", config.number_of_seed_vertices);
+   meta.setParameter("alpha", config.alpha);
+   meta.setParameter("beta", config.beta);
+   meta.setParameter("d-in", config.degree_offset_in);
+   meta.setParameter("d-out", config.degree_offset_out);
+   return meta;
+}
+
+int main(int argc, char* argv[]) {
+   // parse command-line arguments
+   Config config;
 
    {
       stxxl::cmdline_parser cp;
@@ -61,36 +351,73 @@ int main(int argc, char* argv[]) {
             "B Bollobas, C. Borgs, J. Chayes, O. Riordan"
       );
 
-      cp.add_param_string("filename", output_file, "Path to output file");
+      cp.add_param_string("filename", config.output_file, "Path to output file; - writes to stdout");
 
       stxxl::uint64 edges, seed_verts=100;
       cp.add_param_bytes("no-edges", edges, "Number of random edges; positive");
       cp.add_bytes('n', "seed-vertices", seed_verts, "Number of seed vertices");
 
-      cp.add_double('a', "alpha", alpha, "Relative prob. to add new vertex with outgoing edge");
-      cp.add_double('b', "beta",  beta,  "Relative prob. to link two existing vertices");
-      cp.add_double('g', "gamma", gamma, "Relative prob. to add new vertex with incoming edge");
+      cp.add_double('a', "alpha", config.alpha, "Relative prob. to add new vertex with outgoing edge");
+      cp.add_double('b', "beta",  config.beta,  "Relative prob. to link two existing vertices");
+      cp.add_double('g', "gamma", config.gamma, "Relative prob. to add new vertex with incoming edge");
+      cp.add_flag('B', "beta-runs", config.beta_runs, "Draw lengths of runs of beta edges geometrically instead of one mode per edge");
+
+      cp.add_double('y', "d-in", config.degree_offset_in, "Non-negative offset in  in-degree distribution");
+      cp.add_double('z', "d-out", config.degree_offset_out, "Non-negative offset in  in-degree distribution");
+
+      cp.add_flag('s', "filter-self-loops", config.filter_self_loops, "Remove all self-loops (w/o replacement)");
+      cp.add_flag('m', "filter-multi-edges", config.filter_multi_edges, "Collapse parallel edges into a single one");
+
+      stxxl::uint64 window = config.window_size;
+      cp.add_bytes('w', "window", window, "Positions covered by lookahead window for near answers; 0 disables; default 64Ki");
+      cp.add_flag('T', "tiered-pq", config.tiered_pq, "Use tiered bucket PQ (heap, RAM and external buckets) instead of STXXL PQ");
+      cp.add_flag('C', "compress-runs", config.compress_runs, "Delta/varint compress sorter runs and external PQ buckets");
+      cp.add_flag('u', "io-uring", config.io_uring, "Write binary output through io_uring instead of linuxaio (falls back if unavailable)");
 
-      cp.add_double('y', "d-in", degree_offset_in, "Non-negative offset in  in-degree distribution");
-      cp.add_double('z', "d-out", degree_offset_out, "Non-negative offset in  in-degree distribution");
+      std::string format = "binary";
+      cp.add_string('f', "format", format, "Output format: binary (default), text, mtx (Matrix Market), metis or degrees");
 
-      cp.add_flag('s', "filter-self-loops", filter_self_loops, "Remove all self-loops (w/o replacement)");
-      cp.add_flag('m', "filter-multi-edges", filter_multi_edges, "Collapse parallel edges into a single one");
+      stxxl::uint64 memory = config.memory;
+      cp.add_bytes('M', "memory", memory, "Internal memory handed from the token sorter to the PQ to the edge sorter; default 4Gi");
+
+      cp.add_string('G', "grow-from", config.grow_from, "Continue the binary output of a previous run (see its .meta file); only the edges beyond it are generated and written");
+
+      std::string huge_pages = "none";
+      cp.add_string('H', "huge-pages", huge_pages, "Back sorter, PQ and writer buffers with huge pages: none (default), thp, 2m or 1g");
 
       if (!cp.process(argc, argv)) return -1;
 
-      if (alpha < 0 || beta < 0 || gamma < 0 || (alpha + beta + gamma) < 1e-9) {
+      if (!HugePages::parseMode(huge_pages, config.huge_pages)) {
+         std::cout << "huge-pages is none, thp, 2m or 1g" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
+      // restarts the process once if huge pages are requested
+      HugePages::enable(config.huge_pages, argv);
+
+      if (!EdgeWriter::parseFormat(format, config.output_format)) {
+         std::cout << "format is binary, text, mtx, metis or degrees" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
+      // keep stdout free for the edges
+      FdSink::redirectMessages(config.output_file);
+      IOBackend::select(config.io_uring ? IOBackend::Uring : IOBackend::LinuxAIO);
+
+      if (config.alpha < 0 || config.beta < 0 || config.gamma < 0 || (config.alpha + config.beta + config.gamma) < 1e-9) {
          std::cout << "alpha, beta, gamma >= 0" << std::endl;
          cp.print_usage();
          return -1;
       } else {
-         double norm = alpha + beta + gamma;
-         alpha /= norm;
-         beta  /= norm;
-         //gamma /= norm;
+         double norm = config.alpha + config.beta + config.gamma;
+         config.alpha /= norm;
+         config.beta  /= norm;
+         //config.gamma /= norm;
       }
 
-      if (degree_offset_in < 0 || degree_offset_out < 0) {
+      if (config.degree_offset_in < 0 || config.degree_offset_out < 0) {
          std::cout << "d-in, d-out >= 0" << std::endl;
          cp.print_usage();
          return -1;
@@ -102,57 +429,79 @@ int main(int argc, char* argv[]) {
          return -1;
       }
 
+      const uint64_t queue_memory = config.compress_runs
+         ? queue_memory_required<CompressedTokenBucket<Token64>>(config)
+         : queue_memory_required<ExternalTokenBucket<Token64>>(config);
+      // the token sorter and the sorter answering queries into a graph grown from
+      const uint64_t required_memory = 2 * queue_memory + output_memory_required(config)
+         + (config.grow_from.empty() ? 1 : 2) * MemoryPool::sorterMinimumMemory();
+      if (memory < required_memory) {
+         std::cout << "memory >= " << (required_memory >> 20) << " MiB for the PQ and sorters selected" << std::endl;
+         cp.print_usage();
+         return -1;
+      }
+
       // apply config
       cp.print_result();
-      number_of_edges = edges;
-      number_of_seed_vertices = seed_verts;
+      config.window_size = window;
+      config.memory = memory;
+      config.number_of_edges = edges;
+      config.number_of_seed_vertices = seed_verts;
    }
 
-   // compile-time config
-   const unsigned int sorter_size = 1 << 30;
-   constexpr size_t pq_size = 1 << 30;
-
-   // This stream yields all token to define a small initial circle
-   InitialCircle seedTokens(number_of_seed_vertices);
+   const bool filter = config.filter_self_loops || config.filter_multi_edges;
 
-   // Now generate random indices and substantially sort them,
-   // to ensure that they are available at the moment in time,
-   // when the queried value is produced
-   ModelBBCR model(
-         number_of_edges,
-         seedTokens.maxVertexId() + 1,
-         seedTokens.numberOfEdges(),
-         alpha, beta,
-         degree_offset_in, degree_offset_out,
-         sorter_size
-   );
+   if (!config.grow_from.empty()) {
+      GraphMetadata & prefix = config.prefix;
+      if (!prefix.read(GraphMetadata::path(config.grow_from))) {
+         std::cout << "Cannot read " << GraphMetadata::path(config.grow_from) << std::endl;
+         return -1;
+      }
 
-   // Merge all these streams
-   using merger_type = StreamMerger<Token64, Token64::ComparatorAsc, typename decltype(model)::sorter_type, decltype(seedTokens)>;
-   Token64::ComparatorAsc compare;
-   merger_type merger(compare, model.sorter(), seedTokens);
+      if (!graph_metadata(config).compatible(prefix, std::cout))
+         return -1;
 
-   // Setup priority queue
-   // we need an desc comparator, since its a max-pq and we want the smallest element on top
-   using pq_type = stxxl::PRIORITY_QUEUE_GENERATOR<Token64, Token64::ComparatorDesc, pq_size, size_t(1) << 20>::result;
-   //using pq_type = stxxl::priority_queue<stxxl::priority_queue_config<Token<unsigned long>, Token<unsigned long>::ComparatorDesc, 32u, 8192u, 64u, 2u, 4194304u, 64u, 2u, stxxl::RC>>;
-   pq_type prio_queue(pq_size / 2, pq_size / 2);
+      if (filter || config.output_format != EdgeWriter::Binary) {
+         std::cout << "grow-from requires binary output without filters" << std::endl;
+         return -1;
+      }
 
-   // Process streams
-   ProcessTokenSequence<decltype(merger), decltype(prio_queue)> process(merger, prio_queue);
+      if (prefix.storedPositions() != prefix.positions) {
+         std::cout << "The parts of the graph grown from hold " << prefix.storedPositions()
+                   << " instead of " << prefix.positions << " positions" << std::endl;
+         return -1;
+      }
 
-   // Write graph into file
-   EdgeWriter edge_writer(output_file, seedTokens.numberOfEdges() + number_of_edges);
+      config.prefix_edges = prefix.positions / 2 - InitialCircle(config.number_of_seed_vertices).numberOfEdges();
+      if (config.number_of_edges <= config.prefix_edges) {
+         std::cout << "no-edges > " << config.prefix_edges << " to grow a graph of "
+                   << config.prefix_edges << " random edges" << std::endl;
+         return -1;
+      }
 
-   if (filter_self_loops || filter_multi_edges) {
-      EdgeSorter<decltype(process)> sortedEdges(process, sorter_size);
-      EdgeFilter<decltype(sortedEdges)> filteredEdges(sortedEdges, filter_self_loops, filter_multi_edges);
-      edge_writer.writeEdges(filteredEdges);
-   } else {
-      edge_writer.writeVertices(process);
+      std::cout << "Growing graph of " << config.prefix_edges << " random edges stored in "
+                << prefix.parts.size() << " part(s)" << std::endl;
    }
 
-   std::cout << "Wrote " << edge_writer.edgesWritten() << " edges" << std::endl;
+   MemoryPool pool(config.memory);
+
+   uint64_t number_of_vertices;
+   if (config.compress_runs)
+      number_of_vertices = generate_and_process<CompressedTokenSorter<Token64>, CompressedTokenBucket<Token64>>(config, pool);
+   else
+      number_of_vertices = generate_and_process<stxxl::sorter<Token64, Token64::ComparatorAsc>, ExternalTokenBucket<Token64>>(config, pool);
+
+   std::cout << "Peak memory leased: " << (pool.peak() >> 20) << " MiB of " << (pool.total() >> 20) << " MiB" << std::endl;
+
+   // Allow to grow the graph later
+   if (!filter && config.output_format == EdgeWriter::Binary && config.output_file != "-") {
+      GraphMetadata meta = graph_metadata(config);
+      meta.vertices = number_of_vertices;
+      meta.parts.push_back(config.output_file);
+
+      if (!meta.write(GraphMetadata::path(config.output_file)))
+         std::cout << "Cannot write " << GraphMetadata::path(config.output_file) << std::endl;
+   }
 
    return 0;
 }
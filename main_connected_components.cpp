@@ -0,0 +1,196 @@
+/**
+ * @file
+ * @brief Connected components of (possibly huge) edge lists
+ *
+ * Uses a union-find over an in-memory parent array if the vertex ids fit into
+ * the memory budget (one pass over the input) and falls back to min-label
+ * propagation in external memory otherwise.
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stxxl/cmdline>
+#include <stxxl/io>
+#include <stxxl/vector>
+#include <stxxl/sorter>
+#include <stxxl/bits/common/uint_types.h>
+
+#include <FileDataType.hpp>
+#include <EdgeListReader.hpp>
+#include <ConnectedComponents.hpp>
+
+using FileT = DefaultFileDataType::data_type;
+
+struct Config {
+   std::vector<std::string> filenames;
+   std::string filename_out;
+
+   uint64_t number_of_vertices = 0;
+   uint64_t memory = 1llu << 32;
+   bool external = false;
+   bool io_uring = false;
+};
+
+//! Thrown if the parent array exceeds the memory budget
+struct ExceedsMemoryBudget {};
+
+/**
+ * Union-find in one pass over all files; returns false (without statistics)
+ * if the parent array does not fit into the memory budget.
+ */
+template <typename IndexT>
+bool semi_external(const Config & config, ComponentStatistics & stats, uint64_t & edges) {
+   const uint64_t max_vertices = std::min<uint64_t>(UnionFind<IndexT>::maxVertices(), config.memory / sizeof(IndexT));
+   if (config.number_of_vertices > max_vertices)
+      return false;
+
+   UnionFind<IndexT> union_find(config.number_of_vertices);
+   uint64_t number_of_vertices = config.number_of_vertices;
+   uint64_t merges = 0;
+
+   try {
+      for(auto & filename : config.filenames) {
+         bool first = true;
+         uint64_t u = 0;
+
+         const uint64_t vertices = readEdgeListFile(filename, [&] (const FileT & node) {
+            if (first) {
+               u = DefaultFileDataType::toInternal(node);
+               first = false;
+               return;
+            }
+            first = true;
+
+            const uint64_t v = DefaultFileDataType::toInternal(node);
+            const uint64_t required = std::max(u, v) + 1;
+            if (UNLIKELY(required > union_find.size())) {
+               if (required > max_vertices)
+                  throw ExceedsMemoryBudget();
+               union_find.grow(std::max(required, std::min(2 * union_find.size(), max_vertices)));
+            }
+            number_of_vertices = std::max(number_of_vertices, required);
+
+            merges += union_find.unite(IndexT(u), IndexT(v));
+         });
+
+         edges += vertices / 2;
+         std::cout << "Read " << (vertices / 2) << " edges from file " << filename << std::endl;
+      }
+   } catch (ExceedsMemoryBudget &) {
+      std::cout << "Vertex ids exceed the memory budget of the union-find; fall back to external memory" << std::endl;
+      edges = 0;
+      return false;
+   }
+
+   std::cout << "Union-find merged " << merges << " pairs of components" << std::endl;
+
+   union_find.flatten();
+   for(uint64_t v = 0; v < number_of_vertices; v++)
+      stats.push(union_find.label(v));
+
+   return true;
+}
+
+//! Min-label propagation in external memory
+void external(const Config & config, ComponentStatistics & stats, uint64_t & edges) {
+   ExternalConnectedComponents components(config.memory / 4);
+   components.setMinNumberOfVertices(config.number_of_vertices);
+
+   for(auto & filename : config.filenames) {
+      bool first = true;
+      uint64_t u = 0;
+
+      const uint64_t vertices = readEdgeListFile(filename, [&] (const FileT & node) {
+         if (first) {
+            u = DefaultFileDataType::toInternal(node);
+         } else {
+            components(u, DefaultFileDataType::toInternal(node));
+         }
+         first = !first;
+      });
+
+      edges += vertices / 2;
+      std::cout << "Read " << (vertices / 2) << " edges from file " << filename << std::endl;
+   }
+
+   const unsigned int rounds = components.compute();
+   std::cout << "Label propagation converged after " << rounds << " rounds" << std::endl;
+
+   for(auto label : ExternalConnectedComponents::vector_type::bufreader_type(components.labels()))
+      stats.push(label);
+}
+
+int main(int argc, char* argv[]) {
+   Config config;
+   {
+      stxxl::cmdline_parser cp;
+      cp.set_author("Manuel Penschuck <manuel at ae.cs.uni-frankfurt.de>");
+      cp.set_description("Connected components of edge lists (direction of edges is ignored)");
+      cp.add_param_stringlist("input-files", config.filenames, "Input files; if multiple files are given they are interpreted as concatenated");
+
+      stxxl::uint64 vertices = 0, memory = config.memory;
+      cp.add_bytes('n', "no-vertices", vertices, "Number of vertices; includes isolated vertices with large ids; optional");
+      cp.add_bytes('M', "memory", memory, "Memory budget for the in-memory union-find; default 4Gi");
+      cp.add_flag('e', "external", config.external, "Always use external-memory label propagation");
+      cp.add_flag('u', "io-uring", config.io_uring, "Read input through io_uring instead of linuxaio (falls back if unavailable)");
+      cp.add_string('o', "output-file", config.filename_out, "Write lines \"size count\" of component sizes to this file");
+      if (!cp.process(argc, argv)) return -1;
+
+      config.number_of_vertices = vertices;
+      config.memory = memory;
+   }
+
+   std::cout << "Using " << (8 * sizeof(FileT)) << "-bit unsinged integers for input" << std::endl;
+   IOBackend::select(config.io_uring ? IOBackend::Uring : IOBackend::LinuxAIO);
+
+   stxxl::stats* Stats = stxxl::stats::get_instance();
+   stxxl::stats_data stats_begin(*Stats);
+
+   ComponentStatistics stats;
+   uint64_t edges = 0;
+
+   bool done = false;
+   if (!config.external) {
+      // 32 bit parents halve the memory if the ids are known to fit
+      if (config.number_of_vertices && config.number_of_vertices <= UnionFind<uint32_t>::maxVertices())
+         done = semi_external<uint32_t>(config, stats, edges);
+      else
+         done = semi_external<uint64_t>(config, stats, edges);
+   }
+
+   if (!done)
+      external(config, stats, edges);
+
+   std::ofstream histogram;
+   if (!config.filename_out.empty())
+      histogram.open(config.filename_out);
+
+   stats.finish(histogram.is_open() ? &histogram : nullptr);
+
+   std::cout << "# Number of vertices: " << stats.number_of_vertices << std::endl;
+   std::cout << "# Number of edges: " << edges << std::endl;
+   std::cout << "Number of components found: " << stats.number_of_components << std::endl;
+   std::cout << "Largest component: " << stats.largest_component << " vertices" << std::endl;
+   std::cout << "Graph is " << (stats.number_of_components == 1 ? "" : "NOT ") << "connected" << std::endl;
+
+   stxxl::stats_data stats_final(*Stats);
+   std::cout << "Final: " << (stats_final - stats_begin);
+
+   return 0;
+}
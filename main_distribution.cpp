@@ -11,11 +11,14 @@
 #include <GenericComparator.hpp>
 #include <DistributionCount.hpp>
 #include <FileDataType.hpp>
+#include <EdgeListReader.hpp>
+#include <DegreeSequence.hpp>
+#include <PowerLawFit.hpp>
 
 using FileT = DefaultFileDataType::data_type;
 using sorter_type = stxxl::sorter<FileT, GenericComparator<FileT>::Ascending>;
 
-void count_and_display_degree(sorter_type & sorter, std::ostream * outstream) {
+void count_and_display_degree(sorter_type & sorter, std::ostream * outstream, PowerLawFit & fit) {
    sorter.sort();
 
 // Count degrees
@@ -44,13 +47,39 @@ void count_and_display_degree(sorter_type & sorter, std::ostream * outstream) {
 
       (*outstream) << desc.value << " " << desc.count << std::endl;
       degree_sum += desc.value * desc.count;
+      fit.push(desc.value, desc.count);
    }
 }
 
+//! Fit the power law and write the CCDF and log-binned distribution if requested
+void report_distribution(const PowerLawFit & fit, const std::string & label, uint64_t min_tail,
+                         std::ostream * ccdf_stream, std::ostream * log_binned_stream)
+{
+   const PowerLawFit::Result result = fit.fit(min_tail);
+   if (result.valid) {
+      std::cout << "# Power-law fit" << label << ": alpha=" << result.alpha << " x_min=" << result.x_min
+                << " KS-distance=" << result.ks_distance << " tail=" << result.tail_size
+                << " of " << fit.totalCount() << " vertices" << std::endl;
+   } else {
+      std::cout << "# Power-law fit" << label << ": less than " << min_tail << " samples" << std::endl;
+   }
+
+   if (ccdf_stream)
+      fit.writeCCDF(*ccdf_stream);
+
+   if (log_binned_stream)
+      fit.writeLogBinned(*log_binned_stream);
+}
+
 int main(int argc, char* argv[]) {
    bool directed_graph = false;
+   bool io_uring = false;
    std::vector<std::string> filenames;
    std::string filename_out;
+   std::string filename_degrees;
+   std::string filename_ccdf;
+   std::string filename_log_binned;
+   stxxl::uint64 min_tail = 50;
    {
       stxxl::cmdline_parser cp;
       cp.set_author("Manuel Penschuck <manuel at ae.cs.uni-frankfurt.de>");
@@ -58,10 +87,16 @@ int main(int argc, char* argv[]) {
       cp.add_flag('d', "directed", directed_graph, "Input is a directed edge list; default false");
       cp.add_param_stringlist("input-files", filenames, "Input files; if mutliple files are given they are interpreted as concatenated");
       cp.add_string('o', "output-file", filename_out, "Name of the output file");
+      cp.add_string('D', "degree-file", filename_degrees, "Additionally write the degree (out- and in-degree if directed) of every vertex as dense array");
+      cp.add_string('c', "ccdf-file", filename_ccdf, "Write lines \"degree P(X >= degree)\" to this file");
+      cp.add_string('l', "log-binned-file", filename_log_binned, "Write lines \"lower upper center density\" of logarithmic bins to this file");
+      cp.add_bytes('t', "min-tail", min_tail, "Minimal number of vertices with degree >= x_min in power-law fit; default 50");
+      cp.add_flag('u', "io-uring", io_uring, "Read input through io_uring instead of linuxaio (falls back if unavailable)");
       if (!cp.process(argc, argv)) return -1;
    }
 
    std::cout << "Using " << (8 * sizeof(DefaultFileDataType::data_type)) << "-bit unsinged integers for input" << std::endl;
+   IOBackend::select(io_uring ? IOBackend::Uring : IOBackend::LinuxAIO);
 
    stxxl::stats* Stats = stxxl::stats::get_instance();
    stxxl::stats_data stats_begin(*Stats);     
@@ -73,28 +108,36 @@ int main(int argc, char* argv[]) {
 
    // Input handling
    for(auto & filename : filenames) {
-      // Open File as a STXXL vector
-      stxxl::linuxaio_file input_file(filename, stxxl::file::RDONLY | stxxl::file::DIRECT);
-      DefaultFileDataType::vector_type input_vector(&input_file);
-
       // Copy file into sorter(s)
       bool out_edge = true;
-      for(auto node : typename DefaultFileDataType::vector_type::bufreader_type(input_vector)) {
+      const uint64_t vertices = readEdgeListFile(filename, [&] (const FileT & node) {
          if (out_edge || !directed_graph) {
             node_out_sorter.push(node);
          } else {
             node_in_sorter.push(node);
          }
          out_edge = !out_edge;
-      }
+      });
 
       // Print progress info
-      auto this_edges = input_vector.size() / 2;
+      auto this_edges = vertices / 2;
       edges += this_edges;
       std::cout << "Read " << this_edges << " edges from file " << filename << std::endl;
    }
    std::cout << "# Number of edges: " << edges << std::endl;
 
+   if (!filename_degrees.empty()) {
+      node_out_sorter.sort();
+      if (directed_graph)
+         node_in_sorter.sort();
+
+      const DegreeSequence::Summary summary = DegreeSequence::writeSorted(
+         filename_degrees, node_out_sorter, directed_graph ? &node_in_sorter : nullptr);
+
+      std::cout << "Wrote degrees of " << summary.number_of_vertices << " vertices with "
+                << summary.bytes_per_degree << " bytes per degree to " << filename_degrees << std::endl;
+   }
+
    std::ofstream result_file;
    if (!filename_out.empty())
       result_file.open(filename_out);
@@ -103,14 +146,37 @@ int main(int argc, char* argv[]) {
    if (result_file.is_open())
       result_stream = &result_file;
 
+   std::ofstream ccdf_file;
+   if (!filename_ccdf.empty())
+      ccdf_file.open(filename_ccdf);
+   std::ostream* ccdf_stream = ccdf_file.is_open() ? &ccdf_file : nullptr;
+
+   std::ofstream log_binned_file;
+   if (!filename_log_binned.empty())
+      log_binned_file.open(filename_log_binned);
+   std::ostream* log_binned_stream = log_binned_file.is_open() ? &log_binned_file : nullptr;
+
    if (!directed_graph) {
-      count_and_display_degree(node_out_sorter, result_stream);
+      PowerLawFit fit;
+      count_and_display_degree(node_out_sorter, result_stream, fit);
+      report_distribution(fit, "", min_tail, ccdf_stream, log_binned_stream);
    } else {
-      (*result_stream) << "# Out-Degrees" << std::endl;
-      count_and_display_degree(node_out_sorter, result_stream);
+      // sections are separated as in the result file (gnuplot's index)
+      std::vector<std::ostream*> streams = {result_stream, ccdf_stream, log_binned_stream};
+
+      for(auto stream : streams)
+         if (stream) (*stream) << "# Out-Degrees" << std::endl;
+
+      PowerLawFit out_fit;
+      count_and_display_degree(node_out_sorter, result_stream, out_fit);
+      report_distribution(out_fit, " (out-degrees)", min_tail, ccdf_stream, log_binned_stream);
+
+      for(auto stream : streams)
+         if (stream) (*stream) << std::endl << std::endl << "# In-Degrees" << std::endl;
 
-      (*result_stream) << std::endl << std::endl << "# In-Degrees" << std::endl;
-      count_and_display_degree(node_in_sorter,  result_stream);
+      PowerLawFit in_fit;
+      count_and_display_degree(node_in_sorter,  result_stream, in_fit);
+      report_distribution(in_fit, " (in-degrees)", min_tail, ccdf_stream, log_binned_stream);
    }
 
 // Output report   
@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @brief Triangle count and clustering coefficients of (possibly huge) edge lists
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stxxl/cmdline>
+#include <stxxl/io>
+#include <stxxl/vector>
+#include <stxxl/sorter>
+#include <stxxl/bits/common/uint_types.h>
+
+#include <FileDataType.hpp>
+#include <EdgeListReader.hpp>
+#include <TriangleCount.hpp>
+
+using FileT = DefaultFileDataType::data_type;
+
+int main(int argc, char* argv[]) {
+   std::vector<std::string> filenames;
+   std::string filename_out;
+   stxxl::uint64 memory = 1llu << 32;
+   bool io_uring = false;
+   {
+      stxxl::cmdline_parser cp;
+      cp.set_author("Manuel Penschuck <manuel at ae.cs.uni-frankfurt.de>");
+      cp.set_description("Triangle count, global and average local clustering of edge lists (direction of edges is ignored)");
+      cp.add_param_stringlist("input-files", filenames, "Input files; if multiple files are given they are interpreted as concatenated");
+      cp.add_bytes('M', "memory", memory, "Internal memory shared by the sorters; default 4Gi");
+      cp.add_flag('u', "io-uring", io_uring, "Read input through io_uring instead of linuxaio (falls back if unavailable)");
+      cp.add_string('o', "output-file", filename_out, "Write lines \"degree vertices average-local-clustering\" to this file");
+      if (!cp.process(argc, argv)) return -1;
+   }
+
+   std::cout << "Using " << (8 * sizeof(FileT)) << "-bit unsinged integers for input" << std::endl;
+   IOBackend::select(io_uring ? IOBackend::Uring : IOBackend::LinuxAIO);
+
+   stxxl::stats* Stats = stxxl::stats::get_instance();
+   stxxl::stats_data stats_begin(*Stats);
+
+   // at most three sorters are alive at the same time
+   ExternalTriangleCount triangles(memory / 3);
+   uint64_t edges = 0;
+
+   for(auto & filename : filenames) {
+      bool first = true;
+      uint64_t u = 0;
+
+      const uint64_t vertices = readEdgeListFile(filename, [&] (const FileT & node) {
+         if (first) {
+            u = DefaultFileDataType::toInternal(node);
+         } else {
+            triangles(u, DefaultFileDataType::toInternal(node));
+         }
+         first = !first;
+      });
+
+      edges += vertices / 2;
+      std::cout << "Read " << (vertices / 2) << " edges from file " << filename << std::endl;
+   }
+
+   triangles.compute();
+
+   if (!filename_out.empty()) {
+      std::ofstream out(filename_out);
+      triangles.writeSpectrum(out);
+   }
+
+   std::cout << "# Number of edges read: " << edges << std::endl;
+   std::cout << "# Number of self-loops ignored: " << triangles.numberOfLoops() << std::endl;
+   std::cout << "# Number of duplicated edges ignored: " << triangles.numberOfDuplicates() << std::endl;
+   std::cout << "# Number of non-isolated vertices: " << triangles.numberOfVertices() << std::endl;
+   std::cout << "# Number of simple edges: " << triangles.numberOfEdges() << std::endl;
+   std::cout << "Number of triangles: " << triangles.numberOfTriangles() << std::endl;
+   std::cout << "Number of wedges: " << triangles.numberOfWedges() << std::endl;
+   std::cout << "Global clustering (transitivity): " << triangles.globalClustering() << std::endl;
+   std::cout << "Average local clustering (degree >= 2): " << triangles.averageLocalClustering() << std::endl;
+   std::cout << "Average local clustering (degree >= 1): " << triangles.averageLocalClusteringAllVertices() << std::endl;
+
+   stxxl::stats_data stats_final(*Stats);
+   std::cout << "Final: " << (stats_final - stats_begin);
+
+   return 0;
+}
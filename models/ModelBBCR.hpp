@@ -19,13 +19,22 @@
  * limitations under the License.
  */
 #pragma once
-#include <stxxl/random>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include <stxxl/sorter>
 
+#include <RandomInteger.hpp>
+
+/**
+ * @tparam Sorter  External sorter of the random tokens, e.g. stxxl::sorter or CompressedTokenSorter
+ */
+template <class Sorter = stxxl::sorter<Token64, Token64::ComparatorAsc>>
 class ModelBBCR {
 public:
    using value_type = Token64;
-   using sorter_type = stxxl::sorter<value_type, value_type::ComparatorAsc>;
+   using sorter_type = Sorter;
 
 protected:
    // generator parameters
@@ -39,29 +48,102 @@ protected:
    const double _degree_offset_in;
    const double _degree_offset_out;
 
-   // sorter and random sources
+   // mode selection by comparing a random word against thresholds scaled to 2^64
+   const uint64_t _threshold_alpha;
+   const uint64_t _threshold_alpha_beta;
+   const uint64_t _threshold_alpha_given_not_beta;
+
+   // geometric run lengths of consecutive beta edges (optional)
+   const bool _beta_runs;
+   const double _log_beta;
+   uint64_t _pending_beta_edges;
+
+   // fixed-point offsets; the uniform selection happens with probability
+   // vertices * offset / (vertices * offset + edges), evaluated on integers
+   // scaled by 2^_offset_shift
+   unsigned int _offset_shift;
+   uint64_t _offset_in_fixed;
+   uint64_t _offset_out_fixed;
+
+   // sorter and random source
    sorter_type _sorter;
-   stxxl::random_number64 _rand64;
-   stxxl::random_uniform_slow _randdbl;
+   RandomBatch _random;
 
    enum Distribution : bool {
        DistrIn, DistrOut
    };
 
+   enum Mode {
+       ModeAlpha, ModeBeta, ModeGamma
+   };
+
+   //! Threshold t with P[random word < t] = p
+   static uint64_t _threshold(double p) {
+      if (p <= 0.0) return 0;
+      if (p >= 1.0) return std::numeric_limits<uint64_t>::max();
+      return uint64_t(std::ldexp(p, 64));
+   }
+
+   //! Number of beta edges before the next alpha or gamma edge
+   uint64_t _drawBetaRun() {
+      if (_beta >= 1.0)
+         return std::numeric_limits<uint64_t>::max();
+
+      // uniform from (0, 1]
+      const double uniform = ((_random() >> 11) + 1) * (1.0 / (1llu << 53));
+      const double run = std::floor(std::log(uniform) / _log_beta);
+      return (run < 1.8e19) ? uint64_t(run) : std::numeric_limits<uint64_t>::max();
+   }
+
+   /**
+    * Largest number of fractional bits (at most 32) such that the scaled weight
+    * of all vertices and edges ever generated stays below 2^63
+    */
+   void _setupOffsets(uint64_t first_vertex_id) {
+      const double max_vertices = double(first_vertex_id) + double(_number_of_edges) + 1.0;
+      const double max_edges = double(_token_id / 2) + double(_number_of_edges) + 1.0;
+      const double max_weight = max_vertices * std::max(1.0, std::max(_degree_offset_in, _degree_offset_out)) + max_edges;
+
+      _offset_shift = 0;
+      while(_offset_shift < 32 && std::ldexp(max_weight, _offset_shift + 1) < std::ldexp(1.0, 63))
+         _offset_shift++;
+
+      _offset_in_fixed = uint64_t(std::llround(std::ldexp(_degree_offset_in, _offset_shift)));
+      _offset_out_fixed = uint64_t(std::llround(std::ldexp(_degree_offset_out, _offset_shift)));
+   }
+
+   Mode _drawMode() {
+      if (_beta_runs) {
+         if (_pending_beta_edges) {
+            _pending_beta_edges--;
+            return ModeBeta;
+         }
+
+         _pending_beta_edges = _drawBetaRun();
+         return (_random() < _threshold_alpha_given_not_beta) ? ModeAlpha : ModeGamma;
+      }
+
+      const uint64_t r = _random();
+      if (r < _threshold_alpha) return ModeAlpha;
+      if (r < _threshold_alpha_beta) return ModeBeta;
+      return ModeGamma;
+   }
+
    inline value_type _generate_random_token(Distribution distr) {
       value_type result;
 
-      const double offset = (distr == DistrOut)
-                              ? _degree_offset_out
-                              : _degree_offset_in;
+      const uint64_t offset = (distr == DistrOut)
+                              ? _offset_out_fixed
+                              : _offset_in_fixed;
 
-      if (offset > 0 && _randdbl() < ((_vertex_id*offset) / (_vertex_id*offset + _token_id/2))) {
+      const uint64_t vertex_weight = _vertex_id * offset;
+      if (offset > 0 && _random(vertex_weight + ((_token_id / 2) << _offset_shift)) < vertex_weight) {
          // uniform selection
-         result = value_type(false, _token_id, _rand64(_vertex_id + 1));
+         result = value_type(false, _token_id, _random(_vertex_id + 1));
 
       } else {
          // pa selection
-         uint64_t rand_token = _rand64(_token_id & ~1llu);
+         uint64_t rand_token = _random(_token_id & ~1llu);
 
          if (distr == DistrOut)
             // sample from even positions
@@ -80,18 +162,18 @@ protected:
    void _populate() {
       const uint64_t max_token_id = _token_id + 2*_number_of_edges;
       while(_token_id < max_token_id) {
-         double mode = _randdbl();
+         const Mode mode = _drawMode();
 
          // an edge should always start at an even position
          assert(!(_token_id & 1));
 
-         if (mode < _alpha) {
+         if (mode == ModeAlpha) {
             // construct new vertex with out-going edge
             _sorter.push(value_type(false, _token_id++, _vertex_id));
             _sorter.push(_generate_random_token(DistrIn));
             _vertex_id++;
 
-         } else if (mode < _alpha + _beta) {
+         } else if (mode == ModeBeta) {
             // link to random nodes
             _sorter.push(_generate_random_token(DistrOut));
             _sorter.push(_generate_random_token(DistrIn));
@@ -106,18 +188,37 @@ protected:
    }
 
 public:
+   /**
+    * @param alpha, beta  Probabilities of the alpha and beta modes (gamma = 1 - alpha - beta)
+    * @param beta_runs    Draw the number of consecutive beta edges from a geometric distribution
+    *                     instead of one mode per edge; saves a random word per beta edge at
+    *                     the cost of a logarithm per run, so it is only useful for beta near 1
+    * @param merge_memory Bytes used by the sorter to merge its runs; 0 uses sorter_size
+    */
    ModelBBCR(
          uint64_t number_of_edges, uint64_t first_vertex_id, uint64_t first_edge_id,
          double alpha, double beta,
          double degree_offset_in, double degree_offset_out,
-         stxxl::unsigned_type sorter_size
+         stxxl::unsigned_type sorter_size,
+         bool beta_runs = false,
+         stxxl::unsigned_type merge_memory = 0
    )
          : _number_of_edges(number_of_edges)
          , _vertex_id(first_vertex_id), _token_id(2*first_edge_id)
          , _alpha(alpha), _beta(beta)
          , _degree_offset_in(degree_offset_in), _degree_offset_out(degree_offset_out)
-         , _sorter(value_type::ComparatorAsc(), sorter_size)
+         , _threshold_alpha(_threshold(alpha))
+         , _threshold_alpha_beta(_threshold(alpha + beta))
+         , _threshold_alpha_given_not_beta(_threshold(beta < 1.0 ? alpha / (1.0 - beta) : 1.0))
+         , _beta_runs(beta_runs)
+         , _log_beta(std::log(beta))
+         , _pending_beta_edges(0)
+         , _sorter(value_type::ComparatorAsc(), sorter_size, merge_memory ? merge_memory : sorter_size)
    {
+      _setupOffsets(first_vertex_id);
+      if (_beta_runs)
+         _pending_beta_edges = _drawBetaRun();
+
       _populate();
       _sorter.sort();
    }
@@ -125,4 +226,9 @@ public:
    sorter_type & sorter() {
       return _sorter;
    }
+
+   //! Vertex ids of the graph generated (including the ones before first_vertex_id) are in [0, numberOfVertices())
+   uint64_t numberOfVertices() const {
+      return _vertex_id;
+   }
 };
@@ -0,0 +1,176 @@
+/**
+ * @file
+ * @brief Implementation of the generator library interface
+ *
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <TFPGenerator.hpp>
+
+#include <stdexcept>
+
+#include <stxxl/sorter>
+#include <stxxl/bits/containers/priority_queue.h>
+
+#include <Token.hpp>
+#include <BAEdgeListLayout.hpp>
+#include <InitialCircle.hpp>
+#include <RandomInteger.hpp>
+#include <StreamMerger.hpp>
+#include <ProcessTokenSequence.hpp>
+#include <ProcessImplicitTokenSequence.hpp>
+#include <EdgeSorter.hpp>
+#include <EdgeFilter.hpp>
+
+#include "models/ModelBBCR.hpp"
+
+namespace {
+
+constexpr size_t pq_size = 1 << 30;
+
+// we need an desc comparator, since its a max-pq and we want the smallest element on top
+using pq_type = stxxl::PRIORITY_QUEUE_GENERATOR<Token64, Token64::ComparatorDesc, pq_size, size_t(1) << 30>::result;
+using sorter_type = stxxl::sorter<Token64, Token64::ComparatorAsc>;
+
+/**
+ * @brief Adapts a TFP process to the EdgeSource interface
+ *
+ * If filters are requested, the process is drained into an EdgeSorter upon
+ * start and the filtered edges are served from it.
+ */
+template <class Process>
+class ProcessEdgeSource : public EdgeSource {
+protected:
+   using sorted_type = EdgeSorter<Process>;
+   using filtered_type = EdgeFilter<sorted_type>;
+
+   std::unique_ptr<Process> _process;
+   std::unique_ptr<sorted_type> _sorted;
+   std::unique_ptr<filtered_type> _filtered;
+
+   void _start(Process* process, bool filter_self_loops, bool filter_multi_edges, uint64_t sorter_memory) {
+      _process.reset(process);
+
+      if (filter_self_loops || filter_multi_edges) {
+         _sorted.reset(new sorted_type(*_process, sorter_memory));
+         _filtered.reset(new filtered_type(*_sorted, filter_self_loops, filter_multi_edges));
+      }
+   }
+
+   size_t _pull(edge_type* edges, size_t max_edges) override {
+      size_t n = 0;
+
+      if (_filtered) {
+         for(; n < max_edges && !_filtered->empty(); ++(*_filtered))
+            edges[n++] = **_filtered;
+
+      } else {
+         Process & process = *_process;
+         for(; n < max_edges && !process.empty(); n++) {
+            edges[n].first = *process;
+            ++process;
+            assert(!process.empty());
+            edges[n].second = *process;
+            ++process;
+         }
+      }
+
+      return n;
+   }
+};
+
+//! Same pipeline as tfp_ba (without partitioning)
+class BAEdgeSource : public ProcessEdgeSource<ProcessImplicitTokenSequence<sorter_type, pq_type>> {
+   using process_type = ProcessImplicitTokenSequence<sorter_type, pq_type>;
+
+   const BAEdgeListLayout _layout;
+   sorter_type _tokens;
+   pq_type _prio_queue;
+
+public:
+   explicit BAEdgeSource(const BAParameters & params)
+      : _layout(2 * params.edges_per_vertex, params.edges_per_vertex)
+      , _tokens(Token64::ComparatorAsc(), params.sorter_memory)
+      , _prio_queue(pq_size / 2, pq_size / 2)
+   {
+      RandomBatch & random = RandomInteger<8>::generator();
+      std::vector<uint64_t> random_positions(params.edges_per_vertex);
+
+      uint64_t weight = _layout.firstRandomIdx();
+      uint64_t idx = weight + 1;
+      for(uint64_t vertex = 0; vertex < params.number_of_vertices; vertex++) {
+         random.fillBounded(random_positions.data(), params.edges_per_vertex, weight, 2 * params.edge_dependencies);
+         for(uint64_t edge = 0; edge < params.edges_per_vertex; edge++) {
+            _tokens.push(Token64(true, random_positions[edge], idx));
+            idx += 2;
+         }
+
+         weight += 2 * params.edges_per_vertex;
+      }
+
+      _tokens.sort();
+
+      _start(new process_type(_tokens, _prio_queue, _layout, 0,
+                              _layout.firstIdxOfRandomVertex(params.number_of_vertices), params.window_size),
+             params.filter_self_loops, params.filter_multi_edges, params.sorter_memory);
+   }
+};
+
+using bbcr_merger_type = StreamMerger<Token64, Token64::ComparatorAsc, ModelBBCR<>::sorter_type, InitialCircle>;
+
+//! Same pipeline as tfp_bbcr
+class BBCREdgeSource : public ProcessEdgeSource<ProcessTokenSequence<bbcr_merger_type, pq_type>> {
+   using process_type = ProcessTokenSequence<bbcr_merger_type, pq_type>;
+
+   InitialCircle _seed_tokens;
+   ModelBBCR<> _model;
+   Token64::ComparatorAsc _compare;
+   bbcr_merger_type _merger;
+   pq_type _prio_queue;
+
+public:
+   BBCREdgeSource(const BBCRParameters & params, double alpha, double beta)
+      : _seed_tokens(params.number_of_seed_vertices)
+      , _model(params.number_of_edges, _seed_tokens.maxVertexId() + 1, _seed_tokens.numberOfEdges(),
+               alpha, beta, params.degree_offset_in, params.degree_offset_out, params.sorter_memory)
+      , _merger(_compare, _model.sorter(), _seed_tokens)
+      , _prio_queue(pq_size / 2, pq_size / 2)
+   {
+      _start(new process_type(_merger, _prio_queue, 0, params.window_size),
+             params.filter_self_loops, params.filter_multi_edges, params.sorter_memory);
+   }
+};
+
+}
+
+std::unique_ptr<EdgeSource> EdgeSource::createBA(const BAParameters & params) {
+   if (!params.number_of_vertices || !params.edges_per_vertex)
+      throw std::invalid_argument("BA: number_of_vertices and edges_per_vertex have to be positive");
+
+   return std::unique_ptr<EdgeSource>(new BAEdgeSource(params));
+}
+
+std::unique_ptr<EdgeSource> EdgeSource::createBBCR(const BBCRParameters & params) {
+   const double norm = params.alpha + params.beta + params.gamma;
+   if (params.alpha < 0 || params.beta < 0 || params.gamma < 0 || norm < 1e-9)
+      throw std::invalid_argument("BBCR: alpha, beta, gamma >= 0");
+
+   if (params.degree_offset_in < 0 || params.degree_offset_out < 0)
+      throw std::invalid_argument("BBCR: d-in, d-out >= 0");
+
+   if (!params.number_of_edges || params.number_of_seed_vertices < 2)
+      throw std::invalid_argument("BBCR: no-edges > 0; seed_verts > 1");
+
+   return std::unique_ptr<EdgeSource>(new BBCREdgeSource(params, params.alpha / norm, params.beta / norm));
+}
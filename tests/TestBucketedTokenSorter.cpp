@@ -0,0 +1,132 @@
+/**
+ * @file
+ * @brief Tests for BucketedTokenSorter
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <stxxl/sorter>
+
+#include <RandomInteger.hpp>
+#include <CompressedTokenSorter.hpp>
+#include <BucketedTokenSorter.hpp>
+
+class TestBucketedTokenSorter : public ::testing::Test {
+protected:
+   //! Push n tokens with ids in [first_id, first_id + range) and compare the output with std::sort
+   template <class Sorter>
+   void _compareToReference(Sorter & sorter, uint64_t n, uint64_t first_id, uint64_t range) {
+      std::vector<Token64> reference;
+      for(uint64_t i = 0; i < n; i++) {
+         Token64 token(RandomInteger<8>::randint(2), first_id + RandomInteger<8>::randint(range), i);
+         reference.push_back(token);
+         sorter.push(token);
+      }
+
+      std::sort(reference.begin(), reference.end());
+      sorter.sort();
+
+      ASSERT_EQ(sorter.size(), n);
+      for(const auto & token : reference) {
+         ASSERT_FALSE(sorter.empty());
+         ASSERT_EQ(token.query(), (*sorter).query());
+         ASSERT_EQ(token.id(), (*sorter).id());
+         ASSERT_EQ(token.value(), (*sorter).value());
+         ++sorter;
+      }
+      ASSERT_TRUE(sorter.empty());
+   }
+};
+
+TEST_F(TestBucketedTokenSorter, stxxlSorter) {
+   for(unsigned int buckets : {1, 2, 7, 64}) {
+      BucketedTokenSorter<stxxl::sorter<Token64, Token64::ComparatorAsc>>
+         sorter(Token64::ComparatorAsc(), 1 << 26, 1000, 101000, buckets);
+      _compareToReference(sorter, 20000, 1000, 100000);
+   }
+}
+
+TEST_F(TestBucketedTokenSorter, queryBoundaries) {
+   using sorter_type = BucketedTokenSorter<stxxl::sorter<Token64, Token64::ComparatorAsc>>;
+
+   // BA-like queries: position q in [1000, 100000) draws from [0, q); only ids >= 1000 are kept
+   const uint64_t first_id = 1000, end_id = 100000;
+   const unsigned int buckets = 8;
+   const auto boundaries = sorter_type::queryBoundaries(first_id, end_id, buckets, first_id, end_id);
+   ASSERT_EQ(boundaries.size(), buckets + 1u);
+   ASSERT_EQ(boundaries.front(), first_id);
+   ASSERT_EQ(boundaries.back(), end_id);
+   ASSERT_TRUE(std::is_sorted(boundaries.begin(), boundaries.end()));
+
+   sorter_type sorter(Token64::ComparatorAsc(), 1 << 26, 1 << 26, boundaries);
+   std::vector<uint64_t> counts(buckets);
+   uint64_t tokens = 0;
+   for(uint64_t q = first_id; q < end_id; q++) {
+      for(unsigned int i = 0; i < 4; i++) {
+         const uint64_t id = RandomInteger<8>::randint(q);
+         if (id < first_id) continue;
+         counts[std::upper_bound(boundaries.begin() + 1, boundaries.end() - 1, id) - boundaries.begin() - 1]++;
+         sorter.push(Token64(true, id, q));
+         tokens++;
+      }
+   }
+
+   // equal shares, whereas equally wide buckets put more than a third into the first one
+   for(auto c : counts)
+      ASSERT_NEAR(c, tokens / buckets, 0.05 * tokens / buckets);
+
+   sorter.sort();
+   uint64_t last_id = 0, read = 0;
+   for(; !sorter.empty(); ++sorter, read++) {
+      ASSERT_LE(last_id, (*sorter).id());
+      last_id = (*sorter).id();
+   }
+   ASSERT_EQ(read, tokens);
+}
+
+TEST_F(TestBucketedTokenSorter, compressedRuns) {
+   // several spilled runs per bucket, merged by the background thread
+   BucketedTokenSorter<CompressedTokenSorter<Token64, 4096>>
+      sorter(Token64::ComparatorAsc(), 1 << 16, 0, 1 << 20, 4);
+   _compareToReference(sorter, 50000, 0, 1 << 20);
+}
+
+TEST_F(TestBucketedTokenSorter, emptyBuckets) {
+   // all ids in the last of 8 buckets, then no tokens at all
+   BucketedTokenSorter<stxxl::sorter<Token64, Token64::ComparatorAsc>>
+      sorter(Token64::ComparatorAsc(), 1 << 26, 0, 8000, 8);
+   _compareToReference(sorter, 1000, 7000, 1000);
+
+   BucketedTokenSorter<stxxl::sorter<Token64, Token64::ComparatorAsc>>
+      none(Token64::ComparatorAsc(), 1 << 26, 0, 8000, 8);
+   none.sort();
+   ASSERT_TRUE(none.empty());
+}
+
+TEST_F(TestBucketedTokenSorter, abandoned) {
+   BucketedTokenSorter<stxxl::sorter<Token64, Token64::ComparatorAsc>>
+      sorter(Token64::ComparatorAsc(), 1 << 26, 0, 1 << 20, 16);
+   for(uint64_t i = 0; i < 100000; i++)
+      sorter.push(Token64(false, RandomInteger<8>::randint(1 << 20), i));
+
+   sorter.sort();
+   for(unsigned int i = 0; i < 10; i++)
+      ++sorter;
+
+   // destruction waits for the background thread
+}
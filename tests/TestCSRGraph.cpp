@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief Tests for CSRGraph and DirectionOptimizingBFS
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <RandomInteger.hpp>
+#include <CSRGraph.hpp>
+#include <ConnectedComponents.hpp>
+
+using EdgeT = CSRDegreeCounter::edge_type;
+
+TEST(TestCSRGraph, duplicates) {
+   const std::vector<EdgeT> edges = {{0, 1}, {1, 0}, {2, 1}, {0, 1}, {3, 3}};
+
+   CSRDegreeCounter degrees(false);
+   degrees(edges.data(), edges.data() + 2);
+   degrees(edges.data() + 2, edges.data() + edges.size());
+   ASSERT_EQ(degrees.numberOfVertices(), 4u);
+
+   CSRGraph<uint32_t> graph(degrees);
+   graph.fill(edges.data(), edges.data() + edges.size());
+   ASSERT_EQ(graph.finish(), 5u);
+
+   ASSERT_EQ(graph.numberOfArcs(), 5u);
+   ASSERT_EQ(graph.degree(0), 1u);
+   ASSERT_EQ(graph.degree(1), 2u);
+   ASSERT_EQ(*graph.beginNeighbors(1), 0u);
+   ASSERT_EQ(*(graph.beginNeighbors(1) + 1), 2u);
+   ASSERT_EQ(graph.degree(3), 1u);
+}
+
+TEST(TestCSRGraph, componentsMatchUnionFind) {
+   // dense core (forces bottom-up steps) plus a sparse fringe of small components
+   const uint64_t n = 20000;
+   std::vector<EdgeT> edges;
+   for(uint64_t i = 0; i < 40000; i++)
+      edges.emplace_back(RandomInteger<8>::randint(2000), RandomInteger<8>::randint(2000));
+   for(uint64_t i = 0; i < 8000; i++)
+      edges.emplace_back(RandomInteger<8>::randint(n), RandomInteger<8>::randint(n));
+
+   CSRDegreeCounter degrees(false, 16);
+   degrees(edges.data(), edges.data() + edges.size());
+   CSRGraph<uint64_t> graph(degrees);
+   graph.fill(edges.data(), edges.data() + edges.size());
+   graph.finish();
+
+   UnionFind<uint64_t> union_find(graph.numberOfVertices());
+   for(const auto & edge : edges)
+      union_find.unite(edge.first, edge.second);
+   union_find.flatten();
+
+   std::vector<uint64_t> sizes(graph.numberOfVertices());
+   for(uint64_t w = 0; w < graph.numberOfVertices(); w++)
+      sizes[union_find.label(w)]++;
+
+   // BFS from the representative visits exactly its component
+   DirectionOptimizingBFS<uint64_t> bfs(graph);
+   for(uint64_t v = 0; v < graph.numberOfVertices(); v++) {
+      if (union_find.label(v) == v)
+         ASSERT_EQ(bfs.run(v), sizes[v]);
+      else
+         ASSERT_TRUE(bfs.visited(v));
+   }
+
+   ASSERT_GT(bfs.bottomUpSteps(), 0u);
+}
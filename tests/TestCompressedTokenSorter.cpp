@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @brief Tests for CompressedTokenRun and CompressedTokenSorter
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <RandomInteger.hpp>
+#include <CompressedTokenSorter.hpp>
+
+class TestCompressedTokenSorter : public ::testing::Test {
+protected:
+   static void _assertTokenEq(const Token64 & expected, const Token64 & token) {
+      ASSERT_EQ(expected.query(), token.query());
+      ASSERT_EQ(expected.id(), token.id());
+      ASSERT_EQ(expected.value(), token.value());
+   }
+
+   template <class Sorter>
+   void _compareToReference(Sorter & sorter, uint64_t n, uint64_t max_id);
+};
+
+template <class Sorter>
+void TestCompressedTokenSorter::_compareToReference(Sorter & sorter, uint64_t n, uint64_t max_id) {
+   std::vector<Token64> reference;
+   for(uint64_t i = 0; i < n; i++) {
+      Token64 token(RandomInteger<8>::randint(2), RandomInteger<8>::randint(max_id), i);
+      reference.push_back(token);
+      sorter.push(token);
+   }
+
+   std::sort(reference.begin(), reference.end());
+   sorter.sort();
+
+   ASSERT_EQ(sorter.size(), n);
+   for(const auto & token : reference) {
+      ASSERT_FALSE(sorter.empty());
+      _assertTokenEq(token, *sorter);
+      ++sorter;
+   }
+   ASSERT_TRUE(sorter.empty());
+}
+
+TEST_F(TestCompressedTokenSorter, runRoundtrip) {
+   std::vector<Token64> tokens;
+   for(uint64_t i = 0; i < 10000; i++)
+      tokens.emplace_back(i & 1, RandomInteger<8>::randint(uint64_t(1) << 40), RandomInteger<8>::randint(uint64_t(1) << 60));
+   std::sort(tokens.begin(), tokens.end());
+
+   // two chunks; the second one restarts the delta coding
+   CompressedTokenRun<Token64, 4096> run;
+   run.append(tokens.begin(), tokens.begin() + 6000);
+   run.append(tokens.begin() + 3000, tokens.end());
+   ASSERT_EQ(run.size(), 13000u);
+
+   CompressedTokenRun<Token64, 4096>::Reader reader(run);
+   for(uint64_t i = 0; i < 13000; i++) {
+      ASSERT_FALSE(reader.empty());
+      _assertTokenEq(tokens[i < 6000 ? i : i - 3000], *reader);
+      ++reader;
+   }
+   ASSERT_TRUE(reader.empty());
+}
+
+TEST_F(TestCompressedTokenSorter, internal) {
+   CompressedTokenSorter<Token64, 4096> sorter(Token64::ComparatorAsc(), 1 << 20);
+   _compareToReference(sorter, 10000, 1 << 20);
+   ASSERT_EQ(sorter.bytesSpilled(), 0u);
+}
+
+TEST_F(TestCompressedTokenSorter, multiPassMerge) {
+   // 16 KiB of memory: runs of 1024 tokens and a fan-in of 2
+   CompressedTokenSorter<Token64, 4096> sorter(Token64::ComparatorAsc(), 1 << 14);
+   _compareToReference(sorter, 50000, 1 << 20);
+
+   // sorted keys compress well below 16 bytes per token
+   ASSERT_GT(sorter.bytesSpilled(), 0u);
+   ASSERT_LT(sorter.bytesSpilled(), 50000u * sizeof(Token64) / 2);
+}
+
+TEST_F(TestCompressedTokenSorter, separateMergeMemory) {
+   // long runs of 4096 tokens, but a fan-in of 2 when merging
+   CompressedTokenSorter<Token64, 4096> sorter(Token64::ComparatorAsc(), 1 << 16, 1 << 14);
+   _compareToReference(sorter, 50000, 1 << 20);
+   ASSERT_GT(sorter.bytesSpilled(), 0u);
+}
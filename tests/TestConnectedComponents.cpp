@@ -0,0 +1,100 @@
+/**
+ * @file
+ * @brief Tests for UnionFind, ExternalConnectedComponents and ComponentStatistics
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <RandomInteger.hpp>
+#include <ConnectedComponents.hpp>
+
+class TestConnectedComponents : public ::testing::Test {
+protected:
+   using edge_list = std::vector<std::pair<uint64_t, uint64_t>>;
+
+   // sparse random graph with many components, isolated vertices and self-loops
+   edge_list _randomEdges(uint64_t n, uint64_t m) {
+      edge_list edges;
+      for(uint64_t i = 0; i < m; i++)
+         edges.emplace_back(RandomInteger<8>::randint(n), RandomInteger<8>::randint(n));
+      return edges;
+   }
+};
+
+TEST_F(TestConnectedComponents, unionFindVsExternal) {
+   const uint64_t n = 5000;
+   const edge_list edges = _randomEdges(n, 2000);
+
+   UnionFind<uint32_t> union_find(n);
+   ExternalConnectedComponents external(1 << 24);
+   external.setMinNumberOfVertices(n);
+
+   for(const auto & edge : edges) {
+      union_find.unite(uint32_t(edge.first), uint32_t(edge.second));
+      external(edge.first, edge.second);
+   }
+
+   union_find.flatten();
+   external.compute();
+
+   const auto & labels = external.labels();
+   ASSERT_EQ(labels.size(), n);
+
+   uint64_t components = 0;
+   for(uint64_t v = 0; v < n; v++) {
+      ASSERT_EQ(labels[v], union_find.label(v));
+      ASSERT_LE(labels[v], v);
+      components += (labels[v] == v);
+   }
+
+   // every edge lies within a component
+   for(const auto & edge : edges)
+      ASSERT_EQ(union_find.label(edge.first), union_find.label(edge.second));
+
+   ComponentStatistics stats(1 << 24);
+   for(uint64_t v = 0; v < n; v++)
+      stats.push(union_find.label(v));
+   stats.finish();
+
+   ASSERT_EQ(stats.number_of_vertices, n);
+   ASSERT_EQ(stats.number_of_components, components);
+}
+
+TEST_F(TestConnectedComponents, path) {
+   // a path has the largest number of propagation rounds
+   const uint64_t n = 100;
+   ExternalConnectedComponents external(1 << 24);
+   for(uint64_t v = n - 1; v > 0; v--)
+      external(v, v - 1);
+
+   ASSERT_EQ(external.compute(), n);
+   for(uint64_t v = 0; v < n; v++)
+      ASSERT_EQ(external.labels()[v], 0u);
+
+   ComponentStatistics stats(1 << 24);
+   for(uint64_t v = 0; v < n; v++)
+      stats.push(0);
+   stats.push(n);
+
+   std::ostringstream histogram;
+   stats.finish(&histogram);
+   ASSERT_EQ(stats.number_of_components, 2u);
+   ASSERT_EQ(stats.largest_component, n);
+   ASSERT_EQ(histogram.str(), "1 1\n100 1\n");
+}
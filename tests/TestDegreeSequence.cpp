@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @brief Tests for DegreeSequence
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <DegreeSequence.hpp>
+
+class TestDegreeSequence : public ::testing::Test {
+protected:
+   const std::string _path = "test_degree_sequence.bin";
+
+   void TearDown() override {
+      std::remove(_path.c_str());
+   }
+
+   std::vector<uint64_t> _read(unsigned int bytes) {
+      std::ifstream in(_path, std::ios::binary);
+      std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+      EXPECT_EQ(data.size() % bytes, 0u);
+
+      std::vector<uint64_t> degrees;
+      for(size_t i = 0; i + bytes <= data.size(); i += bytes) {
+         uint64_t degree = 0;
+         for(unsigned int j = 0; j < bytes; j++)
+            degree |= uint64_t(data[i + j]) << (8 * j);
+         degrees.push_back(degree);
+      }
+      return degrees;
+   }
+};
+
+TEST_F(TestDegreeSequence, undirected) {
+   DegreeSequence degrees(false, 1 << 24);
+   degrees(0, 1);
+   degrees(1, 1);
+   degrees(4, 1);
+
+   // vertices 2, 3 and 5 are isolated
+   const DegreeSequence::Summary summary = degrees.write(_path, 0, 6);
+   ASSERT_EQ(summary.number_of_vertices, 6u);
+   ASSERT_EQ(summary.max_degree, 4u);
+   ASSERT_EQ(summary.bytes_per_degree, 1u);
+
+   ASSERT_EQ(_read(1), std::vector<uint64_t>({1, 4, 0, 0, 1, 0}));
+}
+
+TEST_F(TestDegreeSequence, directedWidth) {
+   DegreeSequence degrees(true, 1 << 24);
+   for(unsigned int i = 0; i < 300; i++)
+      degrees(2, 0);
+   degrees(0, 3);
+
+   const DegreeSequence::Summary summary = degrees.write(_path);
+   ASSERT_EQ(summary.number_of_vertices, 4u);
+   ASSERT_EQ(summary.max_degree, 300u);
+   ASSERT_EQ(summary.bytes_per_degree, 2u);
+
+   // pairs of out- and in-degree
+   ASSERT_EQ(_read(2), std::vector<uint64_t>({1, 300, 0, 0, 300, 0, 0, 1}));
+}
+
+TEST_F(TestDegreeSequence, overflow) {
+   DegreeSequence degrees(false, 1 << 24);
+   for(unsigned int i = 0; i < 256; i++)
+      degrees(0, 1);
+
+   ASSERT_THROW(degrees.write(_path, 1), std::overflow_error);
+}
@@ -0,0 +1,171 @@
+/**
+ * @file
+ * @brief Tests for GraphMetadata and answerPrefixQueries
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stxxl/sorter>
+
+#include <RandomInteger.hpp>
+#include <Token.hpp>
+#include <GraphGrowth.hpp>
+
+class TestGraphGrowth : public ::testing::Test {
+protected:
+   const std::vector<std::string> _parts {"test_graph_growth.0", "test_graph_growth.1"};
+   const std::string _meta = "test_graph_growth.meta";
+
+   void TearDown() override {
+      for(const auto & part : _parts)
+         std::remove(part.c_str());
+      std::remove(_meta.c_str());
+   }
+
+   //! Store vertices [begin, end) of @p vertices as binary edge list @p filename
+   void _writePart(const std::string & filename, const std::vector<uint64_t> & vertices, size_t begin, size_t end) {
+      std::ofstream out(filename, std::ios::binary);
+      for(size_t i = begin; i < end; i++) {
+         const auto node = DefaultFileDataType::fromInternal(vertices[i]);
+         out.write(reinterpret_cast<const char*>(&node), sizeof(node));
+      }
+   }
+};
+
+TEST_F(TestGraphGrowth, metadataRoundtrip) {
+   GraphMetadata meta;
+   meta.model = "ba";
+   meta.vertices = 1000;
+   meta.positions = 7982;
+   meta.parts = _parts;
+   meta.setParameter("edges-per-vertex", 4);
+   meta.setParameter("alpha", 0.1);
+   ASSERT_TRUE(meta.write(_meta));
+
+   GraphMetadata read;
+   ASSERT_TRUE(read.read(_meta));
+   ASSERT_EQ(read.model, meta.model);
+   ASSERT_EQ(read.vertices, meta.vertices);
+   ASSERT_EQ(read.positions, meta.positions);
+   ASSERT_EQ(read.data_width, meta.data_width);
+   ASSERT_EQ(read.parts, meta.parts);
+   ASSERT_EQ(read.parameters, meta.parameters);
+
+   // doubles are stored exactly
+   ASSERT_EQ(std::stod(read.parameters["alpha"]), 0.1);
+
+   std::stringstream messages;
+   ASSERT_TRUE(meta.compatible(read, messages));
+
+   read.setParameter("edges-per-vertex", 3);
+   ASSERT_FALSE(meta.compatible(read, messages));
+   ASSERT_NE(messages.str().find("edges-per-vertex"), std::string::npos);
+
+   GraphMetadata missing;
+   ASSERT_FALSE(missing.read("test_graph_growth.missing"));
+}
+
+TEST_F(TestGraphGrowth, relativeParts) {
+   ASSERT_EQ(GraphMetadata::relativePath("a/b/c.bin", "a/d/e.meta"), "../b/c.bin");
+   ASSERT_EQ(GraphMetadata::relativePath("./a/../c.bin", "c.bin.meta"), "c.bin");
+   ASSERT_EQ(GraphMetadata::relativePath("/x/y.bin", "/x/z/../../x/w/y.meta"), "../y.bin");
+   ASSERT_EQ(GraphMetadata::resolvePath("../b/c.bin", "a/d/e.meta"), "a/d/../b/c.bin");
+   ASSERT_EQ(GraphMetadata::resolvePath("/x/y.bin", "a/d/e.meta"), "/x/y.bin");
+   ASSERT_EQ(GraphMetadata::resolvePath("c.bin", "e.meta"), "c.bin");
+
+   // a graph in a subdirectory, grown later from within it
+   const std::string dir = "test_graph_growth_dir";
+   ASSERT_EQ(mkdir(dir.c_str(), 0755), 0);
+
+   std::vector<uint64_t> vertices(100, 7);
+   _writePart(dir + "/graph.0", vertices, 0, vertices.size());
+
+   GraphMetadata meta;
+   meta.model = "ba";
+   meta.positions = vertices.size();
+   meta.parts.push_back(dir + "/graph.0");
+   ASSERT_TRUE(meta.write(dir + "/graph.meta"));
+
+   ASSERT_EQ(chdir(dir.c_str()), 0);
+   GraphMetadata read;
+   const bool success = read.read("graph.meta");
+   const uint64_t stored = read.storedPositions();
+   const std::vector<std::string> parts = read.parts;
+   std::remove("graph.0");
+   std::remove("graph.meta");
+   ASSERT_EQ(chdir(".."), 0);
+   rmdir(dir.c_str());
+
+   ASSERT_TRUE(success);
+   ASSERT_EQ(parts, std::vector<std::string>(1, "graph.0"));
+   ASSERT_EQ(stored, vertices.size());
+}
+
+TEST_F(TestGraphGrowth, answerPrefixQueries) {
+   // an edge list stored in two parts, followed by queries into it and beyond
+   const uint64_t positions = 5000;
+   std::vector<uint64_t> vertices(positions);
+   for(auto & v : vertices)
+      v = RandomInteger<8>::randint(1000);
+
+   _writePart(_parts[0], vertices, 0, 1234);
+   _writePart(_parts[1], vertices, 1234, positions);
+
+   GraphMetadata meta;
+   meta.positions = positions;
+   meta.parts = _parts;
+   ASSERT_EQ(meta.storedPositions(), positions);
+
+   stxxl::sorter<Token64, Token64::ComparatorAsc> queries(Token64::ComparatorAsc(), 1 << 26);
+   std::vector<Token64> expected;
+   for(uint64_t i = 0; i < 10000; i++) {
+      const uint64_t requester = positions + i;
+      const uint64_t target = RandomInteger<8>::randint(positions + i / 2);
+      queries.push(Token64(true, target, requester));
+      if (target < positions)
+         expected.push_back(Token64(false, requester, vertices[target]));
+   }
+   queries.sort();
+
+   stxxl::sorter<Token64, Token64::ComparatorAsc> answers(Token64::ComparatorAsc(), 1 << 26);
+   ASSERT_EQ(answerPrefixQueries(_parts, queries, answers), positions);
+
+   // all queries into the prefix are consumed, the others remain
+   uint64_t remaining = 0;
+   for(; !queries.empty(); ++queries, remaining++)
+      ASSERT_GE((*queries).id(), positions);
+   ASSERT_EQ(remaining + expected.size(), 10000u);
+
+   std::sort(expected.begin(), expected.end());
+   answers.sort();
+   ASSERT_EQ(answers.size(), expected.size());
+   for(const auto & token : expected) {
+      ASSERT_FALSE(answers.empty());
+      ASSERT_FALSE((*answers).query());
+      ASSERT_EQ(token.id(), (*answers).id());
+      ASSERT_EQ(token.value(), (*answers).value());
+      ++answers;
+   }
+}
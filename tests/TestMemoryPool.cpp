@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief Tests for MemoryPool
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <utility>
+
+#include <MemoryPool.hpp>
+
+TEST(TestMemoryPool, phases) {
+   MemoryPool pool(1000);
+
+   // phase 1: everything to the runs
+   MemoryPool::Lease runs = pool.lease(pool.available());
+   ASSERT_EQ(runs.bytes(), 1000u);
+   ASSERT_EQ(pool.available(), 0u);
+
+   // requests beyond the budget fail
+   ASSERT_THROW(pool.lease(10), std::length_error);
+   ASSERT_EQ(pool.lease(0).bytes(), 0u);
+   ASSERT_EQ(pool.leased(), 1000u);
+
+   // phase 2: runs are swapped for merge buffers, the rest goes to the queue
+   runs.release();
+   runs.release();
+   MemoryPool::Lease merge = pool.lease(100);
+   {
+      MemoryPool::Lease queue = pool.lease(pool.available());
+      ASSERT_EQ(queue.bytes(), 900u);
+      ASSERT_EQ(pool.leased(), 1000u);
+   }
+   ASSERT_EQ(pool.available(), 900u);
+
+   // moving transfers the ownership
+   MemoryPool::Lease moved(std::move(merge));
+   ASSERT_EQ(merge.bytes(), 0u);
+   ASSERT_EQ(moved.bytes(), 100u);
+
+   merge = pool.lease(200);
+   moved = std::move(merge);
+   ASSERT_EQ(pool.leased(), 200u);
+
+   moved.release();
+   ASSERT_EQ(pool.available(), 1000u);
+   ASSERT_EQ(pool.peak(), 1000u);
+}
+
+TEST(TestMemoryPool, minimum) {
+   MemoryPool pool(1000);
+
+   // a reserve guarantees the minimum of a consumer taking what is left
+   MemoryPool::Lease reserve = pool.lease(100);
+   MemoryPool::Lease greedy = pool.lease(pool.available());
+   ASSERT_THROW(pool.lease(pool.available(), 100), std::length_error);
+
+   reserve.release();
+   MemoryPool::Lease sorter = pool.lease(pool.available(), 100);
+   ASSERT_EQ(sorter.bytes(), 100u);
+
+   // requests below the minimum fail even if the budget suffices
+   sorter.release();
+   ASSERT_THROW(pool.lease(50, 100), std::length_error);
+   ASSERT_EQ(pool.leased(), 900u);
+}
+
+TEST(TestMemoryPool, sorterMemoryAfterSort) {
+   // fits into a single run: data stays in RAM
+   ASSERT_EQ(MemoryPool::sorterMemoryAfterSort(50, 100, 10), 50u);
+   // several runs: only the merge buffers remain
+   ASSERT_EQ(MemoryPool::sorterMemoryAfterSort(500, 100, 10), 10u);
+}
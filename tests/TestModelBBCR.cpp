@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @brief Tests for ModelBBCR
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <iostream>
+
+#include <Token.hpp>
+#include "../models/ModelBBCR.hpp"
+
+/**
+ * Every alpha and gamma edge creates a vertex, i.e. emits one non-query token;
+ * with an offset, uniformly selected endpoints add further non-query tokens
+ */
+static void check_mode_frequencies(double alpha, double beta, bool beta_runs, double offset) {
+   constexpr uint64_t edges = 200000;
+   ModelBBCR<> model(edges, 10, 10, alpha, beta, offset, offset, 1 << 24, beta_runs);
+
+   uint64_t tokens = 0, non_queries = 0;
+   for(auto & sorter = model.sorter(); !sorter.empty(); ++sorter, ++tokens)
+      non_queries += !sorter->query();
+
+   ASSERT_EQ(tokens, 2 * edges);
+   if (offset) {
+      ASSERT_GT(non_queries, (1.0 - beta) * edges + edges / 2);
+   } else {
+      ASSERT_NEAR(non_queries, (1.0 - beta) * edges, 0.02 * edges);
+   }
+}
+
+TEST(TestModelBBCR, modeFrequencies) {
+   check_mode_frequencies(0.1, 0.8, false, 0.0);
+   check_mode_frequencies(0.1, 0.8, true, 0.0);
+   check_mode_frequencies(0.3, 0.4, true, 0.0);
+   check_mode_frequencies(0.0, 1.0, true, 0.0);
+}
+
+TEST(TestModelBBCR, offsets) {
+   check_mode_frequencies(0.1, 0.8, false, 100.0);
+}
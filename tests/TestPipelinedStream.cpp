@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @brief Tests for SPSCQueue and PipelinedStream
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+#include <SPSCQueue.hpp>
+#include <PipelinedStream.hpp>
+
+//! Stream of 0, 1, ..., size-1; optionally throws instead of producing @p fail_at
+class CountingStream {
+   uint64_t _current;
+   const uint64_t _size;
+   const uint64_t _fail_at;
+
+public:
+   using value_type = uint64_t;
+
+   CountingStream(uint64_t size, uint64_t fail_at = uint64_t(-1))
+      : _current(0), _size(size), _fail_at(fail_at) {}
+
+   bool empty() const {return _current >= _size;}
+   const value_type & operator*() const {return _current;}
+   CountingStream & operator++() {
+      if (++_current == _fail_at)
+         throw std::runtime_error("failure in input stream");
+      return *this;
+   }
+};
+
+TEST(TestSPSCQueue, order) {
+   SPSCQueue<uint64_t> queue(5);
+   ASSERT_EQ(queue.capacity(), 8u);
+
+   const uint64_t n = 1000000;
+   std::thread producer([&] {
+      for(uint64_t i = 0; i < n; i++)
+         queue.push(i);
+   });
+
+   for(uint64_t i = 0; i < n; i++)
+      ASSERT_EQ(queue.pop(), i);
+
+   producer.join();
+   ASSERT_EQ(queue.size(), 0u);
+}
+
+TEST(TestPipelinedStream, sequence) {
+   for(uint64_t size : {0, 1, 99, 100, 101, 12345}) {
+      CountingStream input(size);
+      PipelinedStream<CountingStream> stream(input, 100, 3);
+
+      uint64_t expected = 0;
+      for(; !stream.empty(); ++stream, ++expected)
+         ASSERT_EQ(*stream, expected);
+
+      ASSERT_EQ(expected, size);
+      ASSERT_TRUE(input.empty());
+   }
+}
+
+TEST(TestPipelinedStream, chained) {
+   CountingStream input(100000);
+   PipelinedStream<CountingStream> first(input, 64, 2);
+   PipelinedStream<decltype(first)> second(first, 1000, 4);
+
+   uint64_t expected = 0;
+   for(; !second.empty(); ++second, ++expected)
+      ASSERT_EQ(*second, expected);
+   ASSERT_EQ(expected, 100000u);
+}
+
+TEST(TestPipelinedStream, abandoned) {
+   // the producer has to stop although the consumer leaves early
+   CountingStream input(1000000);
+   {
+      PipelinedStream<CountingStream> stream(input, 16, 2);
+      for(unsigned int i = 0; i < 100; i++, ++stream)
+         ASSERT_EQ(*stream, i);
+   }
+   ASSERT_FALSE(input.empty());
+}
+
+TEST(TestPipelinedStream, exception) {
+   CountingStream input(1000, 500);
+   PipelinedStream<CountingStream> stream(input, 64, 2);
+
+   uint64_t consumed = 0;
+   ASSERT_THROW({
+      for(; !stream.empty(); ++stream)
+         consumed++;
+   }, std::runtime_error);
+
+   // everything produced before the failure was handed over
+   ASSERT_EQ(consumed, 500u);
+   ASSERT_TRUE(stream.empty());
+}
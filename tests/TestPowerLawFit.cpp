@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief Tests for PowerLawFit
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <sstream>
+
+#include <PowerLawFit.hpp>
+
+TEST(TestPowerLawFit, hurwitzZeta) {
+   ASSERT_NEAR(PowerLawFit::hurwitzZeta(2.0, 1.0), M_PI * M_PI / 6, 1e-12);
+
+   // direct summation plus integral bound for the remainder
+   double sum = 0.0;
+   for(unsigned int k = 0; k < 1000000; k++)
+      sum += std::pow(k + 2.5, -3.0);
+   sum += std::pow(1000002.5, -2.0) / 2;
+   ASSERT_NEAR(PowerLawFit::hurwitzZeta(3.0, 2.5), sum, 1e-12);
+}
+
+TEST(TestPowerLawFit, syntheticTail) {
+   // uniform body below 5 and a discrete power-law tail with alpha = 2.5 from 5 on
+   std::mt19937_64 prng(1);
+   std::uniform_real_distribution<double> uniform;
+   std::map<uint64_t, uint64_t> histogram;
+
+   for(unsigned int i = 0; i < 20000; i++)
+      histogram[1 + uint64_t(uniform(prng) * 4)]++;
+
+   for(unsigned int i = 0; i < 50000; i++)
+      histogram[uint64_t(4.5 * std::pow(1.0 - uniform(prng), -1.0 / 1.5) + 0.5)]++;
+
+   PowerLawFit fit;
+   for(const auto & bin : histogram)
+      fit.push(bin.first, bin.second);
+   ASSERT_EQ(fit.totalCount(), 70000u);
+
+   const PowerLawFit::Result result = fit.fit();
+   ASSERT_TRUE(result.valid);
+   ASSERT_NEAR(result.alpha, 2.5, 0.1);
+   ASSERT_GE(result.x_min, 4u);
+   ASSERT_LE(result.x_min, 8u);
+   ASSERT_LT(result.ks_distance, 0.02);
+}
+
+TEST(TestPowerLawFit, outputs) {
+   PowerLawFit fit;
+   fit.push(1, 2);
+   fit.push(2, 1);
+   fit.push(10, 1);
+
+   std::ostringstream ccdf;
+   fit.writeCCDF(ccdf);
+   ASSERT_EQ(ccdf.str(), "1 1\n2 0.5\n10 0.25\n");
+
+   // one bin per decade: [1, 10) holds 9 integers, [10, 100) holds 90
+   std::ostringstream binned;
+   fit.writeLogBinned(binned, 1);
+   double lower, upper, center, density;
+   std::istringstream in(binned.str());
+
+   ASSERT_TRUE(in >> lower >> upper >> center >> density);
+   ASSERT_NEAR(lower, 1.0, 1e-9);
+   ASSERT_NEAR(density, 0.75 / 9, 1e-6);
+
+   ASSERT_TRUE(in >> lower >> upper >> center >> density);
+   ASSERT_NEAR(lower, 10.0, 1e-9);
+   ASSERT_NEAR(density, 0.25 / 90, 1e-6);
+}
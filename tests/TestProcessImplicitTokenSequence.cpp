@@ -0,0 +1,90 @@
+/**
+ * @file
+ * @brief Tests for ProcessImplicitTokenSequence
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include <RandomInteger.hpp>
+#include <InitialCircle.hpp>
+#include <RegularVertexTokenStream.hpp>
+#include <StreamMerger.hpp>
+#include <ProcessTokenSequence.hpp>
+#include <ProcessImplicitTokenSequence.hpp>
+#include <stxxl/bits/stream/stream.h>
+
+class TestProcessImplicitTokenSequence : public ::testing::Test {
+protected:
+   using pq_type = std::priority_queue<Token64, std::vector<Token64>, Token64::ComparatorDesc>;
+
+   std::vector<Token64> _generateRandomTokens(const BAEdgeListLayout & layout, uint64_t vertices) {
+      std::vector<Token64> tokens;
+      for(uint64_t v = 0; v < vertices; v++) {
+         uint64_t idx = layout.firstIdxOfRandomVertex(v) + 1;
+         for(uint64_t e = 0; e < layout.edgesPerVertex(); e++, idx += 2)
+            tokens.emplace_back(true, RandomInteger<8>::randint(idx), idx);
+      }
+      std::sort(tokens.begin(), tokens.end());
+      return tokens;
+   }
+};
+
+/**
+ * Generate the same random tokens for the explicit and implicit
+ * pipeline and check that both produce the same edge list.
+ */
+TEST_F(TestProcessImplicitTokenSequence, equivalence) {
+   const uint64_t vertices = 1000 + RandomInteger<4>::randint(1000);
+   const uint64_t edges_per_vertex = 1 + RandomInteger<4>::randint(5);
+
+   const BAEdgeListLayout layout(2 * edges_per_vertex, edges_per_vertex);
+   auto random_tokens = _generateRandomTokens(layout, vertices);
+
+   std::vector<uint64_t> explicit_edge_list;
+   {
+      InitialCircle seed(layout.seedVertices());
+      RegularVertexTokenStream regular(layout.seedVertices(), layout.firstRandomIdx(), vertices, edges_per_vertex);
+      auto random = stxxl::stream::streamify(random_tokens.begin(), random_tokens.end());
+
+      Token64::ComparatorAsc comp;
+      StreamMerger<Token64, Token64::ComparatorAsc, decltype(regular), decltype(random), decltype(seed)>
+            merger(comp, regular, random, seed);
+
+      pq_type pq;
+      ProcessTokenSequence<decltype(merger), pq_type> process(merger, pq);
+      for(; !process.empty(); ++process)
+         explicit_edge_list.push_back(*process);
+   }
+
+   ASSERT_EQ(explicit_edge_list.size(), layout.firstIdxOfRandomVertex(vertices));
+
+   // without and with lookahead window
+   for(uint64_t window_size : {0, 64}) {
+      std::vector<uint64_t> implicit_edge_list;
+      auto random = stxxl::stream::streamify(random_tokens.begin(), random_tokens.end());
+      pq_type pq;
+      ProcessImplicitTokenSequence<decltype(random), pq_type>
+            process(random, pq, layout, 0, layout.firstIdxOfRandomVertex(vertices), window_size);
+      for(; !process.empty(); ++process)
+         implicit_edge_list.push_back(*process);
+
+      ASSERT_EQ(explicit_edge_list, implicit_edge_list) << "window_size: " << window_size;
+      ASSERT_EQ(window_size > 0, process.windowHits() > 0);
+   }
+}
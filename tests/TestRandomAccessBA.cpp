@@ -0,0 +1,85 @@
+/**
+ * @file
+ * @brief Tests for RandomAccessBA
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include <RandomInteger.hpp>
+#include <RandomAccessBA.hpp>
+#include <ProcessImplicitTokenSequence.hpp>
+#include <stxxl/bits/stream/stream.h>
+
+class TestRandomAccessBA : public ::testing::Test {};
+
+/**
+ * Feed the positions queried by the random-access engine as tokens into
+ * the TFP loop; both have to produce the same edge list, also if the
+ * engine starts at an arbitrary position.
+ */
+TEST_F(TestRandomAccessBA, equivalenceToTFP) {
+   const uint64_t vertices = 1000 + RandomInteger<4>::randint(1000);
+   const uint64_t edges_per_vertex = 1 + RandomInteger<4>::randint(5);
+   const BAEdgeListLayout layout(2 * edges_per_vertex, edges_per_vertex);
+   const uint64_t end_idx = layout.firstIdxOfRandomVertex(vertices);
+
+   for(bool edge_dependencies : {false, true}) {
+      RandomAccessBA engine(layout, edge_dependencies, 1234);
+
+      std::vector<Token64> random_tokens;
+      for(uint64_t idx = layout.firstRandomIdx() + 1; idx < end_idx; idx += 2) {
+         const uint64_t query = engine.queryPosition(idx);
+         ASSERT_LT(query, idx);
+         random_tokens.emplace_back(true, query, idx);
+      }
+      std::sort(random_tokens.begin(), random_tokens.end());
+
+      std::vector<uint64_t> tfp_edge_list;
+      {
+         using pq_type = std::priority_queue<Token64, std::vector<Token64>, Token64::ComparatorDesc>;
+         auto random = stxxl::stream::streamify(random_tokens.begin(), random_tokens.end());
+         pq_type pq;
+         ProcessImplicitTokenSequence<decltype(random), pq_type> process(random, pq, layout, 0, end_idx);
+         for(; !process.empty(); ++process)
+            tfp_edge_list.push_back(*process);
+      }
+
+      const uint64_t first_idx = RandomInteger<8>::randint(end_idx);
+      RandomAccessBA::Stream stream(engine, first_idx, end_idx);
+      for(uint64_t idx = first_idx; idx < end_idx; idx++, ++stream) {
+         ASSERT_FALSE(stream.empty());
+         ASSERT_EQ(tfp_edge_list[idx], *stream) << "idx: " << idx;
+         ASSERT_EQ(tfp_edge_list[idx], engine.vertex(idx));
+      }
+      ASSERT_TRUE(stream.empty());
+   }
+}
+
+TEST_F(TestRandomAccessBA, seeds) {
+   const BAEdgeListLayout layout(8, 4);
+   RandomAccessBA a(layout, true, 1), b(layout, true, 1), c(layout, true, 2);
+
+   uint64_t differences = 0;
+   for(uint64_t e = 100; e < 10000; e++) {
+      ASSERT_EQ(a.edge(e), b.edge(e));
+      differences += (a.edge(e) != c.edge(e));
+   }
+
+   ASSERT_GT(differences, 1000u);
+}
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief Tests for RandomBatch and RandomInteger
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <RandomInteger.hpp>
+
+static void lanesMatchReference(bool allow_avx2) {
+   // scalar xoshiro256++ seeded like the lanes of RandomBatch
+   uint64_t seed = 1234;
+   auto splitmix64 = [&seed] () {
+      uint64_t z = (seed += 0x9e3779b97f4a7c15llu);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9llu;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebllu;
+      return z ^ (z >> 31);
+   };
+   auto rotl = [] (uint64_t x, int k) {return (x << k) | (x >> (64 - k));};
+
+   constexpr size_t lanes = RandomBatch::lanes;
+   uint64_t state[4][lanes];
+   for(unsigned int w = 0; w < 4; w++)
+      for(size_t l = 0; l < lanes; l++)
+         state[w][l] = splitmix64();
+
+   RandomBatch random(1234, allow_avx2);
+   ASSERT_EQ(random.usesAVX2(), allow_avx2 && RandomBatch::avx2Supported());
+   std::vector<uint64_t> batch(3 * RandomBatch::buffer_size);
+   random.fill(batch.data(), batch.size());
+
+   // the constructor consumed the first buffer_size words
+   for(size_t i = 0; i < RandomBatch::buffer_size + batch.size(); i++) {
+      const size_t l = i % lanes;
+      uint64_t expected;
+      {
+         uint64_t & s0 = state[0][l], & s1 = state[1][l], & s2 = state[2][l], & s3 = state[3][l];
+         expected = rotl(s0 + s3, 23) + s0;
+         const uint64_t t = s1 << 17;
+         s2 ^= s0; s3 ^= s1; s1 ^= s2; s0 ^= s3; s2 ^= t;
+         s3 = rotl(s3, 45);
+      }
+
+      if (i >= RandomBatch::buffer_size) {
+         ASSERT_EQ(batch[i - RandomBatch::buffer_size], expected) << "word " << i;
+      }
+   }
+}
+
+TEST(TestRandomInteger, lanesMatchReferenceScalar) {
+   lanesMatchReference(false);
+}
+
+TEST(TestRandomInteger, lanesMatchReferenceAVX2) {
+   // falls back to the scalar path if the CPU does not support AVX2
+   lanesMatchReference(true);
+}
+
+TEST(TestRandomInteger, bounded) {
+   RandomBatch random(1);
+
+   // small bound: uniformity
+   constexpr uint64_t bins = 10;
+   constexpr uint64_t samples = 1000000;
+   std::vector<uint64_t> counts(bins);
+   for(uint64_t i = 0; i < samples; i++)
+      counts.at(random(bins))++;
+   for(auto c : counts)
+      ASSERT_NEAR(c, samples / bins, 0.02 * samples / bins);
+
+   // batched with increasing bounds; large bounds exercise the rejection threshold
+   std::vector<uint64_t> values(1000);
+   random.fillBounded(values.data(), values.size(), 1, 3);
+   for(uint64_t i = 0; i < values.size(); i++)
+      ASSERT_LT(values[i], 1 + 3 * i);
+
+   const uint64_t large = (1llu << 63) + 12345;
+   random.fillBounded(values.data(), values.size(), large);
+   uint64_t upper_half = 0;
+   for(auto v : values) {
+      ASSERT_LT(v, large);
+      upper_half += (v >= large / 2);
+   }
+   ASSERT_NEAR(upper_half, values.size() / 2, 0.1 * values.size());
+
+   for(unsigned int i = 0; i < 1000; i++) {
+      const double u = random.uniform();
+      ASSERT_GE(u, 0.0);
+      ASSERT_LT(u, 1.0);
+   }
+}
@@ -1,6 +1,6 @@
 /**
  * @file
- * @brief Tests for StreamMerger
+ * @brief Tests for ReservoirSampling
  * @author Manuel Penschuck
  * @copyright
  * Licensed under the Apache License, Version 2.0 (the "License");
@@ -54,8 +54,140 @@ TEST_F(TestReservoirSampling, Uniformity) {
     // verify distribution
     ASSERT_EQ(samples, reservoir_size);
     std::vector<uint32_t> sorted_bins(bins);
+    std::sort(sorted_bins.begin(), sorted_bins.end());
 
     ASSERT_NEAR(sorted_bins.front(), avg_samples_in_bucket, 0.2*avg_samples_in_bucket);
     ASSERT_NEAR(sorted_bins.back(), avg_samples_in_bucket, 0.2*avg_samples_in_bucket);
     ASSERT_NEAR(sorted_bins[sorted_bins.size()/2], avg_samples_in_bucket, 0.05*avg_samples_in_bucket);
-}
\ No newline at end of file
+}
+TEST_F(TestReservoirSampling, InclusionProbability) {
+    // every element has to be sampled with probability k/n, regardless of
+    // whether it is pushed individually or in bulk
+    constexpr uint64_t elements = 20;
+    constexpr uint64_t reservoir_size = 3;
+    constexpr uint64_t repetitions = 100000;
+
+    std::vector<uint64_t> input(elements);
+    for(uint64_t i = 0; i < elements; i++)
+        input[i] = i;
+
+    std::vector<uint64_t> single(elements), bulk(elements);
+    for(uint64_t rep = 0; rep < repetitions; rep++) {
+        ReservoirSampling<uint64_t> res_single(reservoir_size);
+        for(auto x : input)
+            res_single.push(x);
+        for(auto x : res_single)
+            single[x]++;
+
+        ReservoirSampling<uint64_t> res_bulk(reservoir_size);
+        res_bulk.push(input.begin(), input.begin() + 7);
+        res_bulk.push(input.begin() + 7, input.end());
+        ASSERT_EQ(res_bulk.elementsPushed(), elements);
+        for(auto x : res_bulk)
+            bulk[x]++;
+    }
+
+    const double expected = double(repetitions) * reservoir_size / elements;
+    for(uint64_t i = 0; i < elements; i++) {
+        EXPECT_NEAR(single[i], expected, 0.04 * expected) << "element " << i;
+        EXPECT_NEAR(bulk[i], expected, 0.04 * expected) << "element " << i;
+    }
+}
+
+TEST_F(TestReservoirSampling, Skip) {
+    // skipping rejected elements has to keep the element count consistent
+    ReservoirSampling<uint64_t> res(16);
+    uint64_t i = 0;
+    for(; i < 16; i++)
+        res.push(i);
+
+    while(i < (1llu << 40)) {
+        const uint64_t skip = res.skip();
+        res.skip(skip);
+        i += skip;
+
+        ASSERT_EQ(res.skip(), 0u);
+        res.push(i++);
+        ASSERT_EQ(res.elementsPushed(), i);
+    }
+
+    // the last sampled element has to be stored; the sample is dominated by late elements
+    std::sort(res.begin(), res.end());
+    ASSERT_EQ(*(res.end() - 1), i - 1);
+    ASSERT_GT(*res.begin(), 1llu << 30);
+}
+
+TEST_F(TestReservoirSampling, Merge) {
+    // shards of different sizes are sampled by one thread each and merged;
+    // then the stream continues on the merged reservoir
+    constexpr uint64_t shards[] = {5, 30, 1, 24};
+    constexpr uint64_t tail = 20;
+    constexpr uint64_t elements = 5 + 30 + 1 + 24 + tail;
+    constexpr uint64_t reservoir_size = 4;
+    constexpr uint64_t repetitions = 50000;
+
+    std::vector<uint64_t> counts(elements);
+    #pragma omp parallel for
+    for(uint64_t rep = 0; rep < repetitions; rep++) {
+        std::vector<ReservoirSampling<uint64_t>> reservoirs(4, ReservoirSampling<uint64_t>(reservoir_size));
+        uint64_t element = 0;
+        for(unsigned int s = 0; s < 4; s++)
+            for(uint64_t i = 0; i < shards[s]; i++)
+                reservoirs[s].push(element++);
+
+        for(unsigned int s = 1; s < 4; s++)
+            reservoirs[0].merge(reservoirs[s]);
+
+        for(; element < elements; element++)
+            reservoirs[0].push(element);
+
+        EXPECT_EQ(reservoirs[0].elementsPushed(), elements);
+        EXPECT_EQ(std::distance(reservoirs[0].begin(), reservoirs[0].end()), reservoir_size);
+
+        for(auto x : reservoirs[0])
+            #pragma omp atomic
+            counts[x]++;
+    }
+
+    const double expected = double(repetitions) * reservoir_size / elements;
+    for(uint64_t i = 0; i < elements; i++)
+        EXPECT_NEAR(counts[i], expected, 0.1 * expected) << "element " << i;
+}
+
+TEST_F(TestReservoirSampling, Weighted) {
+    // with a single slot, each element is drawn proportionally to its weight;
+    // splitting the stream and merging must not change the distribution
+    constexpr uint64_t elements = 10;
+    constexpr uint64_t repetitions = 100000;
+
+    std::vector<uint64_t> single(elements), merged(elements);
+    for(uint64_t rep = 0; rep < repetitions; rep++) {
+        WeightedReservoirSampling<uint64_t> whole(1), first(1), second(1);
+        for(uint64_t i = 0; i < elements; i++) {
+            whole.push(i, i + 1);
+            (i % 3 ? first : second).push(i, i + 1);
+        }
+        first.merge(second);
+        ASSERT_DOUBLE_EQ(first.totalWeight(), 55.0);
+
+        single[whole.begin()->second]++;
+        merged[first.begin()->second]++;
+    }
+
+    for(uint64_t i = 0; i < elements; i++) {
+        const double expected = double(repetitions) * (i + 1) / 55;
+        EXPECT_NEAR(single[i], expected, 0.05 * expected + 50) << "element " << i;
+        EXPECT_NEAR(merged[i], expected, 0.05 * expected + 50) << "element " << i;
+    }
+
+    // larger reservoir: heavy elements have to dominate the sample
+    WeightedReservoirSampling<uint64_t> res(100);
+    for(uint64_t i = 0; i < 1000000; i++)
+        res.push(i, (i % 1000 == 0) ? 1e6 : 1.0);
+
+    ASSERT_EQ(res.size(), 100u);
+    unsigned int heavy = 0;
+    for(const auto & entry : res)
+        heavy += (entry.second % 1000 == 0);
+    ASSERT_GT(heavy, 90u);
+}
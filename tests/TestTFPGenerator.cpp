@@ -0,0 +1,73 @@
+/**
+ * @file
+ * @brief Tests for the generator library interface
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <TFPGenerator.hpp>
+
+class TestTFPGenerator : public ::testing::Test {};
+
+TEST_F(TestTFPGenerator, baBlocks) {
+   BAParameters params;
+   params.number_of_vertices = 10000;
+   params.edges_per_vertex = 3;
+
+   auto source = EdgeSource::createBA(params);
+
+   std::vector<EdgeSource::edge_type> block;
+   uint64_t edges = 0;
+   while(source->nextBlock(block, 1000)) {
+      ASSERT_LE(block.size(), 1000u);
+      for(const auto & edge : block) {
+         // random vertex (or seed vertex) links to an earlier vertex
+         const uint64_t max_vertex = std::max<uint64_t>(edge.first, 2 * params.edges_per_vertex - 1);
+         ASSERT_LE(edge.second, max_vertex);
+      }
+      edges += block.size();
+   }
+
+   ASSERT_EQ(edges, 2 * params.edges_per_vertex + params.number_of_vertices * params.edges_per_vertex);
+   ASSERT_EQ(edges, source->edgesProduced());
+}
+
+TEST_F(TestTFPGenerator, bbcrCallbackFiltered) {
+   BBCRParameters params;
+   params.number_of_edges = 20000;
+   params.filter_self_loops = true;
+   params.filter_multi_edges = true;
+
+   std::vector<EdgeSource::edge_type> edges;
+   const uint64_t n = EdgeSource::createBBCR(params)->forEach(
+      [&edges] (const EdgeSource::edge_type* begin, const EdgeSource::edge_type* end) {
+         edges.insert(edges.end(), begin, end);
+      }, 999);
+
+   ASSERT_EQ(n, edges.size());
+   ASSERT_GT(n, 0u);
+   ASSERT_LE(n, params.number_of_seed_vertices + params.number_of_edges);
+
+   // sorted without self-loops and multi-edges
+   for(size_t i = 0; i < edges.size(); i++) {
+      ASSERT_NE(edges[i].first, edges[i].second);
+      if (i) {
+         ASSERT_LT(edges[i-1], edges[i]);
+      }
+   }
+}
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Tests for TextEdgeWriter and DecimalFormat
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <RandomInteger.hpp>
+#include <TextEdgeWriter.hpp>
+
+class TestTextEdgeWriter : public ::testing::Test {
+protected:
+   const std::string _path = "test_text_edge_writer.txt";
+
+   using edge_list = std::vector<TextEdgeWriter::edge_type>;
+
+   edge_list _randomEdges(uint64_t n, uint64_t max_vertex) {
+      edge_list edges;
+      for(uint64_t i = 0; i < n; i++)
+         edges.emplace_back(RandomInteger<8>::randint(max_vertex), RandomInteger<8>::randint(max_vertex));
+      return edges;
+   }
+
+   //! Write edges with tiny blocks to exercise several batches
+   std::string _write(const edge_list & edges, TextEdgeWriter::Format format) {
+      {
+         TextEdgeWriter writer(_path, format, 7);
+         for(const auto & e : edges)
+            writer(e.first, e.second);
+         writer.close();
+      }
+
+      std::ifstream in(_path);
+      std::stringstream ss;
+      ss << in.rdbuf();
+      std::remove(_path.c_str());
+      return ss.str();
+   }
+};
+
+TEST_F(TestTextEdgeWriter, decimal) {
+   char buffer[24];
+   for(uint64_t x : {uint64_t(0), uint64_t(9), uint64_t(10), uint64_t(99), uint64_t(100), uint64_t(12345),
+                     uint64_t(1000000007), std::numeric_limits<uint64_t>::max()}) {
+      *DecimalFormat::write(buffer, x) = 0;
+      ASSERT_EQ(std::to_string(x), std::string(buffer));
+   }
+
+   for(unsigned int i = 0; i < 10000; i++) {
+      const uint64_t x = RandomInteger<8>::randint(uint64_t(1) << (i % 64));
+      *DecimalFormat::write(buffer, x) = 0;
+      ASSERT_EQ(std::to_string(x), std::string(buffer));
+   }
+}
+
+TEST_F(TestTextEdgeWriter, edgeListAndMatrixMarket) {
+   const auto edges = _randomEdges(1000, 200);
+
+   std::stringstream edge_list, mm_body;
+   uint64_t max_vertex = 0;
+   for(const auto & e : edges) {
+      edge_list << e.first << " " << e.second << "\n";
+      mm_body << (e.first + 1) << " " << (e.second + 1) << "\n";
+      max_vertex = std::max(max_vertex, std::max(e.first, e.second));
+   }
+
+   ASSERT_EQ(edge_list.str(), _write(edges, TextEdgeWriter::EdgeList));
+
+   std::stringstream mm(_write(edges, TextEdgeWriter::MatrixMarket));
+   std::string line;
+   std::getline(mm, line);
+   ASSERT_EQ(line, "%%MatrixMarket matrix coordinate pattern general");
+
+   uint64_t rows, cols, nnz;
+   mm >> rows >> cols >> nnz;
+   ASSERT_EQ(rows, max_vertex + 1);
+   ASSERT_EQ(cols, max_vertex + 1);
+   ASSERT_EQ(nnz, edges.size());
+   std::getline(mm, line);
+
+   std::stringstream rest;
+   rest << mm.rdbuf();
+   ASSERT_EQ(mm_body.str(), rest.str());
+}
+
+TEST_F(TestTextEdgeWriter, metis) {
+   const auto edges = _randomEdges(1000, 300);
+
+   uint64_t n = 0;
+   std::vector<std::set<uint64_t>> adjacency(300);
+   for(const auto & e : edges) {
+      n = std::max(n, std::max(e.first, e.second) + 1);
+      if (e.first == e.second) continue;
+      adjacency[e.first].insert(e.second + 1);
+      adjacency[e.second].insert(e.first + 1);
+   }
+
+   uint64_t m = 0;
+   std::stringstream expected;
+   for(uint64_t u = 0; u < n; u++) {
+      bool first = true;
+      for(auto v : adjacency[u]) {
+         expected << (first ? "" : " ") << v;
+         first = false;
+      }
+      expected << "\n";
+      m += adjacency[u].size();
+   }
+
+   const std::string header = std::to_string(n) + " " + std::to_string(m / 2) + "\n";
+   ASSERT_EQ(header + expected.str(), _write(edges, TextEdgeWriter::Metis));
+}
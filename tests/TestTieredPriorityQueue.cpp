@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief Tests for TieredPriorityQueue
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <queue>
+#include <vector>
+
+#include <RandomInteger.hpp>
+#include <TieredPriorityQueue.hpp>
+#include <CompressedTokenRun.hpp>
+
+class TestTieredPriorityQueue : public ::testing::Test {
+protected:
+   template <class PQ>
+   void _monotoneWorkload(PQ & pq);
+};
+
+/**
+ * Simulate a TFP-like monotone workload, in which each popped token
+ * causes pushes of a random number of tokens with larger ids spread
+ * over several orders of magnitude. The queue is configured with tiny
+ * tiers such that all of them (including the overflow) are exercised;
+ * the sequence of popped tokens has to match a reference PQ.
+ */
+template <class PQ>
+void TestTieredPriorityQueue::_monotoneWorkload(PQ & pq) {
+   using reference_type = std::priority_queue<Token64, std::vector<Token64>, Token64::ComparatorDesc>;
+   reference_type reference;
+
+   uint64_t value = 0;
+   auto push = [&] (uint64_t id) {
+      Token64 token(false, id, value++);
+      pq.push(token);
+      reference.push(token);
+   };
+
+   for(unsigned int i = 0; i < 100; i++)
+      push(RandomInteger<8>::randint(1000));
+
+   uint64_t pops = 0;
+   while(!reference.empty()) {
+      ASSERT_FALSE(pq.empty());
+      ASSERT_EQ(reference.size(), pq.size());
+
+      const Token64 expected = reference.top();
+      ASSERT_EQ(expected.id(), pq.top().id());
+      ASSERT_EQ(expected.value(), pq.top().value());
+      reference.pop();
+      pq.pop();
+
+      if (++pops < 20000) {
+         for(unsigned int i = RandomInteger<4>::randint(3); i; i--) {
+            const uint64_t distance = 1 + RandomInteger<8>::randint(uint64_t(1) << RandomInteger<4>::randint(16));
+            push(expected.id() + distance);
+         }
+      }
+   }
+
+   ASSERT_TRUE(pq.empty());
+   ASSERT_GT(pq.farTokensLoaded(), 0u);
+   ASSERT_GT(pq.overflowTokensLoaded(), 0u);
+}
+
+TEST_F(TestTieredPriorityQueue, monotoneWorkload) {
+   using pq_type = TieredPriorityQueue<Token64, ExternalTokenBucket<Token64, 4096>>;
+   pq_type pq(1 << 20, pq_type::externalBytes(8), 4, 4, 8);
+   _monotoneWorkload(pq);
+
+   // the external buckets can cover all keys pushed, so no token is read from the overflow twice
+   ASSERT_EQ(pq.overflowTokensRespilled(), 0u);
+}
+
+TEST_F(TestTieredPriorityQueue, monotoneWorkloadCompressed) {
+   // buffers of 1024 tokens, i.e. several chunks per bucket
+   using bucket_type = CompressedTokenBucket<Token64, 4096>;
+   using pq_type = TieredPriorityQueue<Token64, bucket_type>;
+   pq_type pq(1 << 20, pq_type::externalBytes(8, bucket_type::minimumBytes), 4, 4, 8);
+   _monotoneWorkload(pq);
+}
+
+TEST_F(TestTieredPriorityQueue, monotoneWorkloadCappedWidth) {
+   // the external buckets cover at most 16 keys, so the overflow is split in several stages
+   using pq_type = TieredPriorityQueue<Token64, ExternalTokenBucket<Token64, 4096>>;
+   pq_type pq(pq_type::minimumRamBytes(4, 4), pq_type::externalBytes(8), 4, 4, 8);
+   ASSERT_EQ(pq.maxFarWidth(), 16u);
+   _monotoneWorkload(pq);
+   ASSERT_GT(pq.overflowStages(), 1u);
+   ASSERT_GT(pq.overflowTokensRespilled(), 0u);
+   ASSERT_LT(pq.overflowTokensRespilled(), pq.overflowTokensLoaded());
+}
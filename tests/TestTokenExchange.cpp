@@ -0,0 +1,78 @@
+/**
+ * @file
+ * @brief Tests for TokenExchange
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include <TokenExchange.hpp>
+
+class TestTokenExchange : public ::testing::Test {
+protected:
+   const std::vector<uint64_t> _boundaries {0, 100, 200};
+
+   struct Sink {
+      std::vector<Token64> tokens;
+      void push(const Token64 & t) {tokens.push_back(t);}
+   };
+};
+
+TEST_F(TestTokenExchange, roundtrip) {
+   TokenExchange sender(".", "test_exchange", 1, _boundaries);
+   TokenExchange receiver(".", "test_exchange", 0, _boundaries);
+
+   sender.open(TokenExchange::Query, 0, 1);
+   for(uint64_t i = 0; i < 10; i++)
+      sender.send(TokenExchange::Query, Token64(true, i, 100 + i));
+   ASSERT_EQ(sender.close(TokenExchange::Query), 10u);
+
+   Sink sink;
+   ASSERT_EQ(receiver.receive(TokenExchange::Query, 1, sink), 10u);
+   ASSERT_EQ(sink.tokens.size(), 10u);
+   ASSERT_EQ(sink.tokens[3].id(), 3u);
+   ASSERT_EQ(sink.tokens[3].value(), 103u);
+}
+
+TEST_F(TestTokenExchange, staleFilesAndTimeout) {
+   // a file of a crashed earlier run with the same job id ...
+   {
+      TokenExchange crashed(".", "test_exchange_stale", 1, _boundaries);
+      crashed.open(TokenExchange::Query, 0, 1);
+      crashed.send(TokenExchange::Query, Token64(true, 1, 101));
+      crashed.close(TokenExchange::Query);
+   }
+
+   // ... is removed once its sender restarts, so the receiver waits for the new one
+   TokenExchange sender(".", "test_exchange_stale", 1, _boundaries);
+   TokenExchange receiver(".", "test_exchange_stale", 0, _boundaries, std::chrono::seconds(1));
+
+   Sink sink;
+   ASSERT_THROW(receiver.receive(TokenExchange::Query, 1, sink), stxxl::io_error);
+   ASSERT_TRUE(sink.tokens.empty());
+
+   // files of another job are not touched
+   TokenExchange other(".", "test_exchange_other", 1, _boundaries);
+   other.open(TokenExchange::Query, 0, 1);
+   other.close(TokenExchange::Query);
+   ASSERT_THROW(receiver.receive(TokenExchange::Query, 1, sink), stxxl::io_error);
+
+   TokenExchange other_receiver(".", "test_exchange_other", 0, _boundaries);
+   ASSERT_EQ(other_receiver.receive(TokenExchange::Query, 1, sink), 0u);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file
+ * @brief Tests for ExternalTriangleCount
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <set>
+#include <vector>
+
+#include <RandomInteger.hpp>
+#include <TriangleCount.hpp>
+
+TEST(TestTriangleCount, smallGraph) {
+   // K4 on {0, 1, 2, 3} plus pendant vertex 4, a duplicate and a self-loop
+   ExternalTriangleCount triangles(1 << 24);
+   for(uint64_t u = 0; u < 4; u++)
+      for(uint64_t v = u + 1; v < 4; v++)
+         triangles(u, v);
+   triangles(4, 3);
+   triangles(1, 0);
+   triangles(2, 2);
+   triangles.compute();
+
+   ASSERT_EQ(triangles.numberOfVertices(), 5u);
+   ASSERT_EQ(triangles.numberOfEdges(), 7u);
+   ASSERT_EQ(triangles.numberOfDuplicates(), 1u);
+   ASSERT_EQ(triangles.numberOfLoops(), 1u);
+   ASSERT_EQ(triangles.numberOfTriangles(), 4u);
+
+   // wedges: 3 * 3 (vertices 0..2) + 6 (vertex 3)
+   ASSERT_EQ(triangles.numberOfWedges(), 15u);
+   ASSERT_DOUBLE_EQ(triangles.globalClustering(), 12.0 / 15);
+   ASSERT_DOUBLE_EQ(triangles.averageLocalClustering(), (3.0 + 0.5) / 4);
+   ASSERT_DOUBLE_EQ(triangles.averageLocalClusteringAllVertices(), (3.0 + 0.5) / 5);
+
+   ASSERT_EQ(triangles.spectrum().at(3).number_of_vertices, 3u);
+   ASSERT_EQ(triangles.spectrum().at(4).number_of_vertices, 1u);
+}
+
+TEST(TestTriangleCount, matchesNaiveCount) {
+   const uint64_t n = 200;
+   std::set<std::pair<uint64_t, uint64_t>> edges;
+   ExternalTriangleCount triangles(1 << 24);
+
+   // dense core plus sparse fringe, so the orientation matters
+   for(unsigned int i = 0; i < 3000; i++) {
+      const uint64_t u = RandomInteger<8>::randint(i % 2 ? 30 : n);
+      const uint64_t v = RandomInteger<8>::randint(n);
+      triangles(u, v);
+      if (u != v)
+         edges.emplace(std::min(u, v), std::max(u, v));
+   }
+   triangles.compute();
+
+   std::vector<std::set<uint64_t>> neighbours(n);
+   for(const auto & edge : edges) {
+      neighbours[edge.first].insert(edge.second);
+      neighbours[edge.second].insert(edge.first);
+   }
+
+   uint64_t naive = 0;
+   for(const auto & edge : edges)
+      for(const auto w : neighbours[edge.second])
+         naive += (w > edge.second && neighbours[edge.first].count(w));
+
+   ASSERT_EQ(triangles.numberOfEdges(), edges.size());
+   ASSERT_EQ(triangles.numberOfTriangles(), naive);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file
+ * @brief Tests for UringWriter and UringValueStream
+ * @author Manuel Penschuck
+ * @copyright
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * @copyright
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <UringFile.hpp>
+
+#ifdef TFP_HAVE_IO_URING
+
+class TestUringFile : public ::testing::Test {
+protected:
+   const std::string _path = "test_uring_file.bin";
+
+   void TearDown() override {
+      std::remove(_path.c_str());
+   }
+
+   std::vector<char> _readFile() {
+      std::ifstream in(_path, std::ios::binary);
+      return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+   }
+
+   // values of 5 bytes (as uint40) straddle the 4 KiB blocks
+   using value_type = std::array<uint8_t, 5>;
+
+   static value_type _value(uint64_t i) {
+      value_type value;
+      for(unsigned int j = 0; j < value.size(); j++)
+         value[j] = uint8_t((i * 0x9e3779b9llu) >> (8 * j));
+      return value;
+   }
+
+   void _roundtrip(uint64_t n, unsigned int queue_depth) {
+      std::vector<char> expected;
+      {
+         UringWriter writer(_path, 4096, queue_depth);
+         for(uint64_t i = 0; i < n; i++) {
+            const value_type value = _value(i);
+            writer.write(&value, sizeof(value));
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            expected.insert(expected.end(), bytes, bytes + sizeof(value));
+         }
+         ASSERT_EQ(writer.bytesWritten(), expected.size());
+         writer.close();
+      }
+
+      ASSERT_EQ(_readFile(), expected);
+
+      UringValueStream<value_type> stream(_path, 4096, queue_depth);
+      ASSERT_EQ(stream.size(), n);
+
+      uint64_t i = 0;
+      for(; !stream.empty(); ++stream, ++i)
+         ASSERT_EQ(*stream, _value(i));
+      ASSERT_EQ(i, n);
+   }
+};
+
+TEST_F(TestUringFile, roundtrip) {
+   if (!IoUring::available())
+      return;
+
+   _roundtrip(0, 4);
+   _roundtrip(1, 4);
+   _roundtrip(4096, 1);
+   _roundtrip(100003, 8);
+}
+
+#endif
@@ -7,139 +7,129 @@
 #include <stxxl/vector>
 #include <stxxl/bits/common/uint_types.h>
 
-#include <GenericComparator.hpp>
-#include <DistributionCount.hpp>
 #include <FileDataType.hpp>
+#include <EdgeListReader.hpp>
+#include <CSRGraph.hpp>
 
-#include <list>
+#include <limits>
 #include <vector>
-#include <queue>
 
-using NodeT = uint64_t;
 using FileT = DefaultFileDataType::data_type;
-using AdjListT = std::vector<std::list<NodeT>>;
+using EdgeT = CSRDegreeCounter::edge_type;
+
+/**
+ * Read all files and pass their edges in blocks to the callback;
+ * returns the number of edges
+ */
+template <typename Callback>
+uint64_t read_edges(const std::vector<std::string> & filenames, Callback callback, bool verbose) {
+    constexpr size_t block_size = 1 << 20;
+    std::vector<EdgeT> block;
+    block.reserve(block_size);
+
+    uint64_t edges = 0;
+    for(auto & filename : filenames) {
+        bool out_edge = true;
+        uint64_t from = 0;
+
+        const uint64_t vertices = readEdgeListFile(filename, [&] (const FileT & node) {
+            if (out_edge) {
+                from = DefaultFileDataType::toInternal(node);
+            } else {
+                block.emplace_back(from, DefaultFileDataType::toInternal(node));
+                if (block.size() == block_size) {
+                    callback(block.data(), block.data() + block.size());
+                    block.clear();
+                }
+            }
+            out_edge = !out_edge;
+        });
+
+        // Print progress info
+        auto this_edges = vertices / 2;
+        edges += this_edges;
+        if (verbose)
+            std::cout << "Read " << this_edges << " edges from file " << filename << std::endl;
+    }
+
+    callback(block.data(), block.data() + block.size());
+    return edges;
+}
+
+template <typename NodeT>
+void bfs(const CSRGraph<NodeT> & graph) {
+    DirectionOptimizingBFS<NodeT> bfs(graph);
+    const uint64_t n = graph.numberOfVertices();
 
-void bfs(const AdjListT & adj) {
-    std::vector<bool> visited(adj.size());
     uint64_t number_components = 0;
     uint64_t vertices_visited = 0;
 
-    for(NodeT start = 0; start < adj.size(); start++) {
-        if (visited[start]) continue;
+    for(uint64_t start = 0; start < n; start++) {
+        if (bfs.visited(start)) continue;
         number_components++;
 
-        std::queue<NodeT> queue;
-        queue.push(start);
-
-        while(!queue.empty()) {
-            auto & current = queue.front();
-            if (!visited[current]) {
-                vertices_visited++;
-                visited[current] = true;
-                for(const auto & n : adj[current])
-                    if (!visited[n])
-                        queue.push(n);
-            }
-            queue.pop();
-        }
+        vertices_visited += bfs.run(NodeT(start));
 
-        if (vertices_visited == adj.size())
+        if (vertices_visited == n)
             break;
     }
 
     std::cout << "Number of components found: " << number_components << std::endl;
     std::cout << "Vertices visited: " << vertices_visited << std::endl;
+    std::cout << "BFS steps: " << bfs.topDownSteps() << " top-down, " << bfs.bottomUpSteps() << " bottom-up" << std::endl;
 
-    if (vertices_visited != adj.size()) {
+    if (vertices_visited != n) {
         std::cerr << "------- Unvisited Vertices ---------" << std::endl;
     }
 }
 
+//! Second pass, duplicate removal and BFS
+template <typename NodeT>
+void build_and_bfs(const std::vector<std::string> & filenames, const CSRDegreeCounter & degrees) {
+    CSRGraph<NodeT> graph(degrees);
+    read_edges(filenames, [&graph] (const EdgeT* begin, const EdgeT* end) {graph.fill(begin, end);}, false);
+
+    const uint64_t arcs_removed = graph.finish();
+    std::cout << "# Number of duplicated edges removed: " << arcs_removed << std::endl;
+    std::cout << "# CSR uses " << (8 * sizeof(NodeT)) << "-bit neighbour ids; "
+              << ((8 * (graph.numberOfVertices() + 1) + sizeof(NodeT) * graph.numberOfArcs()) >> 20) << " MiB" << std::endl;
+
+    bfs(graph);
+}
 
 int main(int argc, char* argv[]) {
     bool directed_graph = false;
+    bool io_uring = false;
     std::vector<std::string> filenames;
     std::string filename_out;
-    stxxl::uint64 adj_list_size;
+    stxxl::uint64 adj_list_size = 0;
     {
         stxxl::cmdline_parser cp;
         cp.set_author("Manuel Penschuck <manuel at ae.cs.uni-frankfurt.de>");
         cp.set_description("IM BFS implementation to study connectedness of small graphs");
         cp.add_flag('d', "directed", directed_graph, "Input is a directed edge list; default false");
         cp.add_param_stringlist("input-files", filenames, "Input files; if multiple files are given they are interpreted as concatenated");
+        cp.add_flag('u', "io-uring", io_uring, "Read input through io_uring instead of linuxaio (falls back if unavailable)");
         cp.add_bytes('n', "no-vertices", adj_list_size, "Number of vertices; give an upper bound; may speed up build of adj list");
         if (!cp.process(argc, argv)) return -1;
     }
 
     std::cout << "Using " << (8 * sizeof(DefaultFileDataType::data_type)) << "-bit unsinged integers for input" << std::endl;
     std::cout << "Underlying graph is " << (directed_graph?"DIRECTED":"UNdirected") << std::endl;
+    std::cout << "Using " << omp_get_max_threads() << " threads" << std::endl;
+    IOBackend::select(io_uring ? IOBackend::Uring : IOBackend::LinuxAIO);
 
+// Build CSR by a counting sort in two passes over the input
+    CSRDegreeCounter degrees(directed_graph, adj_list_size);
+    const uint64_t edges = read_edges(filenames, [&degrees] (const EdgeT* begin, const EdgeT* end) {degrees(begin, end);}, true);
 
-// Build adjacency list
-    AdjListT adj_list(adj_list_size);
-    size_t edges = 0;
-
-    // Input handling
-    NodeT max_vertex = 0;
-    for(auto & filename : filenames) {
-        // Open File as a STXXL vector
-        stxxl::linuxaio_file input_file(filename, stxxl::file::RDONLY | stxxl::file::DIRECT);
-        DefaultFileDataType::vector_type input_vector(&input_file);
-
-        // Copy file into adjacency list
-        bool out_edge = true;
-        NodeT from;
-        NodeT to;
-
-        for(auto node : typename DefaultFileDataType::vector_type::bufreader_type(input_vector)) {
-            if (out_edge) {
-                from = DefaultFileDataType::toInternal(node);
-            } else {
-                to = DefaultFileDataType::toInternal(node);
-
-                // compute maximal vertex
-                auto max = std::max(from, to);
-                max_vertex = std::max(max_vertex, max);
-
-                // ... and increase array size if it does not fit
-                if (max >= adj_list.size())
-                    adj_list.resize(std::max(adj_list.size() * 2, max+1));
-
-                // insert nodes into adj_list
-                adj_list[from].push_back(to);
-
-                if (!directed_graph) {
-                    adj_list[to].push_back(from);
-                }
-
-            }
-            out_edge = !out_edge;
-        }
-
-        // Print progress info
-        auto this_edges = input_vector.size() / 2;
-        edges += this_edges;
-        std::cout << "Read " << this_edges << " edges from file " << filename << std::endl;
-    }
-    std::cout << "# Number of vertices: " << (max_vertex+1) << std::endl;
+    std::cout << "# Number of vertices: " << degrees.numberOfVertices() << std::endl;
     std::cout << "# Number of edges: " << edges << std::endl;
 
-    adj_list.resize(max_vertex+1);
-    adj_list.shrink_to_fit();
-
-    // Remove duplicates in adj lists
-    {
-        uint64_t elements_removed = 0;
-        for(auto & a : adj_list) {
-            elements_removed += a.size();
-            a.sort();
-            a.unique();
-            elements_removed -= a.size();
-        }
-        std::cout << "# Number of duplicated edges removed: " << elements_removed << std::endl;
-    }
-
-    bfs(adj_list);
+    if (degrees.numberOfVertices() <= std::numeric_limits<uint32_t>::max())
+        build_and_bfs<uint32_t>(filenames, degrees);
+    else
+        build_and_bfs<uint64_t>(filenames, degrees);
 
     return 0;
-}
\ No newline at end of file
+}